@@ -0,0 +1,684 @@
+#include "Base.h"
+#include "MapManager.h"
+#include "AutoFindPathHelper.h"
+#include "ComponentHelper.h"
+#include "LandmarkHelper.h"
+#include "NavMeshHelper.h"
+#include "TabFileReader.h"
+#include <algorithm>
+#include <queue>
+#include <random>
+
+// 寻路基准测试：从StageConfig.tab列出的每张关卡地图中取出gameObjectLayer的通行数据，
+// 生成固定种子的查询集合，统计AutoFindPathHelper每次查询的耗时、扩展节点数、路径长度和内存分配次数；
+// 测试之前先在每张地图上检查ComponentHelper增量维护的连通区域，有不一致时返回1
+// 用法：PathBenchmark [资源目录] [每组查询数] [随机种子] [每张地图连通区域检查的修改次数]
+
+const int DEFAULT_QUERY_COUNT_PER_SET = 200;
+const unsigned int DEFAULT_RANDOM_SEED = 20150601;
+const int MAX_GENERATE_ATTEMPT_COUNT_PER_QUERY = 1000;
+const int MAX_SHORT_QUERY_DISTANCE = 10;
+const int COMPONENT_ID_NONE = -1;
+const int DEFAULT_COMPONENT_CHECK_EDIT_COUNT = 5000;
+const int COMPONENT_CHECK_QUERY_COUNT_PER_EDIT = 30;
+const int MAX_COMPONENT_CHECK_FOOTPRINT_SIZE = 4;
+
+static long long g_allocationCount = 0;
+
+void* operator new(size_t size)
+{
+    g_allocationCount++;
+
+    void* memory = malloc(size > 0 ? size : 1);
+    if (!memory)
+    {
+        throw bad_alloc();
+    }
+
+    return memory;
+}
+
+void operator delete(void* memory)
+{
+    free(memory);
+}
+
+enum class QuerySetType
+{
+    Short,
+    Long,
+    Unreachable,
+    IntoBuildingFootprint,
+    Count
+};
+
+static const char* s_querySetTypeToString[] =
+{
+    "short",
+    "long",
+    "unreachable",
+    "footprint",
+};
+
+struct PathQuery
+{
+    int startTileIndex = 0;
+    int endTileIndex = 0;
+    bool isEndTileNodePassable = false;
+};
+
+struct BenchmarkMap
+{
+    string mapName;
+    NavigationGrid navigationGrid;
+    vector<int> componentIDList;
+};
+
+struct QuerySetReport
+{
+    int queryCount = 0;
+    int foundCount = 0;
+    double totalMicroseconds = 0.0;
+    vector<double> microsecondsList;
+    long long totalExpandedNodeCount = 0;
+    long long totalPathTileCount = 0;
+    long long totalPathWeight = 0;
+    long long totalAllocationCount = 0;
+};
+
+static double g_microsecondsPerTick = 0.0;
+
+static long long getTick()
+{
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+
+    return counter.QuadPart;
+}
+
+static bool loadBenchmarkMap(const string& mapName, BenchmarkMap& benchmarkMap)
+{
+    bool result = false;
+
+    auto mapInfo = TMXMapInfo::create(mapName);
+    if (!mapInfo)
+    {
+        return result;
+    }
+
+    for (auto layerInfo : mapInfo->getLayers())
+    {
+        if (layerInfo->_name != "gameObjectLayer")
+        {
+            continue;
+        }
+
+        // 与MapManager::initTileNodeTable使用相同的下标、通行规则和格子坐标
+        auto mapSize = layerInfo->_layerSize;
+        auto tileSize = mapInfo->getTileSize();
+        auto& navigationGrid = benchmarkMap.navigationGrid;
+        navigationGrid.columnCount = (int)layerInfo->_layerSize.width;
+        navigationGrid.rowCount = (int)layerInfo->_layerSize.height;
+        navigationGrid.tileNodeList.assign(navigationGrid.columnCount * navigationGrid.rowCount, TileNode());
+        navigationGrid.passableList.assign(navigationGrid.columnCount * navigationGrid.rowCount, true);
+
+        for (int columnIndex = 0; columnIndex < navigationGrid.columnCount; columnIndex ++)
+        {
+            for (int rowIndex = 0; rowIndex < navigationGrid.rowCount; rowIndex ++)
+            {
+                int tileIndex = columnIndex * navigationGrid.rowCount + rowIndex;
+                auto& tileNode = navigationGrid.tileNodeList[tileIndex];
+
+                tileNode.gid = layerInfo->_tiles[columnIndex + rowIndex * navigationGrid.columnCount] & kTMXFlippedMask;
+                tileNode.columnIndex = columnIndex;
+                tileNode.rowIndex = rowIndex;
+                tileNode.leftTopPosition.x = (((float)columnIndex - (float)rowIndex) / 2.0f + mapSize.width / 2.0f) * tileSize.width;
+                tileNode.leftTopPosition.y = (mapSize.height - ((float)columnIndex + (float)rowIndex) / 2.0f) * tileSize.height;
+                navigationGrid.passableList[tileIndex] = (tileNode.gid != OBSTACLE_ID);
+            }
+        }
+
+        benchmarkMap.mapName = mapName;
+        result = true;
+        break;
+    }
+
+    return result;
+}
+
+static void computeComponentIDList(BenchmarkMap& benchmarkMap)
+{
+    auto& navigationGrid = benchmarkMap.navigationGrid;
+    benchmarkMap.componentIDList.assign(navigationGrid.tileNodeList.size(), COMPONENT_ID_NONE);
+
+    int componentID = 0;
+    queue<int> tileIndexQueue;
+    for (int tileIndex = 0; tileIndex < (int)navigationGrid.tileNodeList.size(); tileIndex ++)
+    {
+        if (!navigationGrid.passableList[tileIndex] || benchmarkMap.componentIDList[tileIndex] != COMPONENT_ID_NONE)
+        {
+            continue;
+        }
+
+        benchmarkMap.componentIDList[tileIndex] = componentID;
+        tileIndexQueue.push(tileIndex);
+        while (!tileIndexQueue.empty())
+        {
+            int columnIndex = tileIndexQueue.front() / navigationGrid.rowCount;
+            int rowIndex = tileIndexQueue.front() % navigationGrid.rowCount;
+            tileIndexQueue.pop();
+
+            for (int columnOffset = -1; columnOffset <= 1; columnOffset ++)
+            {
+                for (int rowOffset = -1; rowOffset <= 1; rowOffset ++)
+                {
+                    int nextColumnIndex = columnIndex + columnOffset;
+                    int nextRowIndex = rowIndex + rowOffset;
+                    if (nextColumnIndex < 0 || nextColumnIndex >= navigationGrid.columnCount ||
+                        nextRowIndex < 0 || nextRowIndex >= navigationGrid.rowCount)
+                    {
+                        continue;
+                    }
+
+                    int nextTileIndex = nextColumnIndex * navigationGrid.rowCount + nextRowIndex;
+                    if (navigationGrid.passableList[nextTileIndex] && benchmarkMap.componentIDList[nextTileIndex] == COMPONENT_ID_NONE)
+                    {
+                        benchmarkMap.componentIDList[nextTileIndex] = componentID;
+                        tileIndexQueue.push(nextTileIndex);
+                    }
+                }
+            }
+        }
+
+        componentID++;
+    }
+}
+
+// 障碍格的任意一个可通行邻格与起点连通，就认为可以走进去，与GameWorld处理建筑物终点的方式一致
+static bool isFootprintTileReachableFrom(BenchmarkMap& benchmarkMap, int footprintTileIndex, int startTileIndex)
+{
+    bool result = false;
+
+    auto& navigationGrid = benchmarkMap.navigationGrid;
+    int columnIndex = footprintTileIndex / navigationGrid.rowCount;
+    int rowIndex = footprintTileIndex % navigationGrid.rowCount;
+    for (int columnOffset = -1; columnOffset <= 1 && !result; columnOffset ++)
+    {
+        for (int rowOffset = -1; rowOffset <= 1 && !result; rowOffset ++)
+        {
+            int nextColumnIndex = columnIndex + columnOffset;
+            int nextRowIndex = rowIndex + rowOffset;
+            if (nextColumnIndex >= 0 && nextColumnIndex < navigationGrid.columnCount &&
+                nextRowIndex >= 0 && nextRowIndex < navigationGrid.rowCount)
+            {
+                int nextTileIndex = nextColumnIndex * navigationGrid.rowCount + nextRowIndex;
+                result = (benchmarkMap.componentIDList[nextTileIndex] != COMPONENT_ID_NONE &&
+                    benchmarkMap.componentIDList[nextTileIndex] == benchmarkMap.componentIDList[startTileIndex]);
+            }
+        }
+    }
+
+    return result;
+}
+
+// 与ComponentHelper相同的规则：可通行格子是它所在的区域，障碍格是周围可通行格子所在的区域
+static void getReferenceComponentIDList(BenchmarkMap& benchmarkMap, int tileIndex, vector<int>& componentIDList)
+{
+    auto& navigationGrid = benchmarkMap.navigationGrid;
+    componentIDList.clear();
+    if (navigationGrid.passableList[tileIndex])
+    {
+        componentIDList.push_back(benchmarkMap.componentIDList[tileIndex]);
+        return;
+    }
+
+    int columnIndex = tileIndex / navigationGrid.rowCount;
+    int rowIndex = tileIndex % navigationGrid.rowCount;
+    for (int columnOffset = -1; columnOffset <= 1; columnOffset ++)
+    {
+        for (int rowOffset = -1; rowOffset <= 1; rowOffset ++)
+        {
+            int nextColumnIndex = columnIndex + columnOffset;
+            int nextRowIndex = rowIndex + rowOffset;
+            if (nextColumnIndex >= 0 && nextColumnIndex < navigationGrid.columnCount &&
+                nextRowIndex >= 0 && nextRowIndex < navigationGrid.rowCount)
+            {
+                int componentID = benchmarkMap.componentIDList[nextColumnIndex * navigationGrid.rowCount + nextRowIndex];
+                if (componentID != COMPONENT_ID_NONE && find(componentIDList.begin(), componentIDList.end(), componentID) == componentIDList.end())
+                {
+                    componentIDList.push_back(componentID);
+                }
+            }
+        }
+    }
+}
+
+static bool isReferenceReachable(BenchmarkMap& benchmarkMap, int startTileIndex, int endTileIndex, bool isEndTileNodePassable)
+{
+    bool result = false;
+
+    if (startTileIndex == endTileIndex)
+    {
+        result = true;
+    }
+    else if (benchmarkMap.navigationGrid.passableList[endTileIndex] || isEndTileNodePassable)
+    {
+        vector<int> startComponentIDList;
+        vector<int> endComponentIDList;
+        getReferenceComponentIDList(benchmarkMap, startTileIndex, startComponentIDList);
+        getReferenceComponentIDList(benchmarkMap, endTileIndex, endComponentIDList);
+
+        for (auto startComponentID : startComponentIDList)
+        {
+            if (find(endComponentIDList.begin(), endComponentIDList.end(), startComponentID) != endComponentIDList.end())
+            {
+                result = true;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+// 在地图的副本上随机放下和拆除建筑物，每次修改以后用随机的起点终点对比ComponentHelper与重新洪水填充的结果，
+// 同时检查并查集的编号数一直不超过格子数的COMPONENT_ID_COMPACT_FACTOR倍；返回出错的次数
+static int runComponentCheck(const BenchmarkMap& benchmarkMap, int editCount, unsigned int seed)
+{
+    BenchmarkMap checkMap = benchmarkMap;
+    auto& navigationGrid = checkMap.navigationGrid;
+    int tileCount = (int)navigationGrid.tileNodeList.size();
+    ComponentHelper::initNavigationGrid(navigationGrid);
+
+    mt19937 randomEngine(seed);
+    uniform_int_distribution<int> tileDistribution(0, tileCount - 1);
+    uniform_int_distribution<int> footprintSizeDistribution(1, MAX_COMPONENT_CHECK_FOOTPRINT_SIZE);
+    bernoulli_distribution halfDistribution(0.5);
+
+    int mismatchCount = 0;
+    int overgrowCount = 0;
+    int maxComponentParentCount = ComponentHelper::getComponentParentCount();
+    vector<TileNode*> changedTileNodeList;
+    for (int editIndex = 0; editIndex < editCount; editIndex++)
+    {
+        // 与MapManager::updateTileNodesGID一致，一次修改的格子都变成同一个gid，只传入状态真正改变的格子
+        int gid = halfDistribution(randomEngine) ? OBSTACLE_ID : PASSABLE_ID;
+        int tileIndex = tileDistribution(randomEngine);
+        int footprintSize = footprintSizeDistribution(randomEngine);
+        int maxColumnIndex = min(tileIndex / navigationGrid.rowCount + footprintSize, navigationGrid.columnCount);
+        int maxRowIndex = min(tileIndex % navigationGrid.rowCount + footprintSize, navigationGrid.rowCount);
+
+        changedTileNodeList.clear();
+        for (int columnIndex = tileIndex / navigationGrid.rowCount; columnIndex < maxColumnIndex; columnIndex ++)
+        {
+            for (int rowIndex = tileIndex % navigationGrid.rowCount; rowIndex < maxRowIndex; rowIndex ++)
+            {
+                int footprintTileIndex = columnIndex * navigationGrid.rowCount + rowIndex;
+                auto& tileNode = navigationGrid.tileNodeList[footprintTileIndex];
+                if (tileNode.gid != gid)
+                {
+                    tileNode.gid = gid;
+                    navigationGrid.passableList[footprintTileIndex] = (gid != OBSTACLE_ID);
+                    changedTileNodeList.push_back(&tileNode);
+                }
+            }
+        }
+
+        if (changedTileNodeList.empty())
+        {
+            continue;
+        }
+
+        ComponentHelper::onTileNodesGIDChanged(changedTileNodeList);
+        maxComponentParentCount = max(maxComponentParentCount, ComponentHelper::getComponentParentCount());
+        if (ComponentHelper::getComponentParentCount() > COMPONENT_ID_COMPACT_FACTOR * tileCount)
+        {
+            overgrowCount++;
+        }
+
+        computeComponentIDList(checkMap);
+        for (int queryIndex = 0; queryIndex < COMPONENT_CHECK_QUERY_COUNT_PER_EDIT; queryIndex++)
+        {
+            int startTileIndex = tileDistribution(randomEngine);
+            int endTileIndex = tileDistribution(randomEngine);
+            bool isEndTileNodePassable = halfDistribution(randomEngine);
+
+            bool isReachable = ComponentHelper::isTileNodeReachable(&navigationGrid.tileNodeList[startTileIndex],
+                &navigationGrid.tileNodeList[endTileIndex], isEndTileNodePassable);
+            if (isReachable != isReferenceReachable(checkMap, startTileIndex, endTileIndex, isEndTileNodePassable))
+            {
+                mismatchCount++;
+            }
+        }
+    }
+
+    // 编号数达到上限时才会重新编号，compacted为0说明这次检查没有覆盖到重新编号，大地图上需要更多的修改次数
+    printf("%-24s component check: edits = %d, queries per edit = %d, mismatches = %d, max parent count = %d (limit %d), compacted = %d\n",
+        benchmarkMap.mapName.c_str(), editCount, COMPONENT_CHECK_QUERY_COUNT_PER_EDIT, mismatchCount,
+        maxComponentParentCount, COMPONENT_ID_COMPACT_FACTOR * tileCount, ComponentHelper::getCompactCount());
+
+    return mismatchCount + overgrowCount;
+}
+
+static bool isQueryMatchSetType(BenchmarkMap& benchmarkMap, QuerySetType querySetType, int startTileIndex, int endTileIndex)
+{
+    bool result = false;
+
+    auto& navigationGrid = benchmarkMap.navigationGrid;
+    auto& componentIDList = benchmarkMap.componentIDList;
+    int distance = max(abs(startTileIndex / navigationGrid.rowCount - endTileIndex / navigationGrid.rowCount),
+        abs(startTileIndex % navigationGrid.rowCount - endTileIndex % navigationGrid.rowCount));
+
+    switch (querySetType)
+    {
+    case QuerySetType::Short:
+        result = (componentIDList[startTileIndex] == componentIDList[endTileIndex] &&
+            distance > 0 && distance <= MAX_SHORT_QUERY_DISTANCE);
+        break;
+    case QuerySetType::Long:
+        result = (componentIDList[startTileIndex] == componentIDList[endTileIndex] &&
+            distance >= max(navigationGrid.columnCount, navigationGrid.rowCount) / 2);
+        break;
+    case QuerySetType::Unreachable:
+        result = (navigationGrid.passableList[endTileIndex] && componentIDList[startTileIndex] != componentIDList[endTileIndex]);
+        break;
+    case QuerySetType::IntoBuildingFootprint:
+        result = (!navigationGrid.passableList[endTileIndex] && isFootprintTileReachableFrom(benchmarkMap, endTileIndex, startTileIndex));
+        break;
+    default:    break;
+    }
+
+    return result;
+}
+
+// 地图中不存在符合条件的起点终点时，生成的查询会少于queryCount
+static vector<PathQuery> generateQuerySet(BenchmarkMap& benchmarkMap, QuerySetType querySetType, int queryCount, unsigned int seed)
+{
+    vector<PathQuery> querySet;
+
+    auto& navigationGrid = benchmarkMap.navigationGrid;
+    vector<int> passableTileIndexList;
+    for (int tileIndex = 0; tileIndex < (int)navigationGrid.passableList.size(); tileIndex ++)
+    {
+        if (navigationGrid.passableList[tileIndex])
+        {
+            passableTileIndexList.push_back(tileIndex);
+        }
+    }
+
+    if (passableTileIndexList.empty())
+    {
+        return querySet;
+    }
+
+    mt19937 randomEngine(seed + (unsigned int)querySetType);
+    uniform_int_distribution<int> startDistribution(0, (int)passableTileIndexList.size() - 1);
+    uniform_int_distribution<int> endDistribution(0, (int)navigationGrid.tileNodeList.size() - 1);
+
+    for (int attemptCount = 0; attemptCount < queryCount * MAX_GENERATE_ATTEMPT_COUNT_PER_QUERY && (int)querySet.size() < queryCount; attemptCount ++)
+    {
+        int startTileIndex = passableTileIndexList[startDistribution(randomEngine)];
+        int endTileIndex = endDistribution(randomEngine);
+
+        if (querySetType == QuerySetType::Short)
+        {
+            // 短距离查询直接在起点附近取终点，否则很难随机命中
+            uniform_int_distribution<int> offsetDistribution(-MAX_SHORT_QUERY_DISTANCE, MAX_SHORT_QUERY_DISTANCE);
+            int endColumnIndex = startTileIndex / navigationGrid.rowCount + offsetDistribution(randomEngine);
+            int endRowIndex = startTileIndex % navigationGrid.rowCount + offsetDistribution(randomEngine);
+            if (endColumnIndex < 0 || endColumnIndex >= navigationGrid.columnCount ||
+                endRowIndex < 0 || endRowIndex >= navigationGrid.rowCount)
+            {
+                continue;
+            }
+
+            endTileIndex = endColumnIndex * navigationGrid.rowCount + endRowIndex;
+        }
+
+        if (isQueryMatchSetType(benchmarkMap, querySetType, startTileIndex, endTileIndex))
+        {
+            PathQuery pathQuery;
+            pathQuery.startTileIndex = startTileIndex;
+            pathQuery.endTileIndex = endTileIndex;
+            pathQuery.isEndTileNodePassable = (querySetType == QuerySetType::IntoBuildingFootprint);
+            querySet.push_back(pathQuery);
+        }
+    }
+
+    return querySet;
+}
+
+static int computePathWeight(const list<TileNode*>& pathList)
+{
+    int pathWeight = 0;
+
+    TileNode* lastTileNode = nullptr;
+    for (auto tileNode : pathList)
+    {
+        if (lastTileNode)
+        {
+            bool isSlop = (lastTileNode->columnIndex != tileNode->columnIndex && lastTileNode->rowIndex != tileNode->rowIndex);
+            pathWeight += isSlop ? MOVE_SLOP_WEIGHT : MOVE_STRAIGHT_WEIGHT;
+        }
+
+        lastTileNode = tileNode;
+    }
+
+    return pathWeight;
+}
+
+static QuerySetReport runQuerySet(BenchmarkMap& benchmarkMap, const vector<PathQuery>& querySet)
+{
+    QuerySetReport report;
+    report.queryCount = (int)querySet.size();
+    report.microsecondsList.reserve(querySet.size());
+
+    auto& tileNodeList = benchmarkMap.navigationGrid.tileNodeList;
+    for (auto& pathQuery : querySet)
+    {
+        auto startNode = &tileNodeList[pathQuery.startTileIndex];
+        auto endNode = &tileNodeList[pathQuery.endTileIndex];
+
+        long long allocationCount = g_allocationCount;
+        long long startTick = getTick();
+        auto pathList = AutoFindPathHelper::computeTileNodePathListBetween(startNode, endNode, pathQuery.isEndTileNodePassable);
+        long long endTick = getTick();
+        allocationCount = g_allocationCount - allocationCount;
+
+        double microseconds = (double)(endTick - startTick) * g_microsecondsPerTick;
+        report.totalMicroseconds += microseconds;
+        report.microsecondsList.push_back(microseconds);
+        report.totalExpandedNodeCount += AutoFindPathHelper::getLastSearchExpandedNodeCount();
+        report.totalAllocationCount += allocationCount;
+
+        if (!pathList.empty())
+        {
+            report.foundCount++;
+            report.totalPathTileCount += pathList.size();
+            report.totalPathWeight += computePathWeight(pathList);
+        }
+    }
+
+    return report;
+}
+
+// 起点和终点取格子的中心，路径长度按照格子边长为MOVE_STRAIGHT_WEIGHT换算，可以与格子路径的代价直接比较
+static QuerySetReport runNavMeshQuerySet(BenchmarkMap& benchmarkMap, const vector<PathQuery>& querySet)
+{
+    QuerySetReport report;
+    report.queryCount = (int)querySet.size();
+    report.microsecondsList.reserve(querySet.size());
+
+    auto& tileNodeList = benchmarkMap.navigationGrid.tileNodeList;
+    auto halfColumnAxis = (tileNodeList[benchmarkMap.navigationGrid.rowCount].leftTopPosition - tileNodeList[0].leftTopPosition) / 2.0f;
+    auto halfRowAxis = (tileNodeList[1].leftTopPosition - tileNodeList[0].leftTopPosition) / 2.0f;
+    float tileWidth = halfColumnAxis.length() * 2.0f;
+    for (auto& pathQuery : querySet)
+    {
+        auto startPosition = tileNodeList[pathQuery.startTileIndex].leftTopPosition + halfColumnAxis + halfRowAxis;
+        auto endPosition = tileNodeList[pathQuery.endTileIndex].leftTopPosition + halfColumnAxis + halfRowAxis;
+
+        list<Vec2> pointPathList;
+        long long allocationCount = g_allocationCount;
+        long long startTick = getTick();
+        bool isFound = NavMeshHelper::computePointPathList(startPosition, endPosition, pathQuery.isEndTileNodePassable, pointPathList);
+        long long endTick = getTick();
+        allocationCount = g_allocationCount - allocationCount;
+
+        double microseconds = (double)(endTick - startTick) * g_microsecondsPerTick;
+        report.totalMicroseconds += microseconds;
+        report.microsecondsList.push_back(microseconds);
+        report.totalExpandedNodeCount += NavMeshHelper::getLastSearchExpandedNodeCount();
+        report.totalAllocationCount += allocationCount;
+
+        if (isFound)
+        {
+            float pathLength = 0.0f;
+            auto lastPosition = startPosition;
+            for (auto& position : pointPathList)
+            {
+                pathLength += lastPosition.distance(position);
+                lastPosition = position;
+            }
+
+            report.foundCount++;
+            report.totalPathTileCount += pointPathList.size();
+            report.totalPathWeight += (long long)(pathLength / tileWidth * MOVE_STRAIGHT_WEIGHT);
+        }
+    }
+
+    return report;
+}
+
+static void printQuerySetReport(const string& mapName, const char* searchModeName, QuerySetType querySetType, QuerySetReport& report)
+{
+    double percentile95Microseconds = 0.0;
+    if (!report.microsecondsList.empty())
+    {
+        sort(report.microsecondsList.begin(), report.microsecondsList.end());
+        percentile95Microseconds = report.microsecondsList[(report.microsecondsList.size() - 1) * 95 / 100];
+    }
+
+    double queryCount = (double)max(report.queryCount, 1);
+    double foundCount = (double)max(report.foundCount, 1);
+    printf("%-24s %-7s %-12s %6d %6d %10.2f %10.2f %10.1f %8.1f %8.1f %8.2f\n",
+        mapName.c_str(),
+        searchModeName,
+        s_querySetTypeToString[(int)querySetType],
+        report.queryCount,
+        report.foundCount,
+        report.totalMicroseconds / queryCount,
+        percentile95Microseconds,
+        (double)report.totalExpandedNodeCount / queryCount,
+        (double)report.totalPathTileCount / foundCount,
+        (double)report.totalPathWeight / foundCount,
+        (double)report.totalAllocationCount / queryCount);
+}
+
+int main(int argc, char* argv[])
+{
+    int queryCountPerSet = DEFAULT_QUERY_COUNT_PER_SET;
+    unsigned int seed = DEFAULT_RANDOM_SEED;
+    int componentCheckEditCount = DEFAULT_COMPONENT_CHECK_EDIT_COUNT;
+    if (argc > 1)
+    {
+        FileUtils::getInstance()->addSearchPath(argv[1]);
+    }
+    if (argc > 2)
+    {
+        queryCountPerSet = max(atoi(argv[2]), 1);
+    }
+    if (argc > 3)
+    {
+        seed = (unsigned int)strtoul(argv[3], nullptr, 10);
+    }
+    if (argc > 4)
+    {
+        componentCheckEditCount = max(atoi(argv[4]), 0);
+    }
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    g_microsecondsPerTick = 1000000.0 / (double)frequency.QuadPart;
+
+    TabFileReader tabFileReader;
+    if (!tabFileReader.open("StageConfig.tab"))
+    {
+        printf("Can not open StageConfig.tab, usage: PathBenchmark [resourceDirectory] [queryCountPerSet] [seed] [componentCheckEditCount]\n");
+        return 1;
+    }
+
+    printf("queryCountPerSet = %d, seed = %u, componentCheckEditCount = %d\n", queryCountPerSet, seed, componentCheckEditCount);
+    printf("%-24s %-7s %-12s %6s %6s %10s %10s %10s %8s %8s %8s\n",
+        "map", "mode", "set", "query", "found", "avg(us)", "p95(us)", "expanded", "tiles", "weight", "allocs");
+
+    int componentCheckErrorCount = 0;
+    for (int i = 0; i < tabFileReader.getRowCount(); i++)
+    {
+        BenchmarkMap benchmarkMap;
+        auto mapName = tabFileReader.getString(i, "MapName");
+        if (!loadBenchmarkMap(mapName, benchmarkMap))
+        {
+            printf("%-24s can not load gameObjectLayer\n", mapName.c_str());
+            continue;
+        }
+
+        componentCheckErrorCount += runComponentCheck(benchmarkMap, componentCheckEditCount, seed + i);
+
+        computeComponentIDList(benchmarkMap);
+        LandmarkHelper::initNavigationGrid(benchmarkMap.navigationGrid);
+        AutoFindPathHelper::initNavigationGrid(benchmarkMap.navigationGrid);
+        NavMeshHelper::initNavigationGrid(benchmarkMap.navigationGrid);
+
+        vector<PathQuery> querySetList[(int)QuerySetType::Count];
+        for (int querySetType = 0; querySetType < (int)QuerySetType::Count; querySetType++)
+        {
+            querySetList[querySetType] = generateQuerySet(benchmarkMap, (QuerySetType)querySetType, queryCountPerSet, seed + i);
+        }
+
+        // 每种搜索方式分别在不使用和使用路标启发值时各跑一遍，对比扩展节点数
+        PathSearchMode searchModeList[] = { PathSearchMode::AStar, PathSearchMode::AStar, PathSearchMode::JumpPointSearch, PathSearchMode::JumpPointSearch };
+        bool isLandmarkEnabledList[] = { false, true, false, true };
+        const char* searchModeNameList[] = { "astar", "alt", "jps", "jpsalt" };
+        for (int modeIndex = 0; modeIndex < 4; modeIndex++)
+        {
+            AutoFindPathHelper::setPathSearchMode(searchModeList[modeIndex]);
+            LandmarkHelper::setEnabled(isLandmarkEnabledList[modeIndex]);
+
+            // 先把每组查询跑一遍，让寻路上下文的缓冲区分配好，统计的是稳定状态下的开销
+            for (int querySetType = 0; querySetType < (int)QuerySetType::Count; querySetType++)
+            {
+                runQuerySet(benchmarkMap, querySetList[querySetType]);
+            }
+
+            for (int querySetType = 0; querySetType < (int)QuerySetType::Count; querySetType++)
+            {
+                auto report = runQuerySet(benchmarkMap, querySetList[querySetType]);
+                printQuerySetReport(mapName, searchModeNameList[modeIndex], (QuerySetType)querySetType, report);
+            }
+        }
+
+        // 导航网格的tiles一列是拐点数，第一次查询包含合并多边形的时间，也先跑一遍
+        for (int querySetType = 0; querySetType < (int)QuerySetType::Count; querySetType++)
+        {
+            runNavMeshQuerySet(benchmarkMap, querySetList[querySetType]);
+        }
+
+        for (int querySetType = 0; querySetType < (int)QuerySetType::Count; querySetType++)
+        {
+            auto report = runNavMeshQuerySet(benchmarkMap, querySetList[querySetType]);
+            printQuerySetReport(mapName, "navmesh", (QuerySetType)querySetType, report);
+        }
+    }
+
+    AutoFindPathHelper::setPathSearchMode(PathSearchMode::AStar);
+    LandmarkHelper::setEnabled(true);
+
+    if (componentCheckErrorCount > 0)
+    {
+        printf("component check failed, error count = %d\n", componentCheckErrorCount);
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,104 +1,371 @@
 #include "Base.h"
 #include "MapManager.h"
 #include "AutoFindPathHelper.h"
+#include "LandmarkHelper.h"
 
-static vector<vector<TileNode*>> g_tileNodeTable;
-
-static TileNode* g_currentNode = nullptr;
-static TileNode* g_endNode = nullptr;
-static list<TileNode*> g_openList;
-static list<TileNode*> g_closeList;
+const int HEAP_INDEX_INVALID = -1;
+const int TILE_INDEX_INVALID = -1;
 
+// 每次寻路需要的临时数据，与TileNode分开存放，通过generation判断数据是否属于当前这次寻路，
+// 这样就不需要在每次寻路前遍历重置所有节点
+struct SearchNode
+{
+    int gotoStartNodeWeight = 0;
+    int sumWeight = 0;
+    int parentTileIndex = TILE_INDEX_INVALID;
+    int heapIndex = HEAP_INDEX_INVALID;
+    unsigned int generation = 0;
+    unsigned int endGeneration = 0;    // 与当前寻路的generation相同时，这个格子是终点之一
+    bool isClosed = false;
+};
+
+// 一次寻路用到的全部可变数据，每个线程使用各自的上下文，互不影响
+struct PathSearchContext
+{
+    vector<SearchNode> searchNodeList;
+    vector<int> openHeap;  // 以sumWeight为键值的二叉堆，元素为tileIndex
+    unsigned int currentGeneration = 0;
+
+    // 所有终点的外接矩形，到矩形的距离不会超过到任何一个终点的距离，可以作为多终点的启发值
+    int minEndColumnIndex = 0;
+    int minEndRowIndex = 0;
+    int maxEndColumnIndex = 0;
+    int maxEndRowIndex = 0;
+    bool isEndTileNodePassable = false;
+
+    // 所有终点到每个路标的代价范围，格子到路标的代价落在范围之外时，差值就是到终点代价的下界
+    const LandmarkTableSet* landmarkTableSet = nullptr;
+    vector<int> minEndLandmarkDistanceList;
+    vector<int> maxEndLandmarkDistanceList;
+
+    // 当前这次寻路允许扩展的区域
+    int minSearchColumnIndex = 0;
+    int minSearchRowIndex = 0;
+    int maxSearchColumnIndex = 0;
+    int maxSearchRowIndex = 0;
+
+    const vector<bool>* passableList = nullptr;   // 主线程寻路时指向导航网格，工作线程寻路时指向快照
+    PathSearchMode pathSearchMode = PathSearchMode::JumpPointSearch;
+    int expandedNodeCount = 0;
+};
+
+static NavigationGrid* g_navigationGrid = nullptr;
 static int g_maxRowCount = 10;
 static int g_maxColumnCount = 10;
 
+static PathSearchContext g_mainThreadSearchContext;
+static PathSearchMode g_pathSearchMode = PathSearchMode::JumpPointSearch;
 
-void AutoFindPathHelper::reset()
+static int toTileIndex(int columnIndex, int rowIndex)
 {
-    for (auto tileNodeInOpenList : g_openList)
-    {
-        tileNodeInOpenList->gotoEndNodeWeight = 0;
-        tileNodeInOpenList->gotoStartNodeWeight = 0;
-        tileNodeInOpenList->sumWeight = 0;
+    return columnIndex * g_maxRowCount + rowIndex;
+}
 
-        tileNodeInOpenList->isVisit = false;
-        tileNodeInOpenList->parent = nullptr;
-    }
+static int getDirection(int delta)
+{
+    return (delta > 0) - (delta < 0);
+}
 
-    for (auto tileNodeInCloseList : g_closeList)
-    {
-        tileNodeInCloseList->gotoEndNodeWeight = 0;
-        tileNodeInCloseList->gotoStartNodeWeight = 0;
-        tileNodeInCloseList->sumWeight = 0;
+void AutoFindPathHelper::initNavigationGrid(NavigationGrid& navigationGrid)
+{
+    g_navigationGrid = &navigationGrid;
+    g_maxColumnCount = navigationGrid.columnCount;
+    g_maxRowCount = navigationGrid.rowCount;
 
-        tileNodeInCloseList->isVisit = false;
-        tileNodeInCloseList->parent = nullptr;
+    g_mainThreadSearchContext = PathSearchContext();
+}
+
+list<TileNode*> AutoFindPathHelper::computeTileNodePathListBetween(TileNode* startNode, TileNode* endNode, bool isEndTileNodePassable /* = false */)
+{
+    return computeTileNodePathListInArea(startNode, endNode, 0, 0, g_maxColumnCount - 1, g_maxRowCount - 1, isEndTileNodePassable);
+}
+
+list<TileNode*> AutoFindPathHelper::computeTileNodePathListInArea(TileNode* startNode, TileNode* endNode,
+    int minColumnIndex, int minRowIndex, int maxColumnIndex, int maxRowIndex, bool isEndTileNodePassable /* = false */)
+{
+    auto& context = g_mainThreadSearchContext;
+    context.minSearchColumnIndex = minColumnIndex;
+    context.minSearchRowIndex = minRowIndex;
+    context.maxSearchColumnIndex = maxColumnIndex;
+    context.maxSearchRowIndex = maxRowIndex;
+    context.isEndTileNodePassable = isEndTileNodePassable;
+    context.passableList = &g_navigationGrid->passableList;
+    context.landmarkTableSet = LandmarkHelper::getLandmarkTableSet().get();
+    context.pathSearchMode = g_pathSearchMode;
+
+    return search(context, startNode, endNode);
+}
+
+list<TileNode*> AutoFindPathHelper::computeTileNodePathListToNearest(TileNode* startNode, const vector<TileNode*>& endNodeList, bool isEndTileNodePassable /* = false */)
+{
+    list<TileNode*> pathList;
+    if (endNodeList.empty())
+    {
+        return pathList;
     }
 
-    g_openList.clear();
-    g_closeList.clear();
+    auto& context = g_mainThreadSearchContext;
+    context.minSearchColumnIndex = 0;
+    context.minSearchRowIndex = 0;
+    context.maxSearchColumnIndex = g_maxColumnCount - 1;
+    context.maxSearchRowIndex = g_maxRowCount - 1;
+    context.isEndTileNodePassable = isEndTileNodePassable;
+    context.passableList = &g_navigationGrid->passableList;
+    context.landmarkTableSet = LandmarkHelper::getLandmarkTableSet().get();
+    context.pathSearchMode = g_pathSearchMode;
+
+    beginSearch(context, startNode, endNodeList);
+    continueSearch(context, INT_MAX, pathList);
+
+    return pathList;
+}
+
+void AutoFindPathHelper::beginTileNodePathSearch(PathSearchContext* context, TileNode* startNode, const vector<TileNode*>& endNodeList,
+    bool isEndTileNodePassable, const vector<bool>& passableList, const LandmarkTableSet* landmarkTableSet, PathSearchMode pathSearchMode)
+{
+    context->minSearchColumnIndex = 0;
+    context->minSearchRowIndex = 0;
+    context->maxSearchColumnIndex = g_maxColumnCount - 1;
+    context->maxSearchRowIndex = g_maxRowCount - 1;
+    context->isEndTileNodePassable = isEndTileNodePassable;
+    context->passableList = &passableList;
+    context->landmarkTableSet = landmarkTableSet;
+    context->pathSearchMode = pathSearchMode;
+
+    beginSearch(*context, startNode, endNodeList);
+}
+
+PathSearchStatus AutoFindPathHelper::continueTileNodePathSearch(PathSearchContext* context, int maxExpandedNodeCount, list<TileNode*>& pathList)
+{
+    return continueSearch(*context, maxExpandedNodeCount, pathList);
 }
 
-void AutoFindPathHelper::initTileNodeTable(const vector<vector<TileNode*>>& tileNodeTable)
+int AutoFindPathHelper::getExpandedNodeCount(PathSearchContext* context)
 {
-    g_tileNodeTable = tileNodeTable;
-    g_maxColumnCount = (int)tileNodeTable.size();
-    g_maxRowCount = (int)tileNodeTable[0].size();
+    return context->expandedNodeCount;
+}
 
-    g_currentNode = nullptr;
-    g_endNode = nullptr;
-    g_openList.clear();
-    g_closeList.clear();
+PathSearchContext* AutoFindPathHelper::createSearchContext()
+{
+    return new PathSearchContext();
 }
 
-list<TileNode*> AutoFindPathHelper::computeTileNodePathListBetween(TileNode* startNode, TileNode* endNode)
+void AutoFindPathHelper::destroySearchContext(PathSearchContext* context)
+{
+    delete context;
+}
+
+void AutoFindPathHelper::setPathSearchMode(PathSearchMode pathSearchMode)
+{
+    g_pathSearchMode = pathSearchMode;
+}
+
+PathSearchMode AutoFindPathHelper::getPathSearchMode()
+{
+    return g_pathSearchMode;
+}
+
+int AutoFindPathHelper::getLastSearchExpandedNodeCount()
+{
+    return g_mainThreadSearchContext.expandedNodeCount;
+}
+
+list<TileNode*> AutoFindPathHelper::search(PathSearchContext& context, TileNode* startNode, TileNode* endNode)
 {
     list<TileNode*> pathList;
 
-    reset();
+    beginSearch(context, startNode, endNode);
+    continueSearch(context, INT_MAX, pathList);
+
+    return pathList;
+}
 
-    g_currentNode = startNode;
-    g_endNode = endNode;
+void AutoFindPathHelper::beginSearch(PathSearchContext& context, TileNode* startNode, TileNode* endNode)
+{
+    beginNewSearch(context);
+    addEndNode(context, endNode);
+    pushStartNode(context, startNode);
+}
 
-    startNode->isVisit = true;
-    g_closeList.push_back(startNode);
+void AutoFindPathHelper::beginSearch(PathSearchContext& context, TileNode* startNode, const vector<TileNode*>& endNodeList)
+{
+    beginNewSearch(context);
+    for (auto endNode : endNodeList)
+    {
+        addEndNode(context, endNode);
+    }
+    pushStartNode(context, startNode);
+}
 
-    while (true)
+void AutoFindPathHelper::addEndNode(PathSearchContext& context, TileNode* endNode)
+{
+    context.searchNodeList[toTileIndex(endNode->columnIndex, endNode->rowIndex)].endGeneration = context.currentGeneration;
+
+    if (context.minEndColumnIndex > context.maxEndColumnIndex)
+    {
+        context.minEndColumnIndex = context.maxEndColumnIndex = endNode->columnIndex;
+        context.minEndRowIndex = context.maxEndRowIndex = endNode->rowIndex;
+    }
+    else
+    {
+        context.minEndColumnIndex = std::min(context.minEndColumnIndex, endNode->columnIndex);
+        context.maxEndColumnIndex = std::max(context.maxEndColumnIndex, endNode->columnIndex);
+        context.minEndRowIndex = std::min(context.minEndRowIndex, endNode->rowIndex);
+        context.maxEndRowIndex = std::max(context.maxEndRowIndex, endNode->rowIndex);
+    }
+
+    if (!context.landmarkTableSet)
+    {
+        return;
+    }
+
+    auto& tableList = context.landmarkTableSet->tableList;
+    for (int landmarkIndex = 0; landmarkIndex < (int)tableList.size(); landmarkIndex++)
     {
-        auto nextPathNode = findNextPathNodeBeside(g_currentNode);
-        if (!nextPathNode)
+        auto& distanceList = tableList[landmarkIndex]->distanceList;
+        int distance = distanceList[toTileIndex(endNode->columnIndex, endNode->rowIndex)];
+        if (distance != LANDMARK_DISTANCE_INFINITE)
         {
-            if (!g_openList.empty())
-            {
-                g_currentNode = startNode;
-                continue;
-            }
-            else
+            addEndLandmarkDistance(context, landmarkIndex, distance);
+        }
+        else if (context.isEndTileNodePassable)
+        {
+            // 允许走进去的障碍格没有到路标的代价，一定是从旁边的格子走进去的，用旁边格子的代价范围代替
+            for (int besideColumnIndex = max(endNode->columnIndex - 1, 0); besideColumnIndex <= min(endNode->columnIndex + 1, g_maxColumnCount - 1); besideColumnIndex++)
             {
-                break;
+                for (int besideRowIndex = max(endNode->rowIndex - 1, 0); besideRowIndex <= min(endNode->rowIndex + 1, g_maxRowCount - 1); besideRowIndex++)
+                {
+                    int besideDistance = distanceList[toTileIndex(besideColumnIndex, besideRowIndex)];
+                    if (besideDistance != LANDMARK_DISTANCE_INFINITE)
+                    {
+                        addEndLandmarkDistance(context, landmarkIndex, besideDistance);
+                    }
+                }
             }
         }
-        
-        g_openList.remove(nextPathNode);
-        g_closeList.push_back(nextPathNode);
-        g_currentNode = nextPathNode;
+    }
+}
+
+void AutoFindPathHelper::addEndLandmarkDistance(PathSearchContext& context, int landmarkIndex, int distance)
+{
+    context.minEndLandmarkDistanceList[landmarkIndex] = std::min(context.minEndLandmarkDistanceList[landmarkIndex], distance);
+    context.maxEndLandmarkDistanceList[landmarkIndex] = std::max(context.maxEndLandmarkDistanceList[landmarkIndex], distance);
+}
+
+void AutoFindPathHelper::pushStartNode(PathSearchContext& context, TileNode* startNode)
+{
+    int startTileIndex = toTileIndex(startNode->columnIndex, startNode->rowIndex);
+    auto& startSearchNode = context.searchNodeList[startTileIndex];
+    startSearchNode.generation = context.currentGeneration;
+    startSearchNode.isClosed = false;
+    startSearchNode.heapIndex = HEAP_INDEX_INVALID;
+    startSearchNode.gotoStartNodeWeight = 0;
+    startSearchNode.sumWeight = computeGotoEndNodeWeight(context, startNode->columnIndex, startNode->rowIndex);
+    startSearchNode.parentTileIndex = TILE_INDEX_INVALID;
+    pushToOpenList(context, startTileIndex);
+}
+
+PathSearchStatus AutoFindPathHelper::continueSearch(PathSearchContext& context, int maxExpandedNodeCount, list<TileNode*>& pathList)
+{
+    PathSearchStatus result = PathSearchStatus::NotFound;
 
-        if (nextPathNode == g_endNode)
+    // 开放列表和节点数据都保存在上下文里，中断之后可以原样继续
+    int expandedNodeCountInSlice = 0;
+    while (!isOpenListEmpty(context))
+    {
+        if (expandedNodeCountInSlice >= maxExpandedNodeCount)
+        {
+            result = PathSearchStatus::Searching;
+            break;
+        }
+
+        int currentTileIndex = popFromOpenList(context);
+        if (isEndTileIndex(context, currentTileIndex))
         {
-            pathList = getPathList(startNode, g_endNode);
+            pathList = getPathList(context, currentTileIndex);
+            result = PathSearchStatus::Found;
             break;
         }
+
+        context.searchNodeList[currentTileIndex].isClosed = true;
+        context.expandedNodeCount++;
+        expandedNodeCountInSlice++;
+
+        if (context.pathSearchMode == PathSearchMode::JumpPointSearch)
+        {
+            expandJumpPoints(context, currentTileIndex);
+        }
+        else
+        {
+            expandNodesBeside(context, currentTileIndex);
+        }
     }
 
-    return pathList;
+    return result;
+}
+
+void AutoFindPathHelper::beginNewSearch(PathSearchContext& context)
+{
+    // 上下文第一次使用或者换了地图时，按照当前地图的大小分配数据
+    int tileCount = g_maxColumnCount * g_maxRowCount;
+    if ((int)context.searchNodeList.size() != tileCount)
+    {
+        context.searchNodeList.assign(tileCount, SearchNode());
+        context.openHeap.reserve(tileCount);
+        context.currentGeneration = 0;
+    }
+
+    context.openHeap.clear();
+    context.expandedNodeCount = 0;
+
+    // 还没有加入终点时外接矩形和代价范围都为空
+    context.minEndColumnIndex = 0;
+    context.maxEndColumnIndex = -1;
+    context.minEndRowIndex = 0;
+    context.maxEndRowIndex = -1;
+
+    int landmarkCount = context.landmarkTableSet ? (int)context.landmarkTableSet->tableList.size() : 0;
+    context.minEndLandmarkDistanceList.assign(landmarkCount, INT_MAX);
+    context.maxEndLandmarkDistanceList.assign(landmarkCount, INT_MIN);
+
+    context.currentGeneration++;
+    if (context.currentGeneration == 0)
+    {
+        // generation溢出回绕时，旧数据可能被误认为属于当前寻路，需要整体清理一次
+        for (auto& searchNode : context.searchNodeList)
+        {
+            searchNode.generation = 0;
+            searchNode.endGeneration = 0;
+        }
+        context.currentGeneration = 1;
+    }
 }
 
-bool AutoFindPathHelper::canVisit(TileNode* node)
+bool AutoFindPathHelper::isPassable(PathSearchContext& context, int columnIndex, int rowIndex)
+{
+    return columnIndex >= context.minSearchColumnIndex && columnIndex <= context.maxSearchColumnIndex &&
+        rowIndex >= context.minSearchRowIndex && rowIndex <= context.maxSearchRowIndex &&
+        isTileNodePassable(context, columnIndex, rowIndex);
+}
+
+bool AutoFindPathHelper::isTileNodePassable(PathSearchContext& context, int columnIndex, int rowIndex)
+{
+    int tileIndex = toTileIndex(columnIndex, rowIndex);
+    if (context.isEndTileNodePassable && isEndTileIndex(context, tileIndex))
+    {
+        return true;
+    }
+
+    return (*context.passableList)[tileIndex];
+}
+
+bool AutoFindPathHelper::canVisit(PathSearchContext& context, int columnIndex, int rowIndex)
 {
     bool result = true;
 
-    if (node->gid == OBSTACLE_ID || 
-        node->isVisit)
+    auto& searchNode = context.searchNodeList[toTileIndex(columnIndex, rowIndex)];
+    if (!isTileNodePassable(context, columnIndex, rowIndex) ||
+        (searchNode.generation == context.currentGeneration && searchNode.isClosed))
     {
         result = false;
     }
@@ -106,119 +373,396 @@ bool AutoFindPathHelper::canVisit(TileNode* node)
     return result;
 }
 
-bool isLeftSumWeightLessThanRight(const TileNode* left, const TileNode* right);
-TileNode* AutoFindPathHelper::findNextPathNodeBeside(TileNode* node)
+bool AutoFindPathHelper::isEndTileIndex(PathSearchContext& context, int tileIndex)
+{
+    return context.searchNodeList[tileIndex].endGeneration == context.currentGeneration;
+}
+
+int AutoFindPathHelper::computeGotoEndNodeWeight(PathSearchContext& context, int columnIndex, int rowIndex)
+{
+    int nearestEndColumnIndex = std::min(std::max(columnIndex, context.minEndColumnIndex), context.maxEndColumnIndex);
+    int nearestEndRowIndex = std::min(std::max(rowIndex, context.minEndRowIndex), context.maxEndRowIndex);
+
+    int gotoEndNodeWeight = computeWeightBetween(columnIndex, rowIndex, nearestEndColumnIndex, nearestEndRowIndex);
+    if (context.landmarkTableSet)
+    {
+        // 取所有路标给出的下界中最大的一个，每个下界都不会高估，因此结果仍然不会高估
+        int tileIndex = toTileIndex(columnIndex, rowIndex);
+        auto& tableList = context.landmarkTableSet->tableList;
+        for (int landmarkIndex = 0; landmarkIndex < (int)tableList.size(); landmarkIndex++)
+        {
+            int distance = tableList[landmarkIndex]->distanceList[tileIndex];
+            int minEndDistance = context.minEndLandmarkDistanceList[landmarkIndex];
+            int maxEndDistance = context.maxEndLandmarkDistanceList[landmarkIndex];
+            if (distance == LANDMARK_DISTANCE_INFINITE || minEndDistance > maxEndDistance)
+            {
+                continue;
+            }
+
+            gotoEndNodeWeight = std::max(gotoEndNodeWeight, std::max(distance - maxEndDistance, minEndDistance - distance));
+        }
+    }
+
+    return gotoEndNodeWeight;
+}
+
+int AutoFindPathHelper::computeWeightBetween(int fromColumnIndex, int fromRowIndex, int toColumnIndex, int toRowIndex)
+{
+    // 八方向移动的对角线距离，斜走一步的代价小于两次直走，因此不会高估实际代价
+    int rowDistance = std::abs(toRowIndex - fromRowIndex);
+    int columnDistance = std::abs(toColumnIndex - fromColumnIndex);
+    int slopStepCount = std::min(rowDistance, columnDistance);
+    int straightStepCount = std::max(rowDistance, columnDistance) - slopStepCount;
+
+    return slopStepCount * MOVE_SLOP_WEIGHT + straightStepCount * MOVE_STRAIGHT_WEIGHT;
+}
+
+void AutoFindPathHelper::tryUpdateSearchNode(PathSearchContext& context, int columnIndex, int rowIndex, int parentTileIndex, int newGotoStartNodeWeight)
+{
+    int tileIndex = toTileIndex(columnIndex, rowIndex);
+    auto& searchNode = context.searchNodeList[tileIndex];
+    if (searchNode.generation != context.currentGeneration)
+    {
+        searchNode.generation = context.currentGeneration;
+        searchNode.isClosed = false;
+        searchNode.heapIndex = HEAP_INDEX_INVALID;
+        searchNode.gotoStartNodeWeight = newGotoStartNodeWeight;
+        searchNode.sumWeight = newGotoStartNodeWeight + computeGotoEndNodeWeight(context, columnIndex, rowIndex);
+        searchNode.parentTileIndex = parentTileIndex;
+
+        pushToOpenList(context, tileIndex);
+    }
+    else if (!searchNode.isClosed && newGotoStartNodeWeight < searchNode.gotoStartNodeWeight)
+    {
+        // 找到了更短的路径，更新代价并在堆中上浮
+        searchNode.sumWeight -= searchNode.gotoStartNodeWeight - newGotoStartNodeWeight;
+        searchNode.gotoStartNodeWeight = newGotoStartNodeWeight;
+        searchNode.parentTileIndex = parentTileIndex;
+
+        siftUp(context, searchNode.heapIndex);
+    }
+}
+
+void AutoFindPathHelper::expandNodesBeside(PathSearchContext& context, int tileIndex)
 {
-    TileNode* nextPathNode = nullptr;
+    int columnIndex = tileIndex / g_maxRowCount;
+    int rowIndex = tileIndex % g_maxRowCount;
+    int gotoStartNodeWeight = context.searchNodeList[tileIndex].gotoStartNodeWeight;
 
-    int minRowIndex = max(node->rowIndex - 1, 0);
-    int maxRowIndex = min(node->rowIndex + 1, g_maxRowCount - 1);
+    int minRowIndex = max(rowIndex - 1, context.minSearchRowIndex);
+    int maxRowIndex = min(rowIndex + 1, context.maxSearchRowIndex);
 
-    int minColumnIndex = max(node->columnIndex - 1, 0);
-    int maxColumnIndex = min(node->columnIndex + 1, g_maxColumnCount - 1);
+    int minColumnIndex = max(columnIndex - 1, context.minSearchColumnIndex);
+    int maxColumnIndex = min(columnIndex + 1, context.maxSearchColumnIndex);
 
-    for (int columnIndex = minColumnIndex; columnIndex <= maxColumnIndex; columnIndex++)
+    for (int besideColumnIndex = minColumnIndex; besideColumnIndex <= maxColumnIndex; besideColumnIndex++)
     {
-        for (int rowIndex = minRowIndex; rowIndex <= maxRowIndex; rowIndex++)
+        for (int besideRowIndex = minRowIndex; besideRowIndex <= maxRowIndex; besideRowIndex++)
         {
-            auto prepareToVisitNode = g_tileNodeTable[columnIndex][rowIndex];
-            if (canVisit(prepareToVisitNode))
+            if (!canVisit(context, besideColumnIndex, besideRowIndex))
             {
-                prepareToVisitNode->isVisit = true;
-                prepareToVisitNode->parent = node;
+                continue;
+            }
 
-                if (prepareToVisitNode->rowIndex != node->rowIndex && 
-                    prepareToVisitNode->columnIndex != node->columnIndex)
-                {
-                    prepareToVisitNode->gotoStartNodeWeight = node->gotoStartNodeWeight + MOVE_SLOP_WEIGHT;
-                }
-                else
-                {
-                    prepareToVisitNode->gotoStartNodeWeight = node->gotoStartNodeWeight + MOVE_STRAIGHT_WEIGHT;
-                }
+            int moveWeight = MOVE_STRAIGHT_WEIGHT;
+            if (besideColumnIndex != columnIndex && besideRowIndex != rowIndex)
+            {
+                moveWeight = MOVE_SLOP_WEIGHT;
+            }
 
-                int gotoEndNodeRowDistance = std::abs(g_endNode->rowIndex - prepareToVisitNode->rowIndex);
-                int gotoEndNodeColumnDistance = std::abs(g_endNode->columnIndex - prepareToVisitNode->columnIndex);
-                prepareToVisitNode->gotoEndNodeWeight = (gotoEndNodeRowDistance + gotoEndNodeColumnDistance) * MOVE_STRAIGHT_WEIGHT;
+            tryUpdateSearchNode(context, besideColumnIndex, besideRowIndex, tileIndex, gotoStartNodeWeight + moveWeight);
+        }
+    }
+}
 
-                prepareToVisitNode->sumWeight = prepareToVisitNode->gotoStartNodeWeight + prepareToVisitNode->gotoEndNodeWeight;
+list<TileNode*> AutoFindPathHelper::getPathList(PathSearchContext& context, int endTileIndex)
+{
+    list<TileNode*> pathList;
 
-                
-                //ڲʱʵ
-                if (g_openList.empty())
-                {
-                    g_openList.push_back(prepareToVisitNode);
-                }
-                else
-                {
-                    bool shouldPushBack = false;
-                    int elementIndex = 0;
-                    for (auto& tileNode : g_openList)
-                    {
-                        if (tileNode->sumWeight >= prepareToVisitNode->sumWeight)
-                        {
-                            break;
-                        }
-
-                        if (elementIndex < (int)g_openList.size() - 1)
-                        {
-                            elementIndex++;
-                        }
-                        else
-                        {
-                            shouldPushBack = true;
-                        }
-                    }
+    int tileIndex = endTileIndex;
+    while (tileIndex != TILE_INDEX_INVALID)
+    {
+        int columnIndex = tileIndex / g_maxRowCount;
+        int rowIndex = tileIndex % g_maxRowCount;
+        pathList.push_back(&g_navigationGrid->tileNodeList[tileIndex]);
 
-                    list<TileNode*>::iterator minGreaterIter = std::next(g_openList.begin(), elementIndex);
-                    if (shouldPushBack)
-                    {
-                        g_openList.push_back(prepareToVisitNode);
-                    }
-                    else
-                    {
-                        g_openList.insert(minGreaterIter, prepareToVisitNode);
-                    }
+        int parentTileIndex = context.searchNodeList[tileIndex].parentTileIndex;
+        if (parentTileIndex == TILE_INDEX_INVALID)
+        {
+            break;
+        }
+
+        // JPS的父节点可能隔着多个格子，需要把中间的格子补上，保证路径是逐格的
+        int parentColumnIndex = parentTileIndex / g_maxRowCount;
+        int parentRowIndex = parentTileIndex % g_maxRowCount;
+        int columnDirection = getDirection(parentColumnIndex - columnIndex);
+        int rowDirection = getDirection(parentRowIndex - rowIndex);
+
+        columnIndex += columnDirection;
+        rowIndex += rowDirection;
+        while (columnIndex != parentColumnIndex || rowIndex != parentRowIndex)
+        {
+            pathList.push_back(&g_navigationGrid->tileNodeList[toTileIndex(columnIndex, rowIndex)]);
+            columnIndex += columnDirection;
+            rowIndex += rowDirection;
+        }
+
+        tileIndex = parentTileIndex;
+    }
+
+    return pathList;
+}
+
+void AutoFindPathHelper::expandJumpPoints(PathSearchContext& context, int tileIndex)
+{
+    int columnIndex = tileIndex / g_maxRowCount;
+    int rowIndex = tileIndex % g_maxRowCount;
+
+    int parentTileIndex = context.searchNodeList[tileIndex].parentTileIndex;
+    if (parentTileIndex == TILE_INDEX_INVALID)
+    {
+        for (int columnDirection = -1; columnDirection <= 1; columnDirection++)
+        {
+            for (int rowDirection = -1; rowDirection <= 1; rowDirection++)
+            {
+                if (columnDirection != 0 || rowDirection != 0)
+                {
+                    tryJumpTo(context, columnIndex + columnDirection, rowIndex + rowDirection, columnDirection, rowDirection, tileIndex);
                 }
             }
         }
+
+        return;
     }
 
-    if (!g_openList.empty())
+    // 只沿着从父节点过来的方向以及强迫邻居的方向继续跳跃，其余方向一定有不经过当前节点的等价路径
+    int columnDirection = getDirection(columnIndex - parentTileIndex / g_maxRowCount);
+    int rowDirection = getDirection(rowIndex - parentTileIndex % g_maxRowCount);
+    if (columnDirection != 0 && rowDirection != 0)
     {
-        // sumWeightֵС
-        //g_openList.sort(isLeftSumWeightLessThanRight);
+        tryJumpTo(context, columnIndex, rowIndex + rowDirection, 0, rowDirection, tileIndex);
+        tryJumpTo(context, columnIndex + columnDirection, rowIndex, columnDirection, 0, tileIndex);
+        tryJumpTo(context, columnIndex + columnDirection, rowIndex + rowDirection, columnDirection, rowDirection, tileIndex);
 
-        for (auto alternativeNode : g_openList)
+        if (!isPassable(context, columnIndex - columnDirection, rowIndex))
         {
-            if (alternativeNode->gotoStartNodeWeight > node->gotoStartNodeWeight)
-            {
-                nextPathNode = alternativeNode;
+            tryJumpTo(context, columnIndex - columnDirection, rowIndex + rowDirection, -columnDirection, rowDirection, tileIndex);
+        }
+        if (!isPassable(context, columnIndex, rowIndex - rowDirection))
+        {
+            tryJumpTo(context, columnIndex + columnDirection, rowIndex - rowDirection, columnDirection, -rowDirection, tileIndex);
+        }
+    }
+    else if (columnDirection != 0)
+    {
+        tryJumpTo(context, columnIndex + columnDirection, rowIndex, columnDirection, 0, tileIndex);
 
-                break;
-            }
+        if (!isPassable(context, columnIndex, rowIndex + 1))
+        {
+            tryJumpTo(context, columnIndex + columnDirection, rowIndex + 1, columnDirection, 1, tileIndex);
+        }
+        if (!isPassable(context, columnIndex, rowIndex - 1))
+        {
+            tryJumpTo(context, columnIndex + columnDirection, rowIndex - 1, columnDirection, -1, tileIndex);
         }
     }
+    else
+    {
+        tryJumpTo(context, columnIndex, rowIndex + rowDirection, 0, rowDirection, tileIndex);
 
-    return nextPathNode;
+        if (!isPassable(context, columnIndex + 1, rowIndex))
+        {
+            tryJumpTo(context, columnIndex + 1, rowIndex + rowDirection, 1, rowDirection, tileIndex);
+        }
+        if (!isPassable(context, columnIndex - 1, rowIndex))
+        {
+            tryJumpTo(context, columnIndex - 1, rowIndex + rowDirection, -1, rowDirection, tileIndex);
+        }
+    }
 }
 
-bool isLeftSumWeightLessThanRight(const TileNode* left, const TileNode* right)
+void AutoFindPathHelper::tryJumpTo(PathSearchContext& context, int columnIndex, int rowIndex, int columnDirection, int rowDirection, int parentTileIndex)
 {
-    return left->sumWeight < right->sumWeight;
+    if (!jump(context, columnIndex, rowIndex, columnDirection, rowDirection))
+    {
+        return;
+    }
+
+    int parentColumnIndex = parentTileIndex / g_maxRowCount;
+    int parentRowIndex = parentTileIndex % g_maxRowCount;
+    int newGotoStartNodeWeight = context.searchNodeList[parentTileIndex].gotoStartNodeWeight +
+        computeWeightBetween(parentColumnIndex, parentRowIndex, columnIndex, rowIndex);
+
+    tryUpdateSearchNode(context, columnIndex, rowIndex, parentTileIndex, newGotoStartNodeWeight);
 }
 
-list<TileNode*> AutoFindPathHelper::getPathList(TileNode* startNode, TileNode* endNode)
+bool AutoFindPathHelper::jump(PathSearchContext& context, int& columnIndex, int& rowIndex, int columnDirection, int rowDirection)
 {
-    list<TileNode*> pathList;
+    if (columnDirection == 0 || rowDirection == 0)
+    {
+        return jumpStraight(context, columnIndex, rowIndex, columnDirection, rowDirection);
+    }
+
+    while (isPassable(context, columnIndex, rowIndex))
+    {
+        if (isEndTileIndex(context, toTileIndex(columnIndex, rowIndex)) ||
+            hasForcedNeighbor(context, columnIndex, rowIndex, columnDirection, rowDirection))
+        {
+            return true;
+        }
+
+        // 斜向跳跃时，两个分量方向上只要能找到跳点，当前格子就是跳点
+        int straightColumnIndex = columnIndex + columnDirection;
+        int straightRowIndex = rowIndex;
+        if (jumpStraight(context, straightColumnIndex, straightRowIndex, columnDirection, 0))
+        {
+            return true;
+        }
 
-    
-    auto previousNode = endNode;
-    while (previousNode)
+        straightColumnIndex = columnIndex;
+        straightRowIndex = rowIndex + rowDirection;
+        if (jumpStraight(context, straightColumnIndex, straightRowIndex, 0, rowDirection))
+        {
+            return true;
+        }
+
+        columnIndex += columnDirection;
+        rowIndex += rowDirection;
+    }
+
+    return false;
+}
+
+bool AutoFindPathHelper::jumpStraight(PathSearchContext& context, int& columnIndex, int& rowIndex, int columnDirection, int rowDirection)
+{
+    while (isPassable(context, columnIndex, rowIndex))
     {
-        pathList.push_back(previousNode);
-        previousNode = previousNode->parent;
+        if (isEndTileIndex(context, toTileIndex(columnIndex, rowIndex)) ||
+            hasForcedNeighbor(context, columnIndex, rowIndex, columnDirection, rowDirection))
+        {
+            return true;
+        }
+
+        columnIndex += columnDirection;
+        rowIndex += rowDirection;
     }
 
-    return pathList;
+    return false;
+}
+
+bool AutoFindPathHelper::hasForcedNeighbor(PathSearchContext& context, int columnIndex, int rowIndex, int columnDirection, int rowDirection)
+{
+    // 斜向允许从两个障碍物之间穿过，与A*的八方向扩展规则保持一致
+    if (columnDirection != 0 && rowDirection != 0)
+    {
+        return (isPassable(context, columnIndex - columnDirection, rowIndex + rowDirection) && !isPassable(context, columnIndex - columnDirection, rowIndex)) ||
+            (isPassable(context, columnIndex + columnDirection, rowIndex - rowDirection) && !isPassable(context, columnIndex, rowIndex - rowDirection));
+    }
+
+    if (columnDirection != 0)
+    {
+        return (isPassable(context, columnIndex + columnDirection, rowIndex + 1) && !isPassable(context, columnIndex, rowIndex + 1)) ||
+            (isPassable(context, columnIndex + columnDirection, rowIndex - 1) && !isPassable(context, columnIndex, rowIndex - 1));
+    }
+
+    return (isPassable(context, columnIndex + 1, rowIndex + rowDirection) && !isPassable(context, columnIndex + 1, rowIndex)) ||
+        (isPassable(context, columnIndex - 1, rowIndex + rowDirection) && !isPassable(context, columnIndex - 1, rowIndex));
+}
+
+bool AutoFindPathHelper::isOpenListEmpty(PathSearchContext& context)
+{
+    return context.openHeap.empty();
+}
+
+void AutoFindPathHelper::pushToOpenList(PathSearchContext& context, int tileIndex)
+{
+    context.openHeap.push_back(tileIndex);
+
+    int heapIndex = (int)context.openHeap.size() - 1;
+    context.searchNodeList[tileIndex].heapIndex = heapIndex;
+    siftUp(context, heapIndex);
+}
+
+int AutoFindPathHelper::popFromOpenList(PathSearchContext& context)
+{
+    int topTileIndex = context.openHeap.front();
+
+    swapHeapElement(context, 0, (int)context.openHeap.size() - 1);
+    context.openHeap.pop_back();
+    context.searchNodeList[topTileIndex].heapIndex = HEAP_INDEX_INVALID;
+
+    if (!context.openHeap.empty())
+    {
+        siftDown(context, 0);
+    }
+
+    return topTileIndex;
+}
+
+void AutoFindPathHelper::siftUp(PathSearchContext& context, int heapIndex)
+{
+    while (heapIndex > 0)
+    {
+        int parentHeapIndex = (heapIndex - 1) / 2;
+        if (!isHigherPriority(context, context.openHeap[heapIndex], context.openHeap[parentHeapIndex]))
+        {
+            break;
+        }
+
+        swapHeapElement(context, heapIndex, parentHeapIndex);
+        heapIndex = parentHeapIndex;
+    }
+}
+
+void AutoFindPathHelper::siftDown(PathSearchContext& context, int heapIndex)
+{
+    int heapSize = (int)context.openHeap.size();
+    while (true)
+    {
+        int leftChildHeapIndex = heapIndex * 2 + 1;
+        int rightChildHeapIndex = leftChildHeapIndex + 1;
+        int highestPriorityHeapIndex = heapIndex;
+
+        if (leftChildHeapIndex < heapSize &&
+            isHigherPriority(context, context.openHeap[leftChildHeapIndex], context.openHeap[highestPriorityHeapIndex]))
+        {
+            highestPriorityHeapIndex = leftChildHeapIndex;
+        }
+
+        if (rightChildHeapIndex < heapSize &&
+            isHigherPriority(context, context.openHeap[rightChildHeapIndex], context.openHeap[highestPriorityHeapIndex]))
+        {
+            highestPriorityHeapIndex = rightChildHeapIndex;
+        }
+
+        if (highestPriorityHeapIndex == heapIndex)
+        {
+            break;
+        }
+
+        swapHeapElement(context, heapIndex, highestPriorityHeapIndex);
+        heapIndex = highestPriorityHeapIndex;
+    }
+}
+
+bool AutoFindPathHelper::isHigherPriority(PathSearchContext& context, int leftTileIndex, int rightTileIndex)
+{
+    auto& leftSearchNode = context.searchNodeList[leftTileIndex];
+    auto& rightSearchNode = context.searchNodeList[rightTileIndex];
+
+    // sumWeight相同时，优先扩展离起点更远的节点，可以减少在等价路径上的无效扩展
+    if (leftSearchNode.sumWeight != rightSearchNode.sumWeight)
+    {
+        return leftSearchNode.sumWeight < rightSearchNode.sumWeight;
+    }
+
+    return leftSearchNode.gotoStartNodeWeight > rightSearchNode.gotoStartNodeWeight;
+}
+
+void AutoFindPathHelper::swapHeapElement(PathSearchContext& context, int leftHeapIndex, int rightHeapIndex)
+{
+    std::swap(context.openHeap[leftHeapIndex], context.openHeap[rightHeapIndex]);
+
+    context.searchNodeList[context.openHeap[leftHeapIndex]].heapIndex = leftHeapIndex;
+    context.searchNodeList[context.openHeap[rightHeapIndex]].heapIndex = rightHeapIndex;
 }
@@ -3,18 +3,82 @@
 const int MOVE_SLOP_WEIGHT = 14;
 const int MOVE_STRAIGHT_WEIGHT = 10;
 
+enum class PathSearchMode
+{
+    AStar,
+    JumpPointSearch
+};
+
+enum class PathSearchStatus
+{
+    Searching,
+    Found,
+    NotFound
+};
+
+struct PathSearchContext;
+struct LandmarkTableSet;
+
 class AutoFindPathHelper
 {
 public:
-    static void initTileNodeTable(const vector<vector<TileNode*>>& tileNodeTable);
-    static list<TileNode*> computeTileNodePathListBetween(TileNode* startNode, TileNode* endNode);
+    static void initNavigationGrid(NavigationGrid& navigationGrid);
+
+    // isEndTileNodePassable为true时，即便终点是障碍物也可以走进去，不需要修改格子的gid
+    static list<TileNode*> computeTileNodePathListBetween(TileNode* startNode, TileNode* endNode, bool isEndTileNodePassable = false);
+    // 只在指定的矩形区域内寻路，区域边界包含在内
+    static list<TileNode*> computeTileNodePathListInArea(TileNode* startNode, TileNode* endNode,
+        int minColumnIndex, int minRowIndex, int maxColumnIndex, int maxRowIndex, bool isEndTileNodePassable = false);
+    // 所有终点一起参与一次搜索，返回到达代价最小的那个终点的路径，路径的第一个格子就是选中的终点
+    static list<TileNode*> computeTileNodePathListToNearest(TileNode* startNode, const vector<TileNode*>& endNodeList, bool isEndTileNodePassable = false);
+
+    // 使用独立的寻路上下文和通行数据快照分段寻路，不访问任何共享的可变数据，可以在工作线程中调用
+    // 寻路结束之前passableList和landmarkTableSet必须一直有效，landmarkTableSet为空时不使用路标启发值
+    static void beginTileNodePathSearch(PathSearchContext* context, TileNode* startNode, const vector<TileNode*>& endNodeList,
+        bool isEndTileNodePassable, const vector<bool>& passableList, const LandmarkTableSet* landmarkTableSet, PathSearchMode pathSearchMode);
+    // 最多扩展maxExpandedNodeCount个节点，返回Searching时下次调用从中断的地方继续
+    static PathSearchStatus continueTileNodePathSearch(PathSearchContext* context, int maxExpandedNodeCount, list<TileNode*>& pathList);
+    static int getExpandedNodeCount(PathSearchContext* context);
+    static PathSearchContext* createSearchContext();
+    static void destroySearchContext(PathSearchContext* context);
+
+    static void setPathSearchMode(PathSearchMode pathSearchMode);
+    static PathSearchMode getPathSearchMode();
+    static int getLastSearchExpandedNodeCount();
 
 private:
-    static void reset();
+    static list<TileNode*> search(PathSearchContext& context, TileNode* startNode, TileNode* endNode);
+    static void beginSearch(PathSearchContext& context, TileNode* startNode, TileNode* endNode);
+    static void beginSearch(PathSearchContext& context, TileNode* startNode, const vector<TileNode*>& endNodeList);
+    static void addEndNode(PathSearchContext& context, TileNode* endNode);
+    static void addEndLandmarkDistance(PathSearchContext& context, int landmarkIndex, int distance);
+    static void pushStartNode(PathSearchContext& context, TileNode* startNode);
+    static PathSearchStatus continueSearch(PathSearchContext& context, int maxExpandedNodeCount, list<TileNode*>& pathList);
+    static void beginNewSearch(PathSearchContext& context);
+
+    static bool isPassable(PathSearchContext& context, int columnIndex, int rowIndex);
+    static bool isTileNodePassable(PathSearchContext& context, int columnIndex, int rowIndex);
+    static bool canVisit(PathSearchContext& context, int columnIndex, int rowIndex);
+    static bool isEndTileIndex(PathSearchContext& context, int tileIndex);
+    static int computeGotoEndNodeWeight(PathSearchContext& context, int columnIndex, int rowIndex);
+    static int computeWeightBetween(int fromColumnIndex, int fromRowIndex, int toColumnIndex, int toRowIndex);
+    static void tryUpdateSearchNode(PathSearchContext& context, int columnIndex, int rowIndex, int parentTileIndex, int newGotoStartNodeWeight);
+    static void expandNodesBeside(PathSearchContext& context, int tileIndex);
+    static list<TileNode*> getPathList(PathSearchContext& context, int endTileIndex);
+
+    static void expandJumpPoints(PathSearchContext& context, int tileIndex);
+    static void tryJumpTo(PathSearchContext& context, int columnIndex, int rowIndex, int columnDirection, int rowDirection, int parentTileIndex);
+    static bool jump(PathSearchContext& context, int& columnIndex, int& rowIndex, int columnDirection, int rowDirection);
+    static bool jumpStraight(PathSearchContext& context, int& columnIndex, int& rowIndex, int columnDirection, int rowDirection);
+    static bool hasForcedNeighbor(PathSearchContext& context, int columnIndex, int rowIndex, int columnDirection, int rowDirection);
 
-    static bool canVisit(TileNode* node);
-    static TileNode* findNextPathNodeBeside(TileNode* node);
-    static list<TileNode*> getPathList(TileNode* startNode, TileNode* endNode);
+    static bool isOpenListEmpty(PathSearchContext& context);
+    static void pushToOpenList(PathSearchContext& context, int tileIndex);
+    static int popFromOpenList(PathSearchContext& context);
+    static void siftUp(PathSearchContext& context, int heapIndex);
+    static void siftDown(PathSearchContext& context, int heapIndex);
+    static bool isHigherPriority(PathSearchContext& context, int leftTileIndex, int rightTileIndex);
+    static void swapHeapElement(PathSearchContext& context, int leftHeapIndex, int rightHeapIndex);
 
     AutoFindPathHelper();
     ~AutoFindPathHelper();
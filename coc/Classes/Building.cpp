@@ -4,6 +4,7 @@
 #include "TemplatesManager.h"
 #include "GameWorldCallBackFunctionsManager.h"
 #include "MapManager.h"
+#include "BuildingRouteHelper.h"
 #include <functional>
 #include "GameObjectManager.h"
 #include "Npc.h"
@@ -22,6 +23,19 @@ const string BEING_BUILT_PROGRESS_BAR = "PlayerHPBar.png";
 const string PLAYER_PILLBOX_NAME = "PlayerPillbox.png";
 const string AI_PILLBOX_NAME = "AIPillbox.png";
 
+static Vec2 computeNearestPositionOnSegment(const Vec2& position, const Vec2& beginPosition, const Vec2& endPosition)
+{
+    auto segment = endPosition - beginPosition;
+    float lengthSquared = segment.lengthSquared();
+    if (lengthSquared <= 0.0f)
+    {
+        return beginPosition;
+    }
+
+    float ratio = std::min(std::max((position - beginPosition).dot(segment) / lengthSquared, 0.0f), 1.0f);
+    return beginPosition + segment * ratio;
+}
+
 Building* Building::create(ForceType forceType, const string& buildingTemplateName, const Vec2& position, int uniqueID, int level)
 {
     auto building = new Building();
@@ -56,12 +70,12 @@ bool Building::init(ForceType forceType, const string& buildingTemplateName, con
     initBuildingStatusSprites(buildingTemplateName);
     initBottomGridSprites(buildingTemplateName);
 
-    // BuildingҪȸΪPrepareToBuild״̬
+    // 所有势力的Building都需要先更新为PrepareToBuild状态，
     updateStatus(BuildingStatus::PrepareToBuild);
 
     if (_forceType == ForceType::AI)
     {
-        // ֻеbuildingaddChildtileMapʱ׼ȷռЩӣҪʱµBeingBuilt״̬
+        // 只有当building被addChild到tileMap时，才能准确计算占用哪些格子，因此需要延时更新到BeingBuilt状态，
         delayUpdateAIForceBuildingToBeingBuiltStatus(position);
     }
 
@@ -246,6 +260,143 @@ void Building::initBottomGridInMapPositionList()
         _bottomGridInMapPositionList.push_back(bottomGridInMapPosition);
     }
 
+    initFootprintLattice();
+
+    GameObjectManager::getInstance()->updateSpatialIndexOf(this);
+}
+
+void Building::initFootprintLattice()
+{
+    auto buildingTemplate = TemplateManager::getInstance()->getBuildingTemplateBy(_templateName);
+    _footprintColumnCount = buildingTemplate->bottomGridColumnCount;
+    _footprintRowCount = buildingTemplate->bottomGridRowCount;
+
+    _isFootprintLatticeValid = false;
+    if (_footprintColumnCount <= 0 || _footprintRowCount <= 0 ||
+        (int)_bottomGridInMapPositionList.size() != _footprintColumnCount * _footprintRowCount)
+    {
+        return;
+    }
+
+    // 与initBottomGridSprites中的摆放方式一致，把相邻格子的偏移也变换到地图上，只有一行或者一列时同样可以得到两个方向
+    auto mapManager = GameWorldCallBackFunctionsManager::getInstance()->_getMapManager();
+    auto tileSize = mapManager->getTileSize();
+    auto firstBottomGrid = _bottomGridSpritesList.at(0);
+    auto parentNode = firstBottomGrid->getParent();
+    auto firstBottomGridPosition = firstBottomGrid->getPosition();
+    Vec2 columnOffset(tileSize.width / 2.0f, -tileSize.height / 2.0f);
+    Vec2 rowOffset(-tileSize.width / 2.0f, -tileSize.height / 2.0f);
+
+    _footprintOrigin = _bottomGridInMapPositionList.at(0);
+    _footprintColumnAxis = mapManager->convertToTileMapSpace(parentNode->convertToWorldSpace(firstBottomGridPosition + columnOffset)) - _footprintOrigin;
+    _footprintRowAxis = mapManager->convertToTileMapSpace(parentNode->convertToWorldSpace(firstBottomGridPosition + rowOffset)) - _footprintOrigin;
+
+    float area = std::abs(_footprintColumnAxis.cross(_footprintRowAxis));
+    if (area <= 0.0f)
+    {
+        return;
+    }
+
+    // 最近点落在边上时，边上离它最近的格子不超过半个格子间距；落在内部时，所在的平行四边形总有一个顶点不超过半条对角线；
+    // 再换算成列数和行数：相邻两列之间的垂直距离是area / |rowAxis|
+    float searchRadius = std::max(std::max(_footprintColumnAxis.length(), _footprintRowAxis.length()),
+        std::max((_footprintColumnAxis + _footprintRowAxis).length(), (_footprintColumnAxis - _footprintRowAxis).length())) / 2.0f;
+    _footprintColumnSearchMargin = searchRadius * _footprintRowAxis.length() / area;
+    _footprintRowSearchMargin = searchRadius * _footprintColumnAxis.length() / area;
+    _isFootprintLatticeValid = true;
+}
+
+Vec2 Building::convertToFootprintSpace(const Vec2& inMapPosition)
+{
+    // 解inMapPosition - origin = x * columnAxis + y * rowAxis，x是列坐标，y是行坐标
+    auto offset = inMapPosition - _footprintOrigin;
+    float determinant = _footprintColumnAxis.cross(_footprintRowAxis);
+
+    return Vec2(offset.cross(_footprintRowAxis) / determinant, _footprintColumnAxis.cross(offset) / determinant);
+}
+
+Vec2 Building::computeNearestPositionInFootprint(const Vec2& inMapPosition)
+{
+    auto footprintPosition = convertToFootprintSpace(inMapPosition);
+    float maxColumn = (float)(_footprintColumnCount - 1);
+    float maxRow = (float)(_footprintRowCount - 1);
+    if (footprintPosition.x >= 0.0f && footprintPosition.x <= maxColumn && footprintPosition.y >= 0.0f && footprintPosition.y <= maxRow)
+    {
+        return inMapPosition;
+    }
+
+    // 在外面时最近点在四条边之一上
+    Vec2 cornerList[4] = {
+        _footprintOrigin,
+        _footprintOrigin + _footprintColumnAxis * maxColumn,
+        _footprintOrigin + _footprintColumnAxis * maxColumn + _footprintRowAxis * maxRow,
+        _footprintOrigin + _footprintRowAxis * maxRow
+    };
+
+    Vec2 nearestPosition = cornerList[0];
+    float minDistanceSquared = FLT_MAX;
+    for (int i = 0; i < 4; i++)
+    {
+        auto position = computeNearestPositionOnSegment(inMapPosition, cornerList[i], cornerList[(i + 1) % 4]);
+        float distanceSquared = position.distanceSquared(inMapPosition);
+        if (distanceSquared < minDistanceSquared)
+        {
+            minDistanceSquared = distanceSquared;
+            nearestPosition = position;
+        }
+    }
+
+    return nearestPosition;
+}
+
+Vec2 Building::computeNearestBottomGridInMapPosition(const Vec2& inMapPosition)
+{
+    Vec2 result;
+
+    int nearestIndex = -1;
+    float minDistanceSquared = FLT_MAX;
+    if (_isFootprintLatticeValid)
+    {
+        auto footprintPosition = convertToFootprintSpace(computeNearestPositionInFootprint(inMapPosition));
+        int minColumnIndex = std::max((int)floor(footprintPosition.x - _footprintColumnSearchMargin), 0);
+        int maxColumnIndex = std::min((int)ceil(footprintPosition.x + _footprintColumnSearchMargin), _footprintColumnCount - 1);
+        int minRowIndex = std::max((int)floor(footprintPosition.y - _footprintRowSearchMargin), 0);
+        int maxRowIndex = std::min((int)ceil(footprintPosition.y + _footprintRowSearchMargin), _footprintRowCount - 1);
+
+        // 按列表中的顺序检查，距离相同时与遍历整个列表一样取靠前的格子
+        for (int rowIndex = minRowIndex; rowIndex <= maxRowIndex; rowIndex++)
+        {
+            for (int columnIndex = minColumnIndex; columnIndex <= maxColumnIndex; columnIndex++)
+            {
+                int index = rowIndex * _footprintColumnCount + columnIndex;
+                float distanceSquared = _bottomGridInMapPositionList[index].distanceSquared(inMapPosition);
+                if (distanceSquared < minDistanceSquared)
+                {
+                    minDistanceSquared = distanceSquared;
+                    nearestIndex = index;
+                }
+            }
+        }
+    }
+    else
+    {
+        for (int i = 0; i < (int)_bottomGridInMapPositionList.size(); i++)
+        {
+            float distanceSquared = _bottomGridInMapPositionList[i].distanceSquared(inMapPosition);
+            if (distanceSquared < minDistanceSquared)
+            {
+                minDistanceSquared = distanceSquared;
+                nearestIndex = i;
+            }
+        }
+    }
+
+    if (nearestIndex != -1)
+    {
+        result = _bottomGridInMapPositionList[nearestIndex];
+    }
+
+    return result;
 }
 
 Npc* Building::createDefenceNpc(const string& buildingTemplateName)
@@ -360,7 +511,7 @@ void Building::updateStatus(BuildingStatus buildingStatus)
                     initBottomGridInMapPositionList();
                 }
 
-                // ΪЩﲻҪ׶ξͿֱӽworking״̬Ҫٴθռøӵgid
+                // 因为有些建筑物不需要经历建造阶段就可以直接进入working状态，因此这里需要再次更新占用格子的gid
                 updateCoveredByBuildingTileNodesGID(OBSTACLE_ID);
 
                 selectedTipsYPosition = buildingTemplate->shadowYPositionInWorkingStatus;
@@ -400,6 +551,9 @@ void Building::updateStatus(BuildingStatus buildingStatus)
     }
 
     _buildingStatus = buildingStatus;
+
+    // 不同状态的图片大小不同，鼠标拾取的范围也要跟着更新
+    GameObjectManager::getInstance()->updateSpatialIndexOf(this);
 }
 
 BuildingStatus Building::getBuildingStatus()
@@ -461,10 +615,10 @@ void Building::ajustBuildingPosition(const Vec2& inMapPosition)
     auto prepareToBuildSprite = _buildingStatusSpriteMap[BuildingStatus::PrepareToBuild];
     auto prepareToBuildSpriteSize = prepareToBuildSprite->getContentSize();
 
-    // Ϊ˱֤͵ͼڵĸӱֶ룬ұ֤λλϣҪ²
-    // 1㵱λʱbuiding꣬ҪsetPositionΪҪȡλƺbottomGrid
-    // 2ҵbottomGrid꣬λһtileNodeڣһȡtileNode
-    // 3bottomGridtileNodeĵĲֵbuildingֵٴsetPositionԴﵽЧ
+    // 为了保证底座和地图内的格子保持对齐，并且保证底座中心位置位于鼠标光标上，需要按照如下步骤做
+    // 1）计算当底座中心位于鼠标光标上时，buiding的坐标，这里需要先setPosition，因为后面要取到经过位移后的bottomGrid的新坐标
+    // 2）找到bottomGrid的中心坐标，位于那一个tileNode内，并且获取tileNode的中心坐标
+    // 3）计算bottomGrid到tileNode中心的差值，并且让building坐标加上这个差值并且再次setPosition，以达到对齐效果
     Vec2 buildingPosition;
     buildingPosition.x = inMapPosition.x;
     buildingPosition.y = prepareToBuildSpriteSize.height / 2.0f - _bottomGridsPlaneCenterPositionInLocalSpace.y +
@@ -490,32 +644,7 @@ void Building::ajustBuildingPosition(const Vec2& inMapPosition)
 
 bool Building::isBottomGridCoverNpc(const Vec2& bottomGridInMapPosition)
 {
-    bool result = false;
-
-    auto mapManager = GameWorldCallBackFunctionsManager::getInstance()->_getMapManager();
-    auto coveredByBottomGridTileNodeSubscript = mapManager->getTileSubscript(bottomGridInMapPosition);
-    auto coveredByBotomGridTileNode = mapManager->getTileNodeAt((int)coveredByBottomGridTileNodeSubscript.x, (int)coveredByBottomGridTileNodeSubscript.y);
-
-    auto gameObjectManager = GameObjectManager::getInstance();
-    auto gameObjectMap = gameObjectManager->getGameObjectMap();
-    for (auto& gameObjectIter : gameObjectMap)
-    {
-        if (gameObjectIter.second->getGameObjectType() != GameObjectType::Npc)
-        {
-            continue;
-        }
-
-        auto gameObjectPosition = gameObjectIter.second->getPosition();
-        auto coveredByNpcTileNodeSubscript = mapManager->getTileSubscript(gameObjectPosition);
-        auto coveredByNpcTileNode = mapManager->getTileNodeAt((int)coveredByNpcTileNodeSubscript.x, (int)coveredByNpcTileNodeSubscript.y);
-        if (coveredByBotomGridTileNode == coveredByNpcTileNode)
-        {
-            result = true;
-            break;
-        }
-    }
-
-    return result;
+    return GameObjectManager::getInstance()->isTileCoveredByNpc(bottomGridInMapPosition);
 }
 
 vector<Sprite*> Building::getInObstacleTileNodeBottomGidSpriteList()
@@ -566,15 +695,24 @@ void Building::updateBottomGridTextureInPrepareToBuildStatus()
 
 void Building::updateCoveredByBuildingTileNodesGID(int tileNodeGID)
 {
-    auto bottomGridInMapPositionList = getBottomGridInMapPositionList();
     auto mapManager = GameWorldCallBackFunctionsManager::getInstance()->_getMapManager();
+    mapManager->updateTileNodesGID(getBottomGridInMapPositionList(), tileNodeGID);
 
-    for (auto& inMapPosition : bottomGridInMapPositionList)
+    // 占地格子变成障碍以后才能作为路线的两端，建造和拆除时只更新与这个建筑物有关的路线
+    if (tileNodeGID == OBSTACLE_ID)
     {
-        auto coveredByBottomGridTileNodeSubscript = mapManager->getTileSubscript(inMapPosition);
-        auto coveredByBottomGridTileNode = mapManager->getTileNodeAt((int)coveredByBottomGridTileNodeSubscript.x, (int)coveredByBottomGridTileNodeSubscript.y);
+        vector<TileNode*> footprintTileNodeList;
+        for (auto& bottomGridInMapPosition : getBottomGridInMapPositionList())
+        {
+            auto tileSubscript = mapManager->getTileSubscript(bottomGridInMapPosition);
+            footprintTileNodeList.push_back(mapManager->getTileNodeAt((int)tileSubscript.x, (int)tileSubscript.y));
+        }
 
-        coveredByBottomGridTileNode->gid = tileNodeGID;
+        BuildingRouteHelper::addBuilding(_uniqueID, footprintTileNodeList);
+    }
+    else
+    {
+        BuildingRouteHelper::removeBuilding(_uniqueID);
     }
 }
 
@@ -591,7 +729,7 @@ void Building::onUpdateAIForceBuildingStatus(const Vec2& inMapPosition, Building
 
     if (canBuild())
     {
-        // ֮Ҫ׶βż㽨ײ꣬ΪҪȵȵײ룬׼ȷ
+        // 之所以要在这个阶段才计算建筑物底部块的坐标，是因为要先等底部坐标和网格对齐，才能准确计算
         initBottomGridInMapPositionList();
         updateStatus(buildingStatus);
     }
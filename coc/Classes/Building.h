@@ -29,6 +29,8 @@ public:
 
     bool canBuild();
     const vector<Vec2>& getBottomGridInMapPositionList();
+    // 离inMapPosition最近的占地格子，与遍历所有占地格子的结果一致，只检查最近点附近的几个格子
+    Vec2 computeNearestBottomGridInMapPosition(const Vec2& inMapPosition);
 
     void setEnemyUniqueID(int uniqueID) override;
     int getEnemyUniqueID() override;
@@ -46,6 +48,9 @@ private:
     void initBattleData(const string& buildingTemplateName);
     void initSelectedTips(const string& buildingTemplateName);
     void initBottomGridInMapPositionList();
+    void initFootprintLattice();
+    Vec2 convertToFootprintSpace(const Vec2& inMapPosition);
+    Vec2 computeNearestPositionInFootprint(const Vec2& inMapPosition);
 
     Npc* createDefenceNpc(const string& buildingTemplateName);
     void removeDefenceNpc();
@@ -76,7 +81,7 @@ private:
 
     map<BuildingStatus, Sprite*> _buildingStatusSpriteMap;
     vector<Sprite*> _bottomGridSpritesList;
-    Vec2 _bottomGridsPlaneCenterPositionInLocalSpace; // ײƬλ
+    Vec2 _bottomGridsPlaneCenterPositionInLocalSpace; // 建筑物底部面片的中心位置
 
     BuildingStatus _buildingStatus;
     bool _canDestroy = true;
@@ -87,4 +92,14 @@ private:
     string _destroySpecialEffectTemplateName;
 
     vector<Vec2> _bottomGridInMapPositionList;
+
+    // 占地格子排成平行四边形，第i行第j列的格子在_footprintOrigin + j * _footprintColumnAxis + i * _footprintRowAxis
+    Vec2 _footprintOrigin;
+    Vec2 _footprintColumnAxis;
+    Vec2 _footprintRowAxis;
+    int _footprintColumnCount = 0;
+    int _footprintRowCount = 0;
+    float _footprintColumnSearchMargin = 0.0f;  // 最近的占地格子离最近点不会超过这么多列、这么多行
+    float _footprintRowSearchMargin = 0.0f;
+    bool _isFootprintLatticeValid = false;
 };
\ No newline at end of file
@@ -0,0 +1,366 @@
+#include "Base.h"
+#include "MapManager.h"
+#include "AutoFindPathHelper.h"
+#include "BuildingRouteHelper.h"
+
+const int BUILDING_UNIQUE_ID_NONE = 0;     // 与GAME_OBJECT_UNIQUE_ID_INVALID一致
+
+static NavigationGrid* g_navigationGrid = nullptr;
+static int g_maxColumnCount = 0;
+static int g_maxRowCount = 0;
+
+static map<int, vector<TileNode*>> g_buildingFootprintMap;
+static unordered_map<long long, BuildingRoute> g_routeMap;
+static set<long long> g_pendingRouteKeySet;
+static int g_hitCount = 0;
+
+static long long toRouteKey(int buildingUniqueID, int otherBuildingUniqueID)
+{
+    int smallerUniqueID = std::min(buildingUniqueID, otherBuildingUniqueID);
+    int largerUniqueID = std::max(buildingUniqueID, otherBuildingUniqueID);
+
+    return ((long long)smallerUniqueID << 32) | (unsigned int)largerUniqueID;
+}
+
+static bool isRouteKeyContains(long long routeKey, int buildingUniqueID)
+{
+    return (int)(routeKey >> 32) == buildingUniqueID || (int)(routeKey & 0xffffffff) == buildingUniqueID;
+}
+
+void BuildingRouteHelper::initNavigationGrid(NavigationGrid& navigationGrid)
+{
+    g_navigationGrid = &navigationGrid;
+    g_maxColumnCount = navigationGrid.columnCount;
+    g_maxRowCount = navigationGrid.rowCount;
+
+    g_buildingFootprintMap.clear();
+    g_routeMap.clear();
+    g_pendingRouteKeySet.clear();
+    g_hitCount = 0;
+}
+
+void BuildingRouteHelper::update()
+{
+    int buildCount = 0;
+    while (!g_pendingRouteKeySet.empty() && buildCount < MAX_ROUTE_BUILD_COUNT_PER_FRAME)
+    {
+        auto routeKey = *g_pendingRouteKeySet.begin();
+        g_pendingRouteKeySet.erase(g_pendingRouteKeySet.begin());
+
+        buildRoute(routeKey);
+        buildCount++;
+    }
+}
+
+void BuildingRouteHelper::onTileNodesGIDChanged(const vector<TileNode*>& tileNodeList)
+{
+    if (tileNodeList.empty())
+    {
+        return;
+    }
+
+    // 一次改变的格子gid都相同
+    if (tileNodeList.front()->gid == OBSTACLE_ID)
+    {
+        // 只有经过新障碍格的路线不能再走，其他路线仍然是最短的
+        set<TileNode*> changedTileNodeSet(tileNodeList.begin(), tileNodeList.end());
+        for (auto routeIter = g_routeMap.begin(); routeIter != g_routeMap.end();)
+        {
+            bool isBlocked = false;
+            for (auto tileNode : routeIter->second.tileNodePathList)
+            {
+                if (changedTileNodeSet.find(tileNode) != changedTileNodeSet.end())
+                {
+                    isBlocked = true;
+                    break;
+                }
+            }
+
+            if (isBlocked)
+            {
+                g_pendingRouteKeySet.insert(routeIter->first);
+                routeIter = g_routeMap.erase(routeIter);
+            }
+            else
+            {
+                ++routeIter;
+            }
+        }
+    }
+    else
+    {
+        // 原来的路线仍然可以走，只是可能绕远，先继续使用，排队重新计算；原来不连通的路线现在可能连通了
+        for (auto routeIter = g_routeMap.begin(); routeIter != g_routeMap.end();)
+        {
+            g_pendingRouteKeySet.insert(routeIter->first);
+            if (routeIter->second.tileNodePathList.empty())
+            {
+                routeIter = g_routeMap.erase(routeIter);
+            }
+            else
+            {
+                routeIter->second.isStale = true;
+                ++routeIter;
+            }
+        }
+    }
+}
+
+void BuildingRouteHelper::addBuilding(int buildingUniqueID, const vector<TileNode*>& footprintTileNodeList)
+{
+    if (footprintTileNodeList.empty() || g_buildingFootprintMap.find(buildingUniqueID) != g_buildingFootprintMap.end())
+    {
+        return;
+    }
+
+    for (auto& buildingFootprintIter : g_buildingFootprintMap)
+    {
+        addPendingRoute(buildingUniqueID, buildingFootprintIter.first);
+    }
+
+    g_buildingFootprintMap[buildingUniqueID] = footprintTileNodeList;
+}
+
+void BuildingRouteHelper::removeBuilding(int buildingUniqueID)
+{
+    if (g_buildingFootprintMap.erase(buildingUniqueID) == 0)
+    {
+        return;
+    }
+
+    for (auto routeIter = g_routeMap.begin(); routeIter != g_routeMap.end();)
+    {
+        if (isRouteKeyContains(routeIter->first, buildingUniqueID))
+        {
+            routeIter = g_routeMap.erase(routeIter);
+        }
+        else
+        {
+            ++routeIter;
+        }
+    }
+
+    for (auto routeKeyIter = g_pendingRouteKeySet.begin(); routeKeyIter != g_pendingRouteKeySet.end();)
+    {
+        if (isRouteKeyContains(*routeKeyIter, buildingUniqueID))
+        {
+            routeKeyIter = g_pendingRouteKeySet.erase(routeKeyIter);
+        }
+        else
+        {
+            ++routeKeyIter;
+        }
+    }
+}
+
+list<TileNode*> BuildingRouteHelper::computeTileNodePathListToBuilding(TileNode* startNode, int buildingUniqueID)
+{
+    list<TileNode*> tileNodePathList;
+
+    if (g_buildingFootprintMap.find(buildingUniqueID) == g_buildingFootprintMap.end())
+    {
+        return tileNodePathList;
+    }
+
+    int fromBuildingUniqueID = findNearbyBuildingUniqueID(startNode, buildingUniqueID);
+    if (fromBuildingUniqueID == BUILDING_UNIQUE_ID_NONE)
+    {
+        return tileNodePathList;
+    }
+
+    // 还没轮到计算的路线立即计算，出兵不需要等待
+    auto routeKey = toRouteKey(fromBuildingUniqueID, buildingUniqueID);
+    auto routeIter = g_routeMap.find(routeKey);
+    if (routeIter == g_routeMap.end())
+    {
+        g_pendingRouteKeySet.erase(routeKey);
+        buildRoute(routeKey);
+        routeIter = g_routeMap.find(routeKey);
+    }
+
+    if (routeIter == g_routeMap.end() || routeIter->second.tileNodePathList.empty())
+    {
+        return tileNodePathList;
+    }
+
+    if (fromBuildingUniqueID < buildingUniqueID)
+    {
+        tileNodePathList = joinRoute(startNode, routeIter->second.tileNodePathList);
+    }
+    else
+    {
+        list<TileNode*> reversedRoutePathList(routeIter->second.tileNodePathList.rbegin(), routeIter->second.tileNodePathList.rend());
+        tileNodePathList = joinRoute(startNode, reversedRoutePathList);
+    }
+
+    if (!tileNodePathList.empty())
+    {
+        g_hitCount++;
+    }
+
+    return tileNodePathList;
+}
+
+int BuildingRouteHelper::getRouteCount()
+{
+    return (int)g_routeMap.size();
+}
+
+int BuildingRouteHelper::getPendingRouteCount()
+{
+    return (int)g_pendingRouteKeySet.size();
+}
+
+int BuildingRouteHelper::getHitCount()
+{
+    return g_hitCount;
+}
+
+void BuildingRouteHelper::buildRoute(long long routeKey)
+{
+    auto fromFootprintIter = g_buildingFootprintMap.find((int)(routeKey >> 32));
+    auto toFootprintIter = g_buildingFootprintMap.find((int)(routeKey & 0xffffffff));
+    if (fromFootprintIter == g_buildingFootprintMap.end() || toFootprintIter == g_buildingFootprintMap.end())
+    {
+        g_routeMap.erase(routeKey);
+        return;
+    }
+
+    // 从出发建筑物靠近目标一侧、旁边有可通行格子的占地格子出发，两端都是占地格子，反过来走时也一样
+    TileNode* startNode = nullptr;
+    int minWeight = INT_MAX;
+    auto toNode = toFootprintIter->second.front();
+    for (auto footprintTileNode : fromFootprintIter->second)
+    {
+        bool hasPassableBesideNode = false;
+        for (int besideColumnIndex = max(footprintTileNode->columnIndex - 1, 0); besideColumnIndex <= min(footprintTileNode->columnIndex + 1, g_maxColumnCount - 1) && !hasPassableBesideNode; besideColumnIndex++)
+        {
+            for (int besideRowIndex = max(footprintTileNode->rowIndex - 1, 0); besideRowIndex <= min(footprintTileNode->rowIndex + 1, g_maxRowCount - 1); besideRowIndex++)
+            {
+                if (g_navigationGrid->passableList[besideColumnIndex * g_maxRowCount + besideRowIndex])
+                {
+                    hasPassableBesideNode = true;
+                    break;
+                }
+            }
+        }
+
+        int weight = computeWeightBetween(footprintTileNode, toNode);
+        if (hasPassableBesideNode && weight < minWeight)
+        {
+            minWeight = weight;
+            startNode = footprintTileNode;
+        }
+    }
+
+    BuildingRoute buildingRoute;
+    if (startNode)
+    {
+        buildingRoute.tileNodePathList = AutoFindPathHelper::computeTileNodePathListToNearest(startNode, toFootprintIter->second, true);
+    }
+
+    g_routeMap[routeKey] = buildingRoute;
+}
+
+void BuildingRouteHelper::addPendingRoute(int buildingUniqueID, int otherBuildingUniqueID)
+{
+    g_pendingRouteKeySet.insert(toRouteKey(buildingUniqueID, otherBuildingUniqueID));
+}
+
+int BuildingRouteHelper::findNearbyBuildingUniqueID(TileNode* startNode, int exceptBuildingUniqueID)
+{
+    int nearbyBuildingUniqueID = BUILDING_UNIQUE_ID_NONE;
+    int minDistance = BUILDING_ROUTE_JOIN_RANGE + 1;
+
+    for (auto& buildingFootprintIter : g_buildingFootprintMap)
+    {
+        if (buildingFootprintIter.first == exceptBuildingUniqueID)
+        {
+            continue;
+        }
+
+        for (auto footprintTileNode : buildingFootprintIter.second)
+        {
+            int distance = max(abs(footprintTileNode->columnIndex - startNode->columnIndex), abs(footprintTileNode->rowIndex - startNode->rowIndex));
+            if (distance < minDistance)
+            {
+                minDistance = distance;
+                nearbyBuildingUniqueID = buildingFootprintIter.first;
+            }
+        }
+    }
+
+    return nearbyBuildingUniqueID;
+}
+
+list<TileNode*> BuildingRouteHelper::joinRoute(TileNode* startNode, const list<TileNode*>& routePathList)
+{
+    list<TileNode*> tileNodePathList;
+
+    // 在路线上找一个格子，使得从startNode直线过去的估计代价加上沿路线走到终点的代价最小；
+    // 路线两端的占地格子不能作为接入点，终点格子除外
+    auto joinIter = routePathList.end();
+    int minWeight = INT_MAX;
+    int gotoEndWeight = 0;
+    TileNode* lastRouteNode = nullptr;
+    for (auto routeIter = routePathList.begin(); routeIter != routePathList.end(); ++routeIter)
+    {
+        auto routeNode = *routeIter;
+        if (lastRouteNode)
+        {
+            gotoEndWeight += computeWeightBetween(lastRouteNode, routeNode);
+        }
+        lastRouteNode = routeNode;
+
+        bool isPassable = g_navigationGrid->passableList[routeNode->columnIndex * g_maxRowCount + routeNode->rowIndex];
+        if (!isPassable && routeIter != routePathList.begin())
+        {
+            continue;
+        }
+
+        int weight = computeWeightBetween(startNode, routeNode) + gotoEndWeight;
+        if (weight < minWeight)
+        {
+            minWeight = weight;
+            joinIter = routeIter;
+        }
+    }
+
+    if (joinIter == routePathList.end())
+    {
+        return tileNodePathList;
+    }
+
+    auto joinNode = *joinIter;
+    list<TileNode*> joinPathList;
+    if (joinNode == startNode)
+    {
+        joinPathList.push_back(startNode);
+    }
+    else
+    {
+        int minColumnIndex = max(min(startNode->columnIndex, joinNode->columnIndex) - BUILDING_ROUTE_LOCAL_SEARCH_MARGIN, 0);
+        int minRowIndex = max(min(startNode->rowIndex, joinNode->rowIndex) - BUILDING_ROUTE_LOCAL_SEARCH_MARGIN, 0);
+        int maxColumnIndex = min(max(startNode->columnIndex, joinNode->columnIndex) + BUILDING_ROUTE_LOCAL_SEARCH_MARGIN, g_maxColumnCount - 1);
+        int maxRowIndex = min(max(startNode->rowIndex, joinNode->rowIndex) + BUILDING_ROUTE_LOCAL_SEARCH_MARGIN, g_maxRowCount - 1);
+        joinPathList = AutoFindPathHelper::computeTileNodePathListInArea(startNode, joinNode, minColumnIndex, minRowIndex, maxColumnIndex, maxRowIndex,
+            joinIter == routePathList.begin());
+    }
+
+    if (!joinPathList.empty())
+    {
+        // 路线从终点到接入点之前的部分，再接上从接入点到startNode的部分
+        tileNodePathList.assign(routePathList.begin(), joinIter);
+        tileNodePathList.insert(tileNodePathList.end(), joinPathList.begin(), joinPathList.end());
+    }
+
+    return tileNodePathList;
+}
+
+int BuildingRouteHelper::computeWeightBetween(TileNode* fromNode, TileNode* toNode)
+{
+    int columnDistance = abs(fromNode->columnIndex - toNode->columnIndex);
+    int rowDistance = abs(fromNode->rowIndex - toNode->rowIndex);
+
+    return MOVE_SLOP_WEIGHT * min(columnDistance, rowDistance) + MOVE_STRAIGHT_WEIGHT * abs(columnDistance - rowDistance);
+}
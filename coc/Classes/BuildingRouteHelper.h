@@ -0,0 +1,44 @@
+#pragma once
+
+const int MAX_ROUTE_BUILD_COUNT_PER_FRAME = 2;
+const int BUILDING_ROUTE_JOIN_RANGE = 6;           // npc离出发建筑物的占地格子不超过这么多格时才使用路线表
+const int BUILDING_ROUTE_LOCAL_SEARCH_MARGIN = 4;  // 从npc所在格子接到路线上时，只在两者外扩这么多格子的范围内寻路
+
+// 每两个建筑物的占地格子之间的路线，格式与AutoFindPathHelper一致，终点在前；
+// 只保存从uniqueID较小的建筑物到较大的建筑物这一个方向，反过来走时把格子顺序倒过来
+struct BuildingRoute
+{
+    list<TileNode*> tileNodePathList;   // 为空表示两个建筑物之间不连通
+    bool isStale = false;               // 格子变成可通行以后可能有更短的路线，重新计算之前仍然可以使用
+};
+
+// 建筑物之间的路线表：建筑物很少，而且大部分时间不动，出兵和支援时不再每个npc各自寻路，
+// 而是查表取出路线，只需要从npc所在的格子寻路接到路线上
+class BuildingRouteHelper
+{
+public:
+    static void initNavigationGrid(NavigationGrid& navigationGrid);
+    static void update();   // 每帧最多计算MAX_ROUTE_BUILD_COUNT_PER_FRAME条缺少或者过期的路线
+    static void onTileNodesGIDChanged(const vector<TileNode*>& tileNodeList);
+
+    // 占地格子变成障碍以后登记，重复登记同一个建筑物时忽略
+    static void addBuilding(int buildingUniqueID, const vector<TileNode*>& footprintTileNodeList);
+    static void removeBuilding(int buildingUniqueID);
+
+    // startNode附近没有登记过的建筑物，或者路线接不上时返回空列表，调用者改用普通寻路
+    static list<TileNode*> computeTileNodePathListToBuilding(TileNode* startNode, int buildingUniqueID);
+
+    static int getRouteCount();
+    static int getPendingRouteCount();
+    static int getHitCount();
+
+private:
+    static void buildRoute(long long routeKey);
+    static void addPendingRoute(int buildingUniqueID, int otherBuildingUniqueID);
+    static int findNearbyBuildingUniqueID(TileNode* startNode, int exceptBuildingUniqueID);
+    static list<TileNode*> joinRoute(TileNode* startNode, const list<TileNode*>& routePathList);
+    static int computeWeightBetween(TileNode* fromNode, TileNode* toNode);
+
+    BuildingRouteHelper();
+    ~BuildingRouteHelper();
+};
@@ -5,6 +5,8 @@
 #include "GameObjectManager.h"
 #include "Utils.h"
 #include "GameWorldCallBackFunctionsManager.h"
+#include <algorithm>
+#include <random>
 
 static BulletManager* s_bulletManager = nullptr;
 
@@ -54,7 +56,14 @@ Node* BulletManager::createBullet(BulletType bulletType, int attackerID, int att
         CallFunc* onMoveEnd = nullptr;
         if (attacker->getDamageType() == DamageType::AreaOfEffect)
         {
-            onMoveEnd = CallFunc::create(CC_CALLBACK_0(BulletManager::onAOEDamageBulletMoveEnd, this, bullet, bulletType, attacker, targetPosition));
+            AOEDamage aoeDamage;
+            aoeDamage.endPosition = targetPosition;
+            aoeDamage.attackerForceType = attacker->getForceType();
+            aoeDamage.aoeDamageRadius = attacker->getAoeDamageRadius();
+            aoeDamage.damageAmount = attacker->getAttackPower();
+            aoeDamage.bulletType = bulletType;
+
+            onMoveEnd = CallFunc::create(CC_CALLBACK_0(BulletManager::onAOEDamageBulletMoveEnd, this, bullet, aoeDamage));
         }
         else
         {
@@ -88,12 +97,68 @@ void BulletManager::onNormalDamageBulletMoveEnd(Node* bullet, BulletType bulletT
     bullet->autorelease();
 }
 
-void BulletManager::onAOEDamageBulletMoveEnd(Node* bullet, BulletType bulletType, GameObject* attacker, const Vec2& endPosition)
+void BulletManager::onAOEDamageBulletMoveEnd(Node* bullet, const AOEDamage& aoeDamage)
 {
-    auto attackerForceType = attacker->getForceType();
-    auto attackerAoeDamageRadius = attacker->getAoeDamageRadius();
-    auto attackerDamagePower = attacker->getAttackPower();
+    _pendingAOEDamageList.push_back(aoeDamage);
+
+    onCreateSpecialEffect(aoeDamage.bulletType, aoeDamage.endPosition);
 
+    bullet->retain();
+    bullet->removeFromParent();
+    bullet->autorelease();
+}
+
+void BulletManager::update()
+{
+    if (_pendingAOEDamageList.empty())
+    {
+        return;
+    }
+
+    // 先找出所有炮弹击中的目标再一起扣血，前一发炮弹打死的目标不会影响后面炮弹的查询
+    _aoeDamageHitList.clear();
+    for (auto& aoeDamage : _pendingAOEDamageList)
+    {
+        collectAOEDamageHits(aoeDamage, _aoeDamageHitList);
+    }
+    _pendingAOEDamageList.clear();
+
+    mergeAOEDamageHits(_aoeDamageHitList);
+    for (auto& hit : _aoeDamageHitList)
+    {
+        hit.gameObject->costHP(hit.damageAmount);
+    }
+}
+
+void BulletManager::collectAOEDamageHits(const AOEDamage& aoeDamage, vector<AOEDamageHit>& hitList)
+{
+    GameObjectQueryFilter filter;
+    filter.forceType = aoeDamage.attackerForceType == ForceType::Player ? ForceType::AI : ForceType::Player;
+
+    GameObjectManager::getInstance()->queryGameObjectsInRadius(aoeDamage.endPosition, aoeDamage.aoeDamageRadius, filter, _nearbyGameObjectList);
+    for (auto gameObject : _nearbyGameObjectList)
+    {
+        if (gameObject->getGameObjectType() == GameObjectType::DefenceInBuildingNpc)
+        {
+            continue;
+        }
+
+        // 查询只按包围盒筛选，命中仍然按照到对象位置的距离判断
+        auto distance = GameUtils::computeDistanceBetween(aoeDamage.endPosition, gameObject->getPosition());
+        if (distance <= aoeDamage.aoeDamageRadius)
+        {
+            AOEDamageHit hit;
+            hit.uniqueID = gameObject->getUniqueID();
+            hit.gameObject = gameObject;
+            hit.damageAmount = aoeDamage.damageAmount;
+            hitList.push_back(hit);
+        }
+    }
+}
+
+void BulletManager::collectAOEDamageHitsByFullScan(const AOEDamage& aoeDamage, vector<AOEDamageHit>& hitList)
+{
+    // 原来的做法，只在基准测试中作为对照
     auto gameObjectsMap = GameObjectManager::getInstance()->getGameObjectMap();
 
     vector<int> attackedTargetUniqueIDList;
@@ -101,15 +166,15 @@ void BulletManager::onAOEDamageBulletMoveEnd(Node* bullet, BulletType bulletType
     {
         auto gameObject = gameObjectIter.second;
         if (gameObject->isReadyToRemove() ||
-            gameObject->getForceType() == attackerForceType ||
+            gameObject->getForceType() == aoeDamage.attackerForceType ||
             gameObject->getGameObjectType() == GameObjectType::DefenceInBuildingNpc)
         {
             continue;
         }
 
         auto gameObjectPosition = gameObject->getPosition();
-        auto distance = GameUtils::computeDistanceBetween(endPosition, gameObjectPosition);
-        if (distance <= attackerAoeDamageRadius)
+        auto distance = GameUtils::computeDistanceBetween(aoeDamage.endPosition, gameObjectPosition);
+        if (distance <= aoeDamage.aoeDamageRadius)
         {
             attackedTargetUniqueIDList.push_back(gameObject->getUniqueID());
         }
@@ -118,14 +183,91 @@ void BulletManager::onAOEDamageBulletMoveEnd(Node* bullet, BulletType bulletType
     for (auto uniqueID : attackedTargetUniqueIDList)
     {
         auto gameObjectIter = gameObjectsMap.find(uniqueID);
-        gameObjectIter->second->costHP(attackerDamagePower);
+
+        AOEDamageHit hit;
+        hit.uniqueID = uniqueID;
+        hit.gameObject = gameObjectIter->second;
+        hit.damageAmount = aoeDamage.damageAmount;
+        hitList.push_back(hit);
+    }
+}
+
+static bool isHitUniqueIDLess(const AOEDamageHit& left, const AOEDamageHit& right)
+{
+    return left.uniqueID < right.uniqueID;
+}
+
+void BulletManager::mergeAOEDamageHits(vector<AOEDamageHit>& hitList)
+{
+    // 同一个目标被多发炮弹击中时伤害相加，只调用一次costHP，不会重复触发死亡
+    std::sort(hitList.begin(), hitList.end(), isHitUniqueIDLess);
+
+    int mergedCount = 0;
+    for (int hitIndex = 0; hitIndex < (int)hitList.size(); hitIndex++)
+    {
+        if (mergedCount > 0 && hitList[mergedCount - 1].uniqueID == hitList[hitIndex].uniqueID)
+        {
+            hitList[mergedCount - 1].damageAmount += hitList[hitIndex].damageAmount;
+        }
+        else
+        {
+            hitList[mergedCount] = hitList[hitIndex];
+            mergedCount++;
+        }
     }
+    hitList.resize(mergedCount);
+}
 
-    onCreateSpecialEffect(bulletType, endPosition);
+AOEDamageBenchmarkReport BulletManager::runAOEDamageBenchmark(int impactCount)
+{
+    AOEDamageBenchmarkReport report;
+    report.impactCount = impactCount;
 
-    bullet->retain();
-    bullet->removeFromParent();
-    bullet->autorelease();
+    auto& gameObjectMap = GameObjectManager::getInstance()->getGameObjectMap();
+    if (gameObjectMap.empty() || impactCount <= 0)
+    {
+        return report;
+    }
+
+    vector<GameObject*> gameObjectList;
+    for (auto& gameObjectIter : gameObjectMap)
+    {
+        gameObjectList.push_back(gameObjectIter.second);
+    }
+
+    // 落点取在随机对象附近，和实战中炮弹落在人群里的情况一致；种子固定，每次生成的落点相同
+    std::mt19937 randomEngine(AOE_BENCHMARK_RANDOM_SEED);
+    std::uniform_real_distribution<float> offsetDistribution(-AOE_BENCHMARK_DAMAGE_RADIUS, AOE_BENCHMARK_DAMAGE_RADIUS);
+    vector<AOEDamage> aoeDamageList(impactCount);
+    for (auto& aoeDamage : aoeDamageList)
+    {
+        auto gameObject = gameObjectList[randomEngine() % gameObjectList.size()];
+        aoeDamage.endPosition = gameObject->getPosition() + Vec2(offsetDistribution(randomEngine), offsetDistribution(randomEngine));
+        aoeDamage.attackerForceType = gameObject->getForceType() == ForceType::Player ? ForceType::AI : ForceType::Player;
+        aoeDamage.aoeDamageRadius = AOE_BENCHMARK_DAMAGE_RADIUS;
+        aoeDamage.damageAmount = 1;
+    }
+
+    vector<AOEDamageHit> hitList;
+    auto startMicroseconds = GameUtils::getMicroseconds();
+    for (auto& aoeDamage : aoeDamageList)
+    {
+        collectAOEDamageHitsByFullScan(aoeDamage, hitList);
+    }
+    report.fullScanMicroseconds = GameUtils::getMicroseconds() - startMicroseconds;
+    report.fullScanHitCount = (int)hitList.size();
+
+    hitList.clear();
+    startMicroseconds = GameUtils::getMicroseconds();
+    for (auto& aoeDamage : aoeDamageList)
+    {
+        collectAOEDamageHits(aoeDamage, hitList);
+    }
+    report.indexedHitCount = (int)hitList.size();
+    mergeAOEDamageHits(hitList);
+    report.indexedMicroseconds = GameUtils::getMicroseconds() - startMicroseconds;
+
+    return report;
 }
 
 void BulletManager::onCreateSpecialEffect(BulletType bulletType, const Vec2& inMapPosition)
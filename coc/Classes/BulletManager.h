@@ -2,18 +2,62 @@
 
 class GameObject;
 
+const int AOE_BENCHMARK_IMPACT_COUNT = 200;
+const float AOE_BENCHMARK_DAMAGE_RADIUS = 100.0f;
+const unsigned int AOE_BENCHMARK_RANDOM_SEED = 20150601;
+
+// 炮弹发射时记下攻击者的数据，落地时攻击者可能已经死亡
+struct AOEDamage
+{
+    Vec2 endPosition;
+    ForceType attackerForceType = ForceType::Invalid;
+    float aoeDamageRadius = 0.0f;
+    int damageAmount = 0;
+    BulletType bulletType = BulletType::Invalid;
+};
+
+struct AOEDamageHit
+{
+    int uniqueID = 0;
+    GameObject* gameObject = nullptr;
+    int damageAmount = 0;
+};
+
+struct AOEDamageBenchmarkReport
+{
+    int impactCount = 0;
+    int fullScanHitCount = 0;
+    int indexedHitCount = 0;
+    double fullScanMicroseconds = 0.0;
+    double indexedMicroseconds = 0.0;
+};
+
 class BulletManager
 {
 public:
     static BulletManager* getInstance();
     Node* createBullet(BulletType bulletType, int attackerID, int attackTargetID);
+
+    // 每帧调用一次，把这一帧落地的AOE炮弹一起结算，每个目标只扣一次血
+    void update();
+
+    // 在当前战场上随机生成impactCount个同时落地的AOE，对比逐个遍历所有对象和空间索引查询的耗时，不扣血
+    AOEDamageBenchmarkReport runAOEDamageBenchmark(int impactCount);
 private:
     void onNormalDamageBulletMoveEnd(Node* bullet, BulletType bulletType, int attackTargetID, int damageAmount);
-    void onAOEDamageBulletMoveEnd(Node* bullet, BulletType bulletType, GameObject* attacker, const Vec2& endPosition);
+    void onAOEDamageBulletMoveEnd(Node* bullet, const AOEDamage& aoeDamage);
+
+    void collectAOEDamageHits(const AOEDamage& aoeDamage, vector<AOEDamageHit>& hitList);
+    void collectAOEDamageHitsByFullScan(const AOEDamage& aoeDamage, vector<AOEDamageHit>& hitList);
+    void mergeAOEDamageHits(vector<AOEDamageHit>& hitList);
 
     void onCreateSpecialEffect(BulletType bulletType, const Vec2& inMapPosition);
 
     BulletManager(){}
     BulletManager(const BulletManager&);
     BulletManager& operator = (const BulletManager&);
-};
\ No newline at end of file
+
+    vector<AOEDamage> _pendingAOEDamageList;
+    vector<AOEDamageHit> _aoeDamageHitList;
+    vector<GameObject*> _nearbyGameObjectList;
+};
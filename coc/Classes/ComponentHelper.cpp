@@ -0,0 +1,404 @@
+#include "Base.h"
+#include "MapManager.h"
+#include "ComponentHelper.h"
+#include <algorithm>
+
+struct ComponentSearchGroup
+{
+    vector<int> tileIndexList;  // 访问过的格子，headIndex之后的还没有展开
+    int headIndex = 0;
+    int mergedGroupIndex = -1;  // 与另一组相遇以后并入那一组
+    bool isFinished = false;
+};
+
+static int findComponentSearchGroupIndex(const vector<ComponentSearchGroup>& groupList, int groupIndex)
+{
+    while (groupList[groupIndex].mergedGroupIndex != -1)
+    {
+        groupIndex = groupList[groupIndex].mergedGroupIndex;
+    }
+
+    return groupIndex;
+}
+
+static void mergeComponentSearchGroup(vector<ComponentSearchGroup>& groupList, int groupIndex, int otherGroupIndex)
+{
+    auto& group = groupList[groupIndex];
+    auto& otherGroup = groupList[otherGroupIndex];
+
+    // 两组展开过的格子放在前面，还没有展开的放在后面
+    vector<int> tileIndexList;
+    tileIndexList.reserve(group.tileIndexList.size() + otherGroup.tileIndexList.size());
+    tileIndexList.insert(tileIndexList.end(), group.tileIndexList.begin(), group.tileIndexList.begin() + group.headIndex);
+    tileIndexList.insert(tileIndexList.end(), otherGroup.tileIndexList.begin(), otherGroup.tileIndexList.begin() + otherGroup.headIndex);
+    tileIndexList.insert(tileIndexList.end(), group.tileIndexList.begin() + group.headIndex, group.tileIndexList.end());
+    tileIndexList.insert(tileIndexList.end(), otherGroup.tileIndexList.begin() + otherGroup.headIndex, otherGroup.tileIndexList.end());
+
+    group.headIndex += otherGroup.headIndex;
+    group.tileIndexList.swap(tileIndexList);
+    otherGroup.tileIndexList.clear();
+    otherGroup.mergedGroupIndex = groupIndex;
+}
+
+static NavigationGrid* g_navigationGrid = nullptr;
+
+// 障碍格为COMPONENT_ID_INVALID；区域合并时只修改g_componentParentList
+static vector<int> g_componentIDList;
+static vector<int> g_componentParentList;
+static vector<int> g_componentSearchGroupIndexList;   // 检查区域是否被分割时，每个格子被哪一组搜索访问过，不搜索时都是-1
+static int g_compactCount = 0;
+
+void ComponentHelper::initNavigationGrid(NavigationGrid& navigationGrid)
+{
+    g_navigationGrid = &navigationGrid;
+
+    int maxRowCount = g_navigationGrid->rowCount;
+
+    g_componentIDList.assign(g_navigationGrid->tileNodeList.size(), COMPONENT_ID_INVALID);
+    g_componentParentList.clear();
+    g_compactCount = 0;
+    g_componentSearchGroupIndexList.assign(g_navigationGrid->tileNodeList.size(), -1);
+
+    for (int columnIndex = 0; columnIndex < g_navigationGrid->columnCount; columnIndex++)
+    {
+        for (int rowIndex = 0; rowIndex < maxRowCount; rowIndex++)
+        {
+            int tileIndex = columnIndex * maxRowCount + rowIndex;
+            if (g_navigationGrid->passableList[tileIndex] && g_componentIDList[tileIndex] == COMPONENT_ID_INVALID)
+            {
+                floodFillComponent(columnIndex, rowIndex, createComponentID());
+            }
+        }
+    }
+}
+
+void ComponentHelper::onTileNodesGIDChanged(const vector<TileNode*>& tileNodeList)
+{
+    if (tileNodeList.empty())
+    {
+        return;
+    }
+
+    auto tileNode = tileNodeList.front();
+    if (g_navigationGrid->passableList[tileNode->columnIndex * g_navigationGrid->rowCount + tileNode->rowIndex])
+    {
+        onTileNodesBecomePassable(tileNodeList);
+    }
+    else
+    {
+        onTileNodesBecomeObstacle(tileNodeList);
+    }
+
+    if ((int)g_componentParentList.size() > COMPONENT_ID_COMPACT_FACTOR * (int)g_componentIDList.size())
+    {
+        compactComponentIDList();
+        g_compactCount++;
+    }
+}
+
+bool ComponentHelper::isTileNodeReachable(TileNode* startNode, TileNode* endNode, bool isEndTileNodePassable)
+{
+    bool result = false;
+
+    if (startNode == endNode)
+    {
+        result = true;
+    }
+    else if (endNode->gid != OBSTACLE_ID || isEndTileNodePassable)
+    {
+        vector<int> startComponentIDList;
+        vector<int> endComponentIDList;
+        getBesideComponentIDList(startNode, startComponentIDList);
+        getBesideComponentIDList(endNode, endComponentIDList);
+
+        for (auto startComponentID : startComponentIDList)
+        {
+            if (std::find(endComponentIDList.begin(), endComponentIDList.end(), startComponentID) != endComponentIDList.end())
+            {
+                result = true;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+int ComponentHelper::getComponentParentCount()
+{
+    return (int)g_componentParentList.size();
+}
+
+int ComponentHelper::getCompactCount()
+{
+    return g_compactCount;
+}
+
+void ComponentHelper::onTileNodesBecomeObstacle(const vector<TileNode*>& tileNodeList)
+{
+    int maxRowCount = g_navigationGrid->rowCount;
+    for (auto tileNode : tileNodeList)
+    {
+        g_componentIDList[tileNode->columnIndex * maxRowCount + tileNode->rowIndex] = COMPONENT_ID_INVALID;
+    }
+
+    // 原来的连通区域只可能在新障碍格周围被分割开：把周围的可通行格子按照原来的区域分组，
+    // 每一组分别检查是否仍然连通，其他区域的编号保持不变
+    vector<int> besideComponentIDList;
+    vector<vector<int>> seedTileIndexListList;
+    for (auto tileNode : tileNodeList)
+    {
+        int minColumnIndex = std::max(tileNode->columnIndex - 1, 0);
+        int maxColumnIndex = std::min(tileNode->columnIndex + 1, g_navigationGrid->columnCount - 1);
+        int minRowIndex = std::max(tileNode->rowIndex - 1, 0);
+        int maxRowIndex = std::min(tileNode->rowIndex + 1, maxRowCount - 1);
+
+        for (int columnIndex = minColumnIndex; columnIndex <= maxColumnIndex; columnIndex++)
+        {
+            for (int rowIndex = minRowIndex; rowIndex <= maxRowIndex; rowIndex++)
+            {
+                int tileIndex = columnIndex * maxRowCount + rowIndex;
+                if (g_componentIDList[tileIndex] == COMPONENT_ID_INVALID)
+                {
+                    continue;
+                }
+
+                int componentID = findComponentID(g_componentIDList[tileIndex]);
+                int componentIndex = (int)(std::find(besideComponentIDList.begin(), besideComponentIDList.end(), componentID) - besideComponentIDList.begin());
+                if (componentIndex == (int)besideComponentIDList.size())
+                {
+                    besideComponentIDList.push_back(componentID);
+                    seedTileIndexListList.push_back(vector<int>());
+                }
+
+                auto& seedTileIndexList = seedTileIndexListList[componentIndex];
+                if (std::find(seedTileIndexList.begin(), seedTileIndexList.end(), tileIndex) == seedTileIndexList.end())
+                {
+                    seedTileIndexList.push_back(tileIndex);
+                }
+            }
+        }
+    }
+
+    for (auto& seedTileIndexList : seedTileIndexListList)
+    {
+        if (seedTileIndexList.size() > 1)
+        {
+            splitComponentIfSeparated(seedTileIndexList);
+        }
+    }
+}
+
+void ComponentHelper::onTileNodesBecomePassable(const vector<TileNode*>& tileNodeList)
+{
+    int maxRowCount = g_navigationGrid->rowCount;
+    for (auto tileNode : tileNodeList)
+    {
+        // 新的可通行格子把周围的区域连成一个，只需要合并编号；周围没有可通行格子时才需要新编号
+        vector<int> besideComponentIDList;
+        getBesideComponentIDList(tileNode, besideComponentIDList);
+
+        int tileIndex = tileNode->columnIndex * maxRowCount + tileNode->rowIndex;
+        g_componentIDList[tileIndex] = besideComponentIDList.empty() ? createComponentID() : besideComponentIDList.front();
+        for (auto besideComponentID : besideComponentIDList)
+        {
+            g_componentParentList[besideComponentID] = g_componentIDList[tileIndex];
+        }
+    }
+}
+
+void ComponentHelper::floodFillComponent(int columnIndex, int rowIndex, int componentID)
+{
+    int maxColumnCount = g_navigationGrid->columnCount;
+    int maxRowCount = g_navigationGrid->rowCount;
+
+    vector<int> openTileIndexList;
+    openTileIndexList.push_back(columnIndex * maxRowCount + rowIndex);
+    g_componentIDList[openTileIndexList.back()] = componentID;
+
+    while (!openTileIndexList.empty())
+    {
+        int tileIndex = openTileIndexList.back();
+        openTileIndexList.pop_back();
+
+        int currentColumnIndex = tileIndex / maxRowCount;
+        int currentRowIndex = tileIndex % maxRowCount;
+        for (int besideColumnIndex = std::max(currentColumnIndex - 1, 0); besideColumnIndex <= std::min(currentColumnIndex + 1, maxColumnCount - 1); besideColumnIndex++)
+        {
+            for (int besideRowIndex = std::max(currentRowIndex - 1, 0); besideRowIndex <= std::min(currentRowIndex + 1, maxRowCount - 1); besideRowIndex++)
+            {
+                int besideTileIndex = besideColumnIndex * maxRowCount + besideRowIndex;
+                if (g_navigationGrid->passableList[besideTileIndex] && g_componentIDList[besideTileIndex] != componentID)
+                {
+                    g_componentIDList[besideTileIndex] = componentID;
+                    openTileIndexList.push_back(besideTileIndex);
+                }
+            }
+        }
+    }
+}
+
+void ComponentHelper::splitComponentIfSeparated(const vector<int>& seedTileIndexList)
+{
+    int maxColumnCount = g_navigationGrid->columnCount;
+    int maxRowCount = g_navigationGrid->rowCount;
+
+    // 从每个种子格子同时展开搜索，相遇的两组合并成一组；某一组搜索完时它就是被分割出去的一块，换一个新编号；
+    // 只剩下一组还在搜索时就可以停下，剩下的部分保留原来的编号。没有被分割时种子格子彼此相邻，几步之内就全部合并，
+    // 被分割时也只需要搜索完较小的那些部分
+    vector<ComponentSearchGroup> groupList(seedTileIndexList.size());
+    for (int groupIndex = 0; groupIndex < (int)seedTileIndexList.size(); groupIndex++)
+    {
+        groupList[groupIndex].tileIndexList.push_back(seedTileIndexList[groupIndex]);
+        g_componentSearchGroupIndexList[seedTileIndexList[groupIndex]] = groupIndex;
+    }
+
+    int searchingGroupCount = (int)groupList.size();
+    while (searchingGroupCount > 1)
+    {
+        for (int groupIndex = 0; groupIndex < (int)groupList.size() && searchingGroupCount > 1; groupIndex++)
+        {
+            auto& group = groupList[groupIndex];
+            if (group.isFinished || group.mergedGroupIndex != -1)
+            {
+                continue;
+            }
+
+            if (group.headIndex == (int)group.tileIndexList.size())
+            {
+                int componentID = createComponentID();
+                for (auto tileIndex : group.tileIndexList)
+                {
+                    g_componentIDList[tileIndex] = componentID;
+                }
+
+                group.isFinished = true;
+                searchingGroupCount--;
+                continue;
+            }
+
+            int tileIndex = group.tileIndexList[group.headIndex++];
+            int currentColumnIndex = tileIndex / maxRowCount;
+            int currentRowIndex = tileIndex % maxRowCount;
+            for (int besideColumnIndex = std::max(currentColumnIndex - 1, 0); besideColumnIndex <= std::min(currentColumnIndex + 1, maxColumnCount - 1); besideColumnIndex++)
+            {
+                for (int besideRowIndex = std::max(currentRowIndex - 1, 0); besideRowIndex <= std::min(currentRowIndex + 1, maxRowCount - 1); besideRowIndex++)
+                {
+                    int besideTileIndex = besideColumnIndex * maxRowCount + besideRowIndex;
+                    if (!g_navigationGrid->passableList[besideTileIndex])
+                    {
+                        continue;
+                    }
+
+                    int besideGroupIndex = g_componentSearchGroupIndexList[besideTileIndex];
+                    if (besideGroupIndex == -1)
+                    {
+                        g_componentSearchGroupIndexList[besideTileIndex] = groupIndex;
+                        group.tileIndexList.push_back(besideTileIndex);
+                    }
+                    else
+                    {
+                        besideGroupIndex = findComponentSearchGroupIndex(groupList, besideGroupIndex);
+                        if (besideGroupIndex != groupIndex)
+                        {
+                            mergeComponentSearchGroup(groupList, groupIndex, besideGroupIndex);
+                            searchingGroupCount--;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    for (auto& group : groupList)
+    {
+        for (auto tileIndex : group.tileIndexList)
+        {
+            g_componentSearchGroupIndexList[tileIndex] = -1;
+        }
+    }
+}
+
+int ComponentHelper::findComponentID(int componentID)
+{
+    int rootComponentID = componentID;
+    while (g_componentParentList[rootComponentID] != rootComponentID)
+    {
+        rootComponentID = g_componentParentList[rootComponentID];
+    }
+
+    // 路径压缩，之后的查找可以一步到位
+    while (g_componentParentList[componentID] != rootComponentID)
+    {
+        int parentComponentID = g_componentParentList[componentID];
+        g_componentParentList[componentID] = rootComponentID;
+        componentID = parentComponentID;
+    }
+
+    return rootComponentID;
+}
+
+int ComponentHelper::createComponentID()
+{
+    int componentID = (int)g_componentParentList.size();
+    g_componentParentList.push_back(componentID);
+
+    return componentID;
+}
+
+void ComponentHelper::compactComponentIDList()
+{
+    // 合并和分割以后旧编号仍然留在g_componentParentList中，按照根编号重新连续编号，并查集恢复成一层
+    vector<int> newComponentIDList(g_componentParentList.size(), COMPONENT_ID_INVALID);
+    int componentCount = 0;
+    for (auto& componentID : g_componentIDList)
+    {
+        if (componentID != COMPONENT_ID_INVALID)
+        {
+            int rootComponentID = findComponentID(componentID);
+            if (newComponentIDList[rootComponentID] == COMPONENT_ID_INVALID)
+            {
+                newComponentIDList[rootComponentID] = componentCount++;
+            }
+            componentID = newComponentIDList[rootComponentID];
+        }
+    }
+
+    g_componentParentList.resize(componentCount);
+    for (int componentID = 0; componentID < componentCount; componentID++)
+    {
+        g_componentParentList[componentID] = componentID;
+    }
+}
+
+void ComponentHelper::getBesideComponentIDList(TileNode* tileNode, vector<int>& componentIDList)
+{
+    int maxRowCount = g_navigationGrid->rowCount;
+    int tileIndex = tileNode->columnIndex * maxRowCount + tileNode->rowIndex;
+    if (g_componentIDList[tileIndex] != COMPONENT_ID_INVALID)
+    {
+        componentIDList.push_back(findComponentID(g_componentIDList[tileIndex]));
+        return;
+    }
+
+    int minColumnIndex = std::max(tileNode->columnIndex - 1, 0);
+    int maxColumnIndex = std::min(tileNode->columnIndex + 1, g_navigationGrid->columnCount - 1);
+    int minRowIndex = std::max(tileNode->rowIndex - 1, 0);
+    int maxRowIndex = std::min(tileNode->rowIndex + 1, maxRowCount - 1);
+
+    for (int columnIndex = minColumnIndex; columnIndex <= maxColumnIndex; columnIndex++)
+    {
+        for (int rowIndex = minRowIndex; rowIndex <= maxRowIndex; rowIndex++)
+        {
+            int componentID = g_componentIDList[columnIndex * maxRowCount + rowIndex];
+            if (componentID != COMPONENT_ID_INVALID)
+            {
+                componentID = findComponentID(componentID);
+                if (std::find(componentIDList.begin(), componentIDList.end(), componentID) == componentIDList.end())
+                {
+                    componentIDList.push_back(componentID);
+                }
+            }
+        }
+    }
+}
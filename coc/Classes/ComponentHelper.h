@@ -0,0 +1,34 @@
+#pragma once
+
+struct TileNode;
+struct NavigationGrid;
+
+const int COMPONENT_ID_INVALID = -1;
+const int COMPONENT_ID_COMPACT_FACTOR = 2;     // 编号数超过格子数的这么多倍时重新连续编号
+
+// 八方向连通的可通行区域编号，用来在寻路之前判断起点和终点是否连通；
+// 格子变成障碍时只检查周围被分割的区域，变成可通行时只合并编号，不需要重新计算整张地图
+class ComponentHelper
+{
+public:
+    static void initNavigationGrid(NavigationGrid& navigationGrid);
+    // 一次改变的格子要么全部变成障碍，要么全部变成可通行，passableList要先更新好
+    static void onTileNodesGIDChanged(const vector<TileNode*>& tileNodeList);
+
+    static bool isTileNodeReachable(TileNode* startNode, TileNode* endNode, bool isEndTileNodePassable);
+    static int getComponentParentCount();
+    static int getCompactCount();
+private:
+    static void onTileNodesBecomeObstacle(const vector<TileNode*>& tileNodeList);
+    static void onTileNodesBecomePassable(const vector<TileNode*>& tileNodeList);
+    static void floodFillComponent(int columnIndex, int rowIndex, int componentID);
+    static void splitComponentIfSeparated(const vector<int>& seedTileIndexList);
+    static int findComponentID(int componentID);
+    static int createComponentID();
+    static void compactComponentIDList();
+    // 格子本身可通行时就是它所在的连通区域，否则是周围可通行格子所在的连通区域
+    static void getBesideComponentIDList(TileNode* tileNode, vector<int>& componentIDList);
+
+    ComponentHelper();
+    ~ComponentHelper();
+};
@@ -0,0 +1,349 @@
+#include "Base.h"
+#include "MapManager.h"
+#include "AutoFindPathHelper.h"
+#include "CooperativePathHelper.h"
+
+struct CooperativeSearchNode
+{
+    int weight = 0;
+    float arriveTime = 0.0f;
+    int stepCount = 0;
+    int parentTileIndex = -1;
+    unsigned int generation = 0;
+    bool isClosed = false;
+};
+
+typedef pair<int, int> OpenListElement;     // <weight + heuristic, tileIndex>
+
+static NavigationGrid* g_navigationGrid = nullptr;
+static int g_maxColumnCount = 0;
+static int g_maxRowCount = 0;
+static int g_tileNodeCount = 0;
+
+static float g_currentTime = 0.0f;
+static float g_nextPurgeTime = 0.0f;
+
+// key为时间片 * 格子数 + 格子下标，value为预约这个格子的npc
+static unordered_map<long long, int> g_reservationMap;
+static unordered_map<int, vector<long long>> g_npcReservationKeyListMap;
+
+static vector<CooperativeSearchNode> g_searchNodeList;
+static vector<OpenListElement> g_openList;
+static unsigned int g_searchGeneration = 0;
+static int g_detourCount = 0;
+
+static int toTileIndex(TileNode* tileNode)
+{
+    return tileNode->columnIndex * g_maxRowCount + tileNode->rowIndex;
+}
+
+static long long toSlot(float time)
+{
+    return (long long)(time / RESERVATION_SLOT_TIME);
+}
+
+static float computeMoveTime(TileNode* fromNode, TileNode* toNode, float perSecondMoveSpeedByPixel)
+{
+    return fromNode->leftTopPosition.distance(toNode->leftTopPosition) / perSecondMoveSpeedByPixel;
+}
+
+static int computeWeightBetween(int fromColumnIndex, int fromRowIndex, int toColumnIndex, int toRowIndex)
+{
+    int columnDistance = std::abs(fromColumnIndex - toColumnIndex);
+    int rowDistance = std::abs(fromRowIndex - toRowIndex);
+    int slopDistance = std::min(columnDistance, rowDistance);
+
+    return slopDistance * MOVE_SLOP_WEIGHT + (std::max(columnDistance, rowDistance) - slopDistance) * MOVE_STRAIGHT_WEIGHT;
+}
+
+void CooperativePathHelper::initNavigationGrid(NavigationGrid& navigationGrid)
+{
+    g_navigationGrid = &navigationGrid;
+    g_maxColumnCount = navigationGrid.columnCount;
+    g_maxRowCount = navigationGrid.rowCount;
+    g_tileNodeCount = g_maxColumnCount * g_maxRowCount;
+
+    g_currentTime = 0.0f;
+    g_nextPurgeTime = RESERVATION_PURGE_INTERVAL;
+    g_reservationMap.clear();
+    g_npcReservationKeyListMap.clear();
+
+    g_searchNodeList.assign(g_tileNodeCount, CooperativeSearchNode());
+    g_openList.clear();
+    g_searchGeneration = 0;
+    g_detourCount = 0;
+}
+
+void CooperativePathHelper::update(float deltaTime)
+{
+    g_currentTime += deltaTime;
+    if (g_currentTime >= g_nextPurgeTime)
+    {
+        purgeExpiredReservations();
+        g_nextPurgeTime = g_currentTime + RESERVATION_PURGE_INTERVAL;
+    }
+}
+
+int CooperativePathHelper::computeCooperativeTileNodePathList(int npcUniqueID, float perSecondMoveSpeedByPixel, bool isEndTileNodePassable, list<TileNode*>& tileNodePathList)
+{
+    // 重新规划时自己原来的预约作废，也不能挡住自己
+    releaseReservations(npcUniqueID);
+    if (tileNodePathList.size() < 2 || perSecondMoveSpeedByPixel <= 0.0f)
+    {
+        return 0;
+    }
+
+    vector<TileNode*> staticPathList(tileNodePathList.rbegin(), tileNodePathList.rend());
+    int rejoinIndex = std::min(COOPERATIVE_WINDOW_STEP_COUNT, (int)staticPathList.size() - 1);
+
+    // 窗口内找不到避开所有预约的路径时仍然沿原路径走，碰撞检测会把npc推开
+    vector<TileNode*> windowPathList;
+    if (searchWindowPathList(npcUniqueID, perSecondMoveSpeedByPixel, staticPathList.front(), staticPathList[rejoinIndex], staticPathList.back(),
+        isEndTileNodePassable, windowPathList))
+    {
+        if (!std::equal(windowPathList.begin(), windowPathList.end(), staticPathList.begin()) || (int)windowPathList.size() != rejoinIndex + 1)
+        {
+            g_detourCount++;
+        }
+    }
+    else
+    {
+        windowPathList.assign(staticPathList.begin(), staticPathList.begin() + rejoinIndex + 1);
+    }
+
+    // 登记窗口内每个格子从进入到离开的时间段，最后一个格子按照走进来的时间再停留一步
+    float arriveTime = g_currentTime;
+    for (int i = 0; i < (int)windowPathList.size(); i++)
+    {
+        float leaveTime = arriveTime;
+        if (i + 1 < (int)windowPathList.size())
+        {
+            leaveTime += computeMoveTime(windowPathList[i], windowPathList[i + 1], perSecondMoveSpeedByPixel);
+        }
+        else
+        {
+            leaveTime += computeMoveTime(windowPathList[i - 1], windowPathList[i], perSecondMoveSpeedByPixel);
+        }
+
+        reserve(npcUniqueID, toTileIndex(windowPathList[i]), arriveTime, leaveTime);
+        arriveTime = leaveTime;
+    }
+
+    tileNodePathList.clear();
+    for (auto tileNode : windowPathList)
+    {
+        tileNodePathList.push_front(tileNode);
+    }
+    for (int i = rejoinIndex + 1; i < (int)staticPathList.size(); i++)
+    {
+        tileNodePathList.push_front(staticPathList[i]);
+    }
+
+    return (int)windowPathList.size();
+}
+
+void CooperativePathHelper::releaseReservations(int npcUniqueID)
+{
+    auto keyListIter = g_npcReservationKeyListMap.find(npcUniqueID);
+    if (keyListIter == g_npcReservationKeyListMap.end())
+    {
+        return;
+    }
+
+    for (auto key : keyListIter->second)
+    {
+        auto reservationIter = g_reservationMap.find(key);
+        if (reservationIter != g_reservationMap.end() && reservationIter->second == npcUniqueID)
+        {
+            g_reservationMap.erase(reservationIter);
+        }
+    }
+
+    g_npcReservationKeyListMap.erase(keyListIter);
+}
+
+int CooperativePathHelper::getReservationCount()
+{
+    return (int)g_reservationMap.size();
+}
+
+int CooperativePathHelper::getDetourCount()
+{
+    return g_detourCount;
+}
+
+bool CooperativePathHelper::searchWindowPathList(int npcUniqueID, float perSecondMoveSpeedByPixel, TileNode* startNode, TileNode* rejoinNode, TileNode* endNode,
+    bool isEndTileNodePassable, vector<TileNode*>& windowPathList)
+{
+    bool result = false;
+
+    int minColumnIndex = std::max(std::min(startNode->columnIndex, rejoinNode->columnIndex) - COOPERATIVE_SEARCH_MARGIN, 0);
+    int maxColumnIndex = std::min(std::max(startNode->columnIndex, rejoinNode->columnIndex) + COOPERATIVE_SEARCH_MARGIN, g_maxColumnCount - 1);
+    int minRowIndex = std::max(std::min(startNode->rowIndex, rejoinNode->rowIndex) - COOPERATIVE_SEARCH_MARGIN, 0);
+    int maxRowIndex = std::min(std::max(startNode->rowIndex, rejoinNode->rowIndex) + COOPERATIVE_SEARCH_MARGIN, g_maxRowCount - 1);
+
+    g_searchGeneration++;
+    g_openList.clear();
+
+    int startTileIndex = toTileIndex(startNode);
+    int rejoinTileIndex = toTileIndex(rejoinNode);
+    auto& startSearchNode = g_searchNodeList[startTileIndex];
+    startSearchNode.weight = 0;
+    startSearchNode.arriveTime = g_currentTime;
+    startSearchNode.stepCount = 0;
+    startSearchNode.parentTileIndex = -1;
+    startSearchNode.generation = g_searchGeneration;
+    startSearchNode.isClosed = false;
+    g_openList.push_back(OpenListElement(0, startTileIndex));
+
+    while (!g_openList.empty())
+    {
+        std::pop_heap(g_openList.begin(), g_openList.end(), std::greater<OpenListElement>());
+        int tileIndex = g_openList.back().second;
+        g_openList.pop_back();
+
+        auto& searchNode = g_searchNodeList[tileIndex];
+        if (searchNode.isClosed)
+        {
+            continue;
+        }
+        searchNode.isClosed = true;
+
+        if (tileIndex == rejoinTileIndex)
+        {
+            for (int pathTileIndex = tileIndex; pathTileIndex != -1; pathTileIndex = g_searchNodeList[pathTileIndex].parentTileIndex)
+            {
+                windowPathList.push_back(&g_navigationGrid->tileNodeList[pathTileIndex]);
+            }
+            std::reverse(windowPathList.begin(), windowPathList.end());
+
+            result = true;
+            break;
+        }
+
+        auto tileNode = &g_navigationGrid->tileNodeList[tileIndex];
+        for (int columnOffset = -1; columnOffset <= 1; columnOffset++)
+        {
+            for (int rowOffset = -1; rowOffset <= 1; rowOffset++)
+            {
+                int columnIndex = tileNode->columnIndex + columnOffset;
+                int rowIndex = tileNode->rowIndex + rowOffset;
+                if ((columnOffset == 0 && rowOffset == 0) ||
+                    columnIndex < minColumnIndex || columnIndex > maxColumnIndex ||
+                    rowIndex < minRowIndex || rowIndex > maxRowIndex)
+                {
+                    continue;
+                }
+
+                int neighborTileIndex = columnIndex * g_maxRowCount + rowIndex;
+                auto neighborNode = &g_navigationGrid->tileNodeList[neighborTileIndex];
+                if (!g_navigationGrid->passableList[neighborTileIndex] && !(neighborNode == endNode && isEndTileNodePassable))
+                {
+                    continue;
+                }
+
+                auto& neighborSearchNode = g_searchNodeList[neighborTileIndex];
+                int weight = searchNode.weight + ((columnOffset != 0 && rowOffset != 0) ? MOVE_SLOP_WEIGHT : MOVE_STRAIGHT_WEIGHT);
+                if (neighborSearchNode.generation == g_searchGeneration && (neighborSearchNode.isClosed || weight >= neighborSearchNode.weight))
+                {
+                    continue;
+                }
+
+                // 窗口内不能在别人预约的时间段进入这个格子，迎面交换位置的两个npc也会因此错开
+                float moveTime = computeMoveTime(tileNode, neighborNode, perSecondMoveSpeedByPixel);
+                float arriveTime = searchNode.arriveTime + moveTime;
+                int stepCount = searchNode.stepCount + 1;
+                if (stepCount <= COOPERATIVE_WINDOW_STEP_COUNT && isReservedByOthers(npcUniqueID, neighborTileIndex, arriveTime, arriveTime + moveTime))
+                {
+                    continue;
+                }
+
+                neighborSearchNode.weight = weight;
+                neighborSearchNode.arriveTime = arriveTime;
+                neighborSearchNode.stepCount = stepCount;
+                neighborSearchNode.parentTileIndex = tileIndex;
+                neighborSearchNode.generation = g_searchGeneration;
+                neighborSearchNode.isClosed = false;
+
+                g_openList.push_back(OpenListElement(weight + computeWeightBetween(columnIndex, rowIndex, rejoinNode->columnIndex, rejoinNode->rowIndex), neighborTileIndex));
+                std::push_heap(g_openList.begin(), g_openList.end(), std::greater<OpenListElement>());
+            }
+        }
+    }
+
+    return result;
+}
+
+bool CooperativePathHelper::isReservedByOthers(int npcUniqueID, int tileIndex, float beginTime, float endTime)
+{
+    bool result = false;
+
+    for (auto slot = toSlot(beginTime); slot <= toSlot(endTime); slot++)
+    {
+        auto reservationIter = g_reservationMap.find(slot * g_tileNodeCount + tileIndex);
+        if (reservationIter != g_reservationMap.end() && reservationIter->second != npcUniqueID)
+        {
+            result = true;
+            break;
+        }
+    }
+
+    return result;
+}
+
+void CooperativePathHelper::reserve(int npcUniqueID, int tileIndex, float beginTime, float endTime)
+{
+    // 先登记的npc优先，已经被别人预约的时间片保持不变
+    auto& keyList = g_npcReservationKeyListMap[npcUniqueID];
+    for (auto slot = toSlot(beginTime); slot <= toSlot(endTime); slot++)
+    {
+        long long key = slot * g_tileNodeCount + tileIndex;
+        if (g_reservationMap.find(key) == g_reservationMap.end())
+        {
+            g_reservationMap[key] = npcUniqueID;
+            keyList.push_back(key);
+        }
+    }
+}
+
+void CooperativePathHelper::purgeExpiredReservations()
+{
+    long long currentSlot = toSlot(g_currentTime);
+
+    auto reservationIter = g_reservationMap.begin();
+    while (reservationIter != g_reservationMap.end())
+    {
+        if (reservationIter->first / g_tileNodeCount < currentSlot)
+        {
+            reservationIter = g_reservationMap.erase(reservationIter);
+        }
+        else
+        {
+            ++reservationIter;
+        }
+    }
+
+    auto keyListIter = g_npcReservationKeyListMap.begin();
+    while (keyListIter != g_npcReservationKeyListMap.end())
+    {
+        auto& keyList = keyListIter->second;
+        int keepCount = 0;
+        for (auto key : keyList)
+        {
+            if (key / g_tileNodeCount >= currentSlot)
+            {
+                keyList[keepCount++] = key;
+            }
+        }
+        keyList.resize(keepCount);
+
+        if (keyList.empty())
+        {
+            keyListIter = g_npcReservationKeyListMap.erase(keyListIter);
+        }
+        else
+        {
+            ++keyListIter;
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+const int COOPERATIVE_WINDOW_STEP_COUNT = 16;      // 只在路径的前这么多步内避让其他npc，之后沿原来的路径走
+const int COOPERATIVE_SEARCH_MARGIN = 4;           // 避让时只在起点和汇合点外扩这么多格子的范围内搜索
+const float RESERVATION_SLOT_TIME = 0.1f;          // 预约表的时间精度，单位秒
+const float RESERVATION_PURGE_INTERVAL = 1.0f;
+
+// 窗口化协作寻路：npc把路径前一段经过每个格子的时间登记到时空预约表中，
+// 之后出发的npc在窗口内绕开别人已经预约的格子和时间段，同一批移动的npc因此错开时间或者走相邻的车道
+class CooperativePathHelper
+{
+public:
+    static void initNavigationGrid(NavigationGrid& navigationGrid);
+    static void update(float deltaTime);
+
+    // tileNodePathList是已经算好的静态路径，格式与AutoFindPathHelper一致；重新规划它的前一段并登记预约，
+    // 返回从起点数起属于窗口的格子数，这些格子错开了别的npc，不能再被拉直
+    static int computeCooperativeTileNodePathList(int npcUniqueID, float perSecondMoveSpeedByPixel, bool isEndTileNodePassable, list<TileNode*>& tileNodePathList);
+    static void releaseReservations(int npcUniqueID);
+
+    static int getReservationCount();
+    static int getDetourCount();
+
+private:
+    static bool searchWindowPathList(int npcUniqueID, float perSecondMoveSpeedByPixel, TileNode* startNode, TileNode* rejoinNode, TileNode* endNode,
+        bool isEndTileNodePassable, vector<TileNode*>& windowPathList);
+    static bool isReservedByOthers(int npcUniqueID, int tileIndex, float beginTime, float endTime);
+    static void reserve(int npcUniqueID, int tileIndex, float beginTime, float endTime);
+    static void purgeExpiredReservations();
+
+    CooperativePathHelper();
+    ~CooperativePathHelper();
+};
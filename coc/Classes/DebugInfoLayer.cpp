@@ -3,6 +3,8 @@
 #include "DebugInfoLayer.h"
 #include "GameObject.h"
 #include "GameWorld.h"
+#include "LandmarkHelper.h"
+#include "PathRequestService.h"
 
 
 bool DebugInfoLayer::init()
@@ -18,6 +20,15 @@ bool DebugInfoLayer::init()
     _currentHoverTileTextureNameLabel = createLabel(20, Vec2(10.0f, 580.0f), "");
     _currentHoverTileGIDLabel = createLabel(20, Vec2(10.0f, 560.0f), "");
     _gameObjectCountLabel = createLabel(20, Vec2(10.0f, 540.0f), "");
+    _pathCacheLabel = createLabel(20, Vec2(10.0f, 520.0f), "");
+    _pathRequestLabel = createLabel(20, Vec2(10.0f, 500.0f), "");
+    _pathPlannerLabel = createLabel(20, Vec2(10.0f, 480.0f), "");
+    _cooperativePathLabel = createLabel(20, Vec2(10.0f, 460.0f), "");
+    _navMeshLabel = createLabel(20, Vec2(10.0f, 440.0f), "");
+    _buildingRouteLabel = createLabel(20, Vec2(10.0f, 420.0f), "");
+    _localAvoidanceLabel = createLabel(20, Vec2(10.0f, 400.0f), "");
+    _aoeBenchmarkLabel = createLabel(20, Vec2(10.0f, 380.0f), "");
+    _npcCollisionBenchmarkLabel = createLabel(20, Vec2(10.0f, 360.0f), "");
 
     return true;
 }
@@ -48,4 +59,29 @@ void DebugInfoLayer::updateInfo(const DebugInfo& debugInfo)
     _currentHoverTileGIDLabel->setString("Tile gid = " + StringUtils::format("%d", debugInfo.mapDebugInfo.gid));
 
     _gameObjectCountLabel->setString("GameObject count = " + StringUtils::format("%d", debugInfo.gameObjectCount));
+
+    int pathCacheQueryCount = debugInfo.pathCacheHitCount + debugInfo.pathCacheMissCount;
+    float pathCacheHitRate = pathCacheQueryCount > 0 ? (float)debugInfo.pathCacheHitCount / (float)pathCacheQueryCount : 0.0f;
+    _pathCacheLabel->setString("PathCache hit = " + StringUtils::format("%d/%d (%.1f%%)", debugInfo.pathCacheHitCount, pathCacheQueryCount, pathCacheHitRate * 100.0f) +
+        ", evicted = " + StringUtils::format("%d", debugInfo.pathCacheEvictedCount));
+    _pathRequestLabel->setString(StringUtils::format("Pending path request count = %d (waiting %d, searching %d), expanded node = %d / %d",
+        debugInfo.pendingPathRequestCount, debugInfo.waitingPathRequestCount, debugInfo.searchingPathRequestCount,
+        debugInfo.lastFrameExpandedNodeCount, MAX_EXPANDED_NODE_COUNT_PER_FRAME));
+    _pathPlannerLabel->setString(StringUtils::format("Path planner count = %d, last repair expanded = %d, landmark = %d/%d",
+        debugInfo.pathPlannerCount, debugInfo.lastPathRepairExpandedNodeCount, debugInfo.validLandmarkCount, LANDMARK_COUNT));
+    _cooperativePathLabel->setString(StringUtils::format("Cooperative path (F6) = %s, reserved = %d, detour = %d, collision = %d, last move order arrive = %.2fs",
+        debugInfo.allowCooperativePath ? "on" : "off", debugInfo.pathReservationCount, debugInfo.cooperativeDetourCount,
+        debugInfo.lastFrameNpcCollisionCount, debugInfo.lastMoveOrderArriveTime));
+    _navMeshLabel->setString(StringUtils::format("NavMesh path (F7) = %s, polygon count = %d, last search expanded = %d",
+        debugInfo.allowNavMeshPath ? "on" : "off", debugInfo.navMeshPolygonCount, debugInfo.lastNavMeshExpandedNodeCount));
+    _buildingRouteLabel->setString(StringUtils::format("Building route count = %d, pending = %d, hit = %d",
+        debugInfo.buildingRouteCount, debugInfo.pendingBuildingRouteCount, debugInfo.buildingRouteHitCount));
+    _localAvoidanceLabel->setString(StringUtils::format("Local avoidance (F8) = %s, agent count = %d",
+        debugInfo.allowLocalAvoidance ? "on" : "off", debugInfo.avoidanceAgentCount));
+    _aoeBenchmarkLabel->setString(StringUtils::format("AOE benchmark (F9) impacts = %d, hits = %d, full scan = %.1fus, indexed = %.1fus",
+        debugInfo.aoeBenchmarkImpactCount, debugInfo.aoeBenchmarkHitCount,
+        debugInfo.aoeBenchmarkFullScanMicroseconds, debugInfo.aoeBenchmarkIndexedMicroseconds));
+    _npcCollisionBenchmarkLabel->setString(StringUtils::format("Collision benchmark (F11) npcs = %d, pairs = %d, radius query = %.1fus, broadphase = %.1fus",
+        debugInfo.npcCollisionBenchmarkNpcCount, debugInfo.npcCollisionBenchmarkPairCount,
+        debugInfo.npcCollisionBenchmarkRadiusQueryMicroseconds, debugInfo.npcCollisionBenchmarkBroadphaseMicroseconds));
 }
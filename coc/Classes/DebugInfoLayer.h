@@ -18,4 +18,13 @@ private:
     Label* _currentHoverTileGIDLabel = nullptr;
     Label* _currentTileMapLayerNameLabel = nullptr;
     Label* _gameObjectCountLabel = nullptr;
+    Label* _pathCacheLabel = nullptr;
+    Label* _pathRequestLabel = nullptr;
+    Label* _pathPlannerLabel = nullptr;
+    Label* _cooperativePathLabel = nullptr;
+    Label* _navMeshLabel = nullptr;
+    Label* _buildingRouteLabel = nullptr;
+    Label* _localAvoidanceLabel = nullptr;
+    Label* _aoeBenchmarkLabel = nullptr;
+    Label* _npcCollisionBenchmarkLabel = nullptr;
 };
\ No newline at end of file
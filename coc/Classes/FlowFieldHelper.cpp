@@ -0,0 +1,266 @@
+#include "Base.h"
+#include "MapManager.h"
+#include "AutoFindPathHelper.h"
+#include "HierarchicalPathHelper.h"
+#include "FlowFieldHelper.h"
+
+const int WEIGHT_INFINITE = INT_MAX;
+
+struct FlowField
+{
+    vector<int> endTileIndexList;       // 所有终点的代价都是0，流场指向最近的终点
+    int navigationVersion = 0;
+    unsigned int lastUsedTime = 0;
+    vector<int> gotoEndNodeWeightList;  // 每个格子到终点的最短代价
+};
+
+typedef pair<int, int> OpenListElement;     // <weight, tileIndex>
+
+static NavigationGrid* g_navigationGrid = nullptr;
+static int g_maxColumnCount = 0;
+static int g_maxRowCount = 0;
+
+static vector<FlowField> g_flowFieldList;
+static vector<OpenListElement> g_openList;
+static unsigned int g_currentTime = 0;
+static int g_flowFieldBuildCount = 0;
+
+static int toTileIndex(int columnIndex, int rowIndex)
+{
+    return columnIndex * g_maxRowCount + rowIndex;
+}
+
+void FlowFieldHelper::initNavigationGrid(NavigationGrid& navigationGrid)
+{
+    g_navigationGrid = &navigationGrid;
+    g_maxColumnCount = navigationGrid.columnCount;
+    g_maxRowCount = navigationGrid.rowCount;
+
+    g_flowFieldList.clear();
+    g_flowFieldList.reserve(MAX_FLOW_FIELD_CACHE_COUNT);
+    g_openList.clear();
+    g_currentTime = 0;
+    g_flowFieldBuildCount = 0;
+}
+
+list<TileNode*> FlowFieldHelper::computeTileNodePathListBetween(TileNode* startNode, TileNode* flowFieldEndNode, TileNode* endNode, bool isEndTileNodePassable, int navigationVersion)
+{
+    list<TileNode*> pathList;
+
+    auto& flowField = getFlowField(vector<int>(1, toTileIndex(flowFieldEndNode->columnIndex, flowFieldEndNode->rowIndex)), navigationVersion);
+
+    auto currentNode = startNode;
+    pathList.push_front(currentNode);
+    while (currentNode != endNode)
+    {
+        if (endNode != flowFieldEndNode &&
+            std::max(std::abs(currentNode->columnIndex - endNode->columnIndex), std::abs(currentNode->rowIndex - endNode->rowIndex)) <= FLOW_FIELD_ARRIVE_TILE_DISTANCE)
+        {
+            break;
+        }
+
+        // 流场的终点可能是障碍格（比如建筑物），只有它同时也是允许进入的最终目标时才能走进去
+        auto nextNode = getNextTileNode(flowField, currentNode);
+        if (!nextNode || (nextNode->gid == OBSTACLE_ID && !(nextNode == endNode && isEndTileNodePassable)))
+        {
+            break;
+        }
+
+        pathList.push_front(nextNode);
+        currentNode = nextNode;
+    }
+
+    if (currentNode != endNode)
+    {
+        auto arrivePathList = AutoFindPathHelper::computeTileNodePathListBetween(currentNode, endNode, isEndTileNodePassable);
+        if (arrivePathList.empty())
+        {
+            return HierarchicalPathHelper::computeTileNodePathListBetween(startNode, endNode, isEndTileNodePassable);
+        }
+
+        arrivePathList.pop_back();
+        pathList.splice(pathList.begin(), arrivePathList);
+    }
+
+    return pathList;
+}
+
+list<TileNode*> FlowFieldHelper::computeTileNodePathListToNearest(TileNode* startNode, const vector<TileNode*>& endNodeList, bool isEndTileNodePassable, int navigationVersion)
+{
+    list<TileNode*> pathList;
+    if (endNodeList.empty())
+    {
+        return pathList;
+    }
+
+    vector<int> endTileIndexList;
+    for (auto endNode : endNodeList)
+    {
+        endTileIndexList.push_back(toTileIndex(endNode->columnIndex, endNode->rowIndex));
+    }
+    std::sort(endTileIndexList.begin(), endTileIndexList.end());
+
+    auto& flowField = getFlowField(endTileIndexList, navigationVersion);
+    auto& weightList = flowField.gotoEndNodeWeightList;
+
+    // 代价为0的格子就是终点，沿着流场一直走到代价为0的格子为止
+    auto currentNode = startNode;
+    pathList.push_front(currentNode);
+    while (weightList[toTileIndex(currentNode->columnIndex, currentNode->rowIndex)] != 0)
+    {
+        auto nextNode = getNextTileNode(flowField, currentNode);
+        if (!nextNode ||
+            (nextNode->gid == OBSTACLE_ID && !(isEndTileNodePassable && weightList[toTileIndex(nextNode->columnIndex, nextNode->rowIndex)] == 0)))
+        {
+            return AutoFindPathHelper::computeTileNodePathListToNearest(startNode, endNodeList, isEndTileNodePassable);
+        }
+
+        pathList.push_front(nextNode);
+        currentNode = nextNode;
+    }
+
+    return pathList;
+}
+
+int FlowFieldHelper::getFlowFieldBuildCount()
+{
+    return g_flowFieldBuildCount;
+}
+
+FlowField& FlowFieldHelper::getFlowField(const vector<int>& endTileIndexList, int navigationVersion)
+{
+    g_currentTime++;
+
+    // 优先复用同一个终点的旧流场，否则淘汰最久没有用过的流场
+    int replaceIndex = -1;
+    for (int flowFieldIndex = 0; flowFieldIndex < (int)g_flowFieldList.size(); flowFieldIndex++)
+    {
+        auto& flowField = g_flowFieldList[flowFieldIndex];
+        if (flowField.endTileIndexList == endTileIndexList)
+        {
+            if (flowField.navigationVersion == navigationVersion)
+            {
+                flowField.lastUsedTime = g_currentTime;
+                return flowField;
+            }
+
+            replaceIndex = flowFieldIndex;
+            break;
+        }
+
+        if (replaceIndex < 0 || flowField.lastUsedTime < g_flowFieldList[replaceIndex].lastUsedTime)
+        {
+            replaceIndex = flowFieldIndex;
+        }
+    }
+
+    if ((int)g_flowFieldList.size() < MAX_FLOW_FIELD_CACHE_COUNT &&
+        (replaceIndex < 0 || g_flowFieldList[replaceIndex].endTileIndexList != endTileIndexList))
+    {
+        g_flowFieldList.push_back(FlowField());
+        replaceIndex = (int)g_flowFieldList.size() - 1;
+    }
+
+    auto& flowField = g_flowFieldList[replaceIndex];
+    flowField.endTileIndexList = endTileIndexList;
+    flowField.navigationVersion = navigationVersion;
+    flowField.lastUsedTime = g_currentTime;
+    buildFlowField(flowField);
+
+    return flowField;
+}
+
+void FlowFieldHelper::buildFlowField(FlowField& flowField)
+{
+    // 从终点出发做一次Dijkstra，移动规则与AutoFindPathHelper相同，移动代价是对称的
+    auto& weightList = flowField.gotoEndNodeWeightList;
+    weightList.assign(g_maxColumnCount * g_maxRowCount, WEIGHT_INFINITE);
+
+    g_openList.clear();
+    for (auto endTileIndex : flowField.endTileIndexList)
+    {
+        weightList[endTileIndex] = 0;
+        g_openList.push_back(OpenListElement(0, endTileIndex));
+    }
+
+    while (!g_openList.empty())
+    {
+        std::pop_heap(g_openList.begin(), g_openList.end(), std::greater<OpenListElement>());
+        auto currentElement = g_openList.back();
+        g_openList.pop_back();
+
+        int currentWeight = currentElement.first;
+        if (currentWeight > weightList[currentElement.second])
+        {
+            continue;
+        }
+
+        int columnIndex = currentElement.second / g_maxRowCount;
+        int rowIndex = currentElement.second % g_maxRowCount;
+
+        for (int besideColumnIndex = std::max(columnIndex - 1, 0); besideColumnIndex <= std::min(columnIndex + 1, g_maxColumnCount - 1); besideColumnIndex++)
+        {
+            for (int besideRowIndex = std::max(rowIndex - 1, 0); besideRowIndex <= std::min(rowIndex + 1, g_maxRowCount - 1); besideRowIndex++)
+            {
+                int besideTileIndex = toTileIndex(besideColumnIndex, besideRowIndex);
+                if (!g_navigationGrid->passableList[besideTileIndex])
+                {
+                    continue;
+                }
+
+                int moveWeight = MOVE_STRAIGHT_WEIGHT;
+                if (besideColumnIndex != columnIndex && besideRowIndex != rowIndex)
+                {
+                    moveWeight = MOVE_SLOP_WEIGHT;
+                }
+
+                if (currentWeight + moveWeight < weightList[besideTileIndex])
+                {
+                    weightList[besideTileIndex] = currentWeight + moveWeight;
+                    g_openList.push_back(OpenListElement(currentWeight + moveWeight, besideTileIndex));
+                    std::push_heap(g_openList.begin(), g_openList.end(), std::greater<OpenListElement>());
+                }
+            }
+        }
+    }
+
+    g_flowFieldBuildCount++;
+}
+
+TileNode* FlowFieldHelper::getNextTileNode(const FlowField& flowField, TileNode* tileNode)
+{
+    TileNode* nextTileNode = nullptr;
+
+    auto& weightList = flowField.gotoEndNodeWeightList;
+    int columnIndex = tileNode->columnIndex;
+    int rowIndex = tileNode->rowIndex;
+
+    // 站在障碍格上时当前格子没有代价，只要周围有可达的格子就可以走出来
+    int minWeight = weightList[toTileIndex(columnIndex, rowIndex)];
+    for (int besideColumnIndex = std::max(columnIndex - 1, 0); besideColumnIndex <= std::min(columnIndex + 1, g_maxColumnCount - 1); besideColumnIndex++)
+    {
+        for (int besideRowIndex = std::max(rowIndex - 1, 0); besideRowIndex <= std::min(rowIndex + 1, g_maxRowCount - 1); besideRowIndex++)
+        {
+            int besideTileIndex = toTileIndex(besideColumnIndex, besideRowIndex);
+            int besideWeight = weightList[besideTileIndex];
+            if (besideWeight == WEIGHT_INFINITE)
+            {
+                continue;
+            }
+
+            int moveWeight = MOVE_STRAIGHT_WEIGHT;
+            if (besideColumnIndex != columnIndex && besideRowIndex != rowIndex)
+            {
+                moveWeight = MOVE_SLOP_WEIGHT;
+            }
+
+            if (besideWeight + moveWeight <= minWeight)
+            {
+                minWeight = besideWeight + moveWeight;
+                nextTileNode = &g_navigationGrid->tileNodeList[besideTileIndex];
+            }
+        }
+    }
+
+    return nextTileNode;
+}
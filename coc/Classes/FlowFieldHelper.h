@@ -0,0 +1,28 @@
+#pragma once
+
+const int MAX_FLOW_FIELD_CACHE_COUNT = 8;
+const int FLOW_FIELD_ARRIVE_TILE_DISTANCE = 3; // 离最终目标格子在这个距离以内时离开流场，单独寻路过去
+
+struct FlowField;
+
+// 同一个目的地的流场只计算一次，所有前往该目的地的npc共用
+class FlowFieldHelper
+{
+public:
+    static void initNavigationGrid(NavigationGrid& navigationGrid);
+
+    // 沿着通往flowFieldEndNode的流场移动，接近endNode后再单独寻路，返回的路径格式与AutoFindPathHelper一致
+    static list<TileNode*> computeTileNodePathListBetween(TileNode* startNode, TileNode* flowFieldEndNode, TileNode* endNode, bool isEndTileNodePassable, int navigationVersion);
+    // 流场从endNodeList中的所有格子同时出发，沿着它可以走到最近的一个终点，比如建筑物的任意一个占地格子
+    static list<TileNode*> computeTileNodePathListToNearest(TileNode* startNode, const vector<TileNode*>& endNodeList, bool isEndTileNodePassable, int navigationVersion);
+
+    static int getFlowFieldBuildCount();
+
+private:
+    static FlowField& getFlowField(const vector<int>& endTileIndexList, int navigationVersion);
+    static void buildFlowField(FlowField& flowField);
+    static TileNode* getNextTileNode(const FlowField& flowField, TileNode* tileNode);
+
+    FlowFieldHelper();
+    ~FlowFieldHelper();
+};
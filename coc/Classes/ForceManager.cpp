@@ -100,7 +100,7 @@ void ForceManager::onEnemyLaunchAttack()
         return;
     }
 
-    _enemyMoveToPosition = computeEnemyMoveToPosition();
+    _enemyMoveToPositionList = computeEnemyMoveToPositionList();
 }
 
 void ForceManager::onEnemyReinforcementArrive()
@@ -190,11 +190,14 @@ void ForceManager::update(float delta)
             readyToMoveGameObject->getGameObjectType() == GameObjectType::Npc)
         {
             auto readyToMoveNpc = static_cast<Npc*>(readyToMoveGameObject);
-            readyToMoveNpc->moveTo(_enemyMoveToPosition, true);
+            if (!readyToMoveNpc->moveAlongBuildingRouteTo(_enemyAttackTargetUniqueID))
+            {
+                readyToMoveNpc->moveAlongFlowFieldToNearest(_enemyMoveToPositionList, true);
+            }
 
             MopUpCommand mopUpCommand;
             mopUpCommand.isExecuting = true;
-            mopUpCommand.finalPosition = _enemyMoveToPosition;
+            mopUpCommand.finalPositionList = _enemyMoveToPositionList;
             readyToMoveNpc->setMopUpCommand(mopUpCommand);
 
             if (readyToMoveNpc->getNpcStatus() == NpcStatus::Stand)
@@ -205,7 +208,7 @@ void ForceManager::update(float delta)
                 }
                 else
                 {
-                    _enemyMoveToPosition = computeEnemyMoveToPosition();
+                    _enemyMoveToPositionList = computeEnemyMoveToPositionList();
                 }
             }
             else
@@ -251,22 +254,24 @@ void ForceManager::setGameObjectLevel(const string& templateName, int level)
     }
 }
 
-cocos2d::Vec2 ForceManager::computeEnemyMoveToPosition()
+vector<Vec2> ForceManager::computeEnemyMoveToPositionList()
 {
-    Vec2 moveToPosition;
+    vector<Vec2> moveToPositionList;
 
     if (_playerBuildingList.empty())
     {
-        return moveToPosition;
+        return moveToPositionList;
     }
 
     int buildingListIndex = rand() % (int)_playerBuildingList.size();
     auto attackTarget = static_cast<Building*>(_playerBuildingList.at(buildingListIndex));
 
-    moveToPosition = attackTarget->getBottomGridInMapPositionList().at(0);
+    // 每个npc沿着流场走到离自己最近的占地格子，而不是都挤向同一个格子
+    moveToPositionList = attackTarget->getBottomGridInMapPositionList();
+    _enemyAttackTargetUniqueID = attackTarget->getUniqueID();
     _playerBuildingList.erase(_playerBuildingList.begin() + buildingListIndex);
 
-    return moveToPosition;
+    return moveToPositionList;
 }
 
 void ForceManager::addTechnologyPoint(ForceType type, int technologyPoint)
@@ -3,7 +3,7 @@
 struct ForceData
 {
     int reinforcePoint = 0;
-    int technologyPoint = 0; // ĿƼ
+    int technologyPoint = 0; // 用于升级的科技点
 };
 
 const float ENEMY_LAUNCH_ATTACK_TIME_INTERVAL = 60;
@@ -36,7 +36,7 @@ private:
     
     void onEnemyLaunchAttack();
     void onEnemyReinforcementArrive();
-    Vec2 computeEnemyMoveToPosition();
+    vector<Vec2> computeEnemyMoveToPositionList();
 
     void launchForbidTryAIForceUpgradeTimer();
     bool canTryAIForceUpgrade(float delta);
@@ -47,7 +47,8 @@ private:
 
     list<int> _readyToMoveEnemyIDList;
     vector<GameObject*> _playerBuildingList;
-    Vec2 _enemyMoveToPosition;
+    vector<Vec2> _enemyMoveToPositionList;     // 进攻目标建筑物的所有占地格子
+    int _enemyAttackTargetUniqueID = GAME_OBJECT_UNIQUE_ID_INVALID;
 
     map<ForceType, ForceData> _forceDataMap;
     GameWorldCallBackFunctionsManager* _gameWorld = nullptr;
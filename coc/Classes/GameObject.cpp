@@ -1,5 +1,6 @@
 #include "Base.h"
 #include "GameObject.h"
+#include "GameObjectManager.h"
 #include "Npc.h"
 #include "Building.h"
 #include "GameSetting.h"
@@ -67,6 +68,18 @@ int GameObject::getUniqueID()
     return _uniqueID;
 }
 
+void GameObject::setPosition(const Vec2& position)
+{
+    Sprite::setPosition(position);
+    GameObjectManager::getInstance()->updateSpatialIndexOf(this);
+}
+
+void GameObject::setPosition(float x, float y)
+{
+    Sprite::setPosition(x, y);
+    GameObjectManager::getInstance()->updateSpatialIndexOf(this);
+}
+
 void GameObject::depthSort(const Size& tileSize)
 {
     auto position = getPosition();
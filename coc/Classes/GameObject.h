@@ -51,6 +51,10 @@ public:
     int getUniqueID();
     void depthSort(const Size& tileSize);
 
+    // 位置变化时同步更新GameObjectManager的空间索引
+    void setPosition(const Vec2& position) override;
+    void setPosition(float x, float y) override;
+
     virtual void setSelected(bool isSelect);
     bool isSelected();
     virtual bool isReadyToRemove() = 0;
@@ -104,7 +108,7 @@ protected:
    
     int _attackPower = 0;
     int _maxAttackRadius = 0;
-    float _extraEnemyAttackRadius = 0.0f;   // зGameObjectΧӳ
+    float _extraEnemyAttackRadius = 0.0f;   // 敌方GameObject攻击范围加成
     BulletType _bulletType = BulletType::Invalid;
     DamageType _damageType = DamageType::Invalid;
     float _aoeDamageRadius = 0.0f;
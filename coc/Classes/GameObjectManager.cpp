@@ -9,9 +9,13 @@
 #include "Utils.h"
 #include "audio/include/AudioEngine.h"
 #include "SoundManager.h"
+#include "LocalAvoidanceHelper.h"
 
 static GameObjectManager* s_gameObjectManager = nullptr;
 
+static vector<AvoidanceAgent> g_avoidanceAgentList;
+static vector<Npc*> g_avoidanceNpcList;    // 与g_avoidanceAgentList一一对应
+
 const float MAX_WIDTH_SPACE_BETWEEN_NPC_IN_LINEUP = 60.0f;
 const float MAX_HEIGHT_SPACE_BETWEEN_NPC_IN_LINEUP = 60.0f;
 
@@ -80,6 +84,19 @@ GameObject* GameObjectManager::createGameObject(GameObjectType gameObjectType, F
     if (gameObject)
     {
         _gameObjectMap[gameObject->getUniqueID()] = gameObject;
+
+        _maxCollisionRadius = std::max(_maxCollisionRadius, gameObject->getCollisionRadius());
+        _maxExtraEnemyAttackRadius = std::max(_maxExtraEnemyAttackRadius, gameObject->getExtraEnemyAttackRadius());
+
+        SpatialCellElement element;
+        element.gameObject = gameObject;
+        element.uniqueID = gameObject->getUniqueID();
+        if (gameObjectType == GameObjectType::Npc)
+        {
+            element.isAir = static_cast<Npc*>(gameObject)->isAir();
+        }
+        _spatialElementMap[element.uniqueID] = element;
+        updateSpatialIndexOf(gameObject);
     }
 
     return gameObject;
@@ -90,6 +107,15 @@ void GameObjectManager::removeGameObjectBy(int uniqueID)
     auto gameObjectIter = _gameObjectMap.find(uniqueID);
     if (gameObjectIter != _gameObjectMap.end())
     {
+        removeFromSpatialCells(uniqueID);
+        auto elementIter = _spatialElementMap.find(uniqueID);
+        if (elementIter != _spatialElementMap.end())
+        {
+            releaseOccupyTile(elementIter->second);
+            removeFromPickingCells(elementIter->second);
+            _spatialElementMap.erase(elementIter);
+        }
+
         gameObjectIter->second->removeFromParent();
         _gameObjectMap.erase(uniqueID);
     }
@@ -97,6 +123,17 @@ void GameObjectManager::removeGameObjectBy(int uniqueID)
 
 void GameObjectManager::removeAllGameObjects()
 {
+    for (auto& spatialCell : _spatialCellList)
+    {
+        spatialCell.clear();
+    }
+    for (auto& pickingCell : _pickingCellList)
+    {
+        pickingCell.clear();
+    }
+    _spatialElementMap.clear();
+    _npcCountInTileList.assign(_npcCountInTileList.size(), 0);
+
     for (auto& gameObjectIter : _gameObjectMap)
     {
         gameObjectIter.second->removeFromParent();
@@ -136,6 +173,762 @@ const GameObjectMap& GameObjectManager::getGameObjectMap()
     return _gameObjectMap;
 }
 
+void GameObjectManager::initSpatialGrid(const Size& mapSize, const Size& tileSize)
+{
+    _spatialCellSize = tileSize;
+    _spatialColumnCount = std::max((int)mapSize.width, 1);
+    _spatialRowCount = std::max((int)mapSize.height, 1);
+
+    _spatialCellList.clear();
+    _spatialCellList.resize(_spatialColumnCount * _spatialRowCount);
+    _spatialElementMap.clear();
+    _npcCountInTileList.assign(_spatialColumnCount * _spatialRowCount, 0);
+
+    _pickingColumnCount = std::max((int)ceilf(_spatialColumnCount * tileSize.width / PICKING_CELL_SIZE), 1);
+    _pickingRowCount = std::max((int)ceilf(_spatialRowCount * tileSize.height / PICKING_CELL_SIZE), 1);
+    _pickingCellList.clear();
+    _pickingCellList.resize(_pickingColumnCount * _pickingRowCount);
+}
+
+void GameObjectManager::updateSpatialIndexOf(GameObject* gameObject)
+{
+    // 对象还没有加入_gameObjectMap时（比如在init中设置初始位置）不需要更新
+    auto elementIter = _spatialElementMap.find(gameObject->getUniqueID());
+    if (elementIter == _spatialElementMap.end() || _spatialCellList.empty())
+    {
+        return;
+    }
+
+    auto& element = elementIter->second;
+    element.bounds = computeSpatialBounds(gameObject);
+    updateOccupyTile(element);
+    updatePickingCells(element);
+
+    // npc每帧都会移动，但大部分时间还在同一个桶里，这时只需要更新包围盒
+    auto cellRange = computeSpatialCellRange(element.bounds);
+    if (cellRange.minColumnIndex == element.cellRange.minColumnIndex &&
+        cellRange.minRowIndex == element.cellRange.minRowIndex &&
+        cellRange.maxColumnIndex == element.cellRange.maxColumnIndex &&
+        cellRange.maxRowIndex == element.cellRange.maxRowIndex)
+    {
+        for (int columnIndex = cellRange.minColumnIndex; columnIndex <= cellRange.maxColumnIndex; columnIndex++)
+        {
+            for (int rowIndex = cellRange.minRowIndex; rowIndex <= cellRange.maxRowIndex; rowIndex++)
+            {
+                for (auto& cellElement : _spatialCellList[columnIndex * _spatialRowCount + rowIndex])
+                {
+                    if (cellElement.uniqueID == element.uniqueID)
+                    {
+                        cellElement.bounds = element.bounds;
+                        break;
+                    }
+                }
+            }
+        }
+
+        return;
+    }
+
+    removeFromSpatialCells(element.uniqueID);
+    element.cellRange = cellRange;
+    addToSpatialCells(element);
+}
+
+void GameObjectManager::updateOccupyTile(SpatialCellElement& element)
+{
+    if (element.gameObject->getGameObjectType() != GameObjectType::Npc)
+    {
+        return;
+    }
+
+    auto mapManager = GameWorldCallBackFunctionsManager::getInstance()->_getMapManager();
+    auto tileSubscript = mapManager->getTileSubscript(element.gameObject->getPosition());
+    int tileIndex = (int)tileSubscript.x * _spatialRowCount + (int)tileSubscript.y;
+    if (tileIndex != element.occupyTileIndex)
+    {
+        releaseOccupyTile(element);
+        _npcCountInTileList[tileIndex]++;
+        element.occupyTileIndex = tileIndex;
+    }
+}
+
+void GameObjectManager::releaseOccupyTile(SpatialCellElement& element)
+{
+    if (element.occupyTileIndex >= 0)
+    {
+        _npcCountInTileList[element.occupyTileIndex]--;
+        element.occupyTileIndex = -1;
+    }
+}
+
+int GameObjectManager::getNpcCountInTile(int columnIndex, int rowIndex)
+{
+    int result = 0;
+
+    if (columnIndex >= 0 && columnIndex < _spatialColumnCount && rowIndex >= 0 && rowIndex < _spatialRowCount &&
+        !_npcCountInTileList.empty())
+    {
+        result = _npcCountInTileList[columnIndex * _spatialRowCount + rowIndex];
+    }
+
+    return result;
+}
+
+bool GameObjectManager::isTileCoveredByNpc(const Vec2& inMapPosition)
+{
+    auto mapManager = GameWorldCallBackFunctionsManager::getInstance()->_getMapManager();
+    auto tileSubscript = mapManager->getTileSubscript(inMapPosition);
+
+    return getNpcCountInTile((int)tileSubscript.x, (int)tileSubscript.y) > 0;
+}
+
+Rect GameObjectManager::computePickingBounds(GameObject* gameObject)
+{
+    // 与图片的显示范围一致：以位置为中心、大小为contentSize的矩形，地图缩放不影响地图坐标系中的大小
+    auto& position = gameObject->getPosition();
+    auto& contentSize = gameObject->getContentSize();
+
+    return Rect(position.x - contentSize.width / 2.0f, position.y - contentSize.height / 2.0f, contentSize.width, contentSize.height);
+}
+
+SpatialCellRange GameObjectManager::computePickingCellRange(const Rect& bounds)
+{
+    SpatialCellRange cellRange;
+    cellRange.minColumnIndex = std::min(std::max((int)floorf(bounds.getMinX() / PICKING_CELL_SIZE), 0), _pickingColumnCount - 1);
+    cellRange.minRowIndex = std::min(std::max((int)floorf(bounds.getMinY() / PICKING_CELL_SIZE), 0), _pickingRowCount - 1);
+    cellRange.maxColumnIndex = std::min(std::max((int)floorf(bounds.getMaxX() / PICKING_CELL_SIZE), 0), _pickingColumnCount - 1);
+    cellRange.maxRowIndex = std::min(std::max((int)floorf(bounds.getMaxY() / PICKING_CELL_SIZE), 0), _pickingRowCount - 1);
+
+    return cellRange;
+}
+
+void GameObjectManager::updatePickingCells(SpatialCellElement& element)
+{
+    element.pickingBounds = computePickingBounds(element.gameObject);
+
+    auto cellRange = computePickingCellRange(element.pickingBounds);
+    if (cellRange.minColumnIndex == element.pickingCellRange.minColumnIndex &&
+        cellRange.minRowIndex == element.pickingCellRange.minRowIndex &&
+        cellRange.maxColumnIndex == element.pickingCellRange.maxColumnIndex &&
+        cellRange.maxRowIndex == element.pickingCellRange.maxRowIndex)
+    {
+        for (int columnIndex = cellRange.minColumnIndex; columnIndex <= cellRange.maxColumnIndex; columnIndex++)
+        {
+            for (int rowIndex = cellRange.minRowIndex; rowIndex <= cellRange.maxRowIndex; rowIndex++)
+            {
+                for (auto& cellElement : _pickingCellList[columnIndex * _pickingRowCount + rowIndex])
+                {
+                    if (cellElement.uniqueID == element.uniqueID)
+                    {
+                        cellElement.pickingBounds = element.pickingBounds;
+                        break;
+                    }
+                }
+            }
+        }
+
+        return;
+    }
+
+    removeFromPickingCells(element);
+    element.pickingCellRange = cellRange;
+    for (int columnIndex = cellRange.minColumnIndex; columnIndex <= cellRange.maxColumnIndex; columnIndex++)
+    {
+        for (int rowIndex = cellRange.minRowIndex; rowIndex <= cellRange.maxRowIndex; rowIndex++)
+        {
+            _pickingCellList[columnIndex * _pickingRowCount + rowIndex].push_back(element);
+        }
+    }
+}
+
+void GameObjectManager::removeFromPickingCells(SpatialCellElement& element)
+{
+    auto& cellRange = element.pickingCellRange;
+    for (int columnIndex = cellRange.minColumnIndex; columnIndex <= cellRange.maxColumnIndex; columnIndex++)
+    {
+        for (int rowIndex = cellRange.minRowIndex; rowIndex <= cellRange.maxRowIndex; rowIndex++)
+        {
+            auto& pickingCell = _pickingCellList[columnIndex * _pickingRowCount + rowIndex];
+            for (int elementIndex = 0; elementIndex < (int)pickingCell.size(); elementIndex++)
+            {
+                if (pickingCell[elementIndex].uniqueID == element.uniqueID)
+                {
+                    pickingCell[elementIndex] = pickingCell.back();
+                    pickingCell.pop_back();
+                    break;
+                }
+            }
+        }
+    }
+
+    element.pickingCellRange = SpatialCellRange();
+}
+
+GameObject* GameObjectManager::pickGameObjectAt(const Vec2& cursorPoint, ForceType forceType, bool isExceptPrepareToBuild)
+{
+    GameObject* result = nullptr;
+    if (_pickingCellList.empty())
+    {
+        return result;
+    }
+
+    auto mapManager = GameWorldCallBackFunctionsManager::getInstance()->_getMapManager();
+    auto inMapCursorPoint = mapManager->convertToTileMapSpace(cursorPoint);
+
+    // 图片覆盖了鼠标所在的点，就一定登记在这个点所在的桶里，只需要检查一个桶；地图外的部分登记在边缘的桶里
+    int columnIndex = std::min(std::max((int)floorf(inMapCursorPoint.x / PICKING_CELL_SIZE), 0), _pickingColumnCount - 1);
+    int rowIndex = std::min(std::max((int)floorf(inMapCursorPoint.y / PICKING_CELL_SIZE), 0), _pickingRowCount - 1);
+    float maxPositionZ = -FLT_MAX;
+    for (auto& element : _pickingCellList[columnIndex * _pickingRowCount + rowIndex])
+    {
+        auto gameObject = element.gameObject;
+        if (!element.pickingBounds.containsPoint(inMapCursorPoint) ||
+            gameObject->isReadyToRemove() ||
+            (forceType != ForceType::Invalid && gameObject->getForceType() != forceType))
+        {
+            continue;
+        }
+
+        if (isExceptPrepareToBuild && gameObject->getGameObjectType() == GameObjectType::Building &&
+            static_cast<Building*>(gameObject)->getBuildingStatus() == BuildingStatus::PrepareToBuild)
+        {
+            continue;
+        }
+
+        // 深度排序以后位置越靠前的对象positionZ越大
+        if (gameObject->getPositionZ() > maxPositionZ)
+        {
+            maxPositionZ = gameObject->getPositionZ();
+            result = gameObject;
+        }
+    }
+
+    return result;
+}
+
+void GameObjectManager::queryGameObjectsInRadius(const Vec2& center, float radius, const GameObjectQueryFilter& filter, vector<GameObject*>& gameObjectList)
+{
+    gameObjectList.clear();
+
+    Rect queryBounds(center.x - radius, center.y - radius, radius * 2.0f, radius * 2.0f);
+    collectInSpatialCells(queryBounds, filter, &center, radius, gameObjectList);
+}
+
+void GameObjectManager::queryGameObjectsInRect(const Rect& rect, const GameObjectQueryFilter& filter, vector<GameObject*>& gameObjectList)
+{
+    gameObjectList.clear();
+
+    collectInSpatialCells(rect, filter, nullptr, 0.0f, gameObjectList);
+}
+
+static bool isNearer(const NearestGameObject& left, const NearestGameObject& right)
+{
+    if (left.distance != right.distance)
+    {
+        return left.distance < right.distance;
+    }
+
+    return left.uniqueID < right.uniqueID;
+}
+
+void GameObjectManager::queryNearestGameObjects(const Vec2& center, float maxRadius, int count, const GameObjectQueryFilter& filter, vector<GameObject*>& gameObjectList)
+{
+    gameObjectList.clear();
+    _nearestGameObjectList.clear();
+    _visitedMultiCellUniqueIDList.clear();
+    if (_spatialCellList.empty() || count <= 0)
+    {
+        return;
+    }
+
+    auto centerCellRange = computeSpatialCellRange(Rect(center.x, center.y, 0.0f, 0.0f));
+    int centerColumnIndex = centerCellRange.minColumnIndex;
+    int centerRowIndex = centerCellRange.minRowIndex;
+    float cellLength = std::min(_spatialCellSize.width, _spatialCellSize.height);
+    int maxRing = std::max(_spatialColumnCount, _spatialRowCount);
+
+    for (int ring = 0; ring <= maxRing; ring++)
+    {
+        // 第ring圈的桶与center之间至少隔着ring - 1个完整的桶
+        float ringMinDistance = std::max(ring - 1, 0) * cellLength;
+        if (ringMinDistance > maxRadius)
+        {
+            break;
+        }
+
+        if ((int)_nearestGameObjectList.size() >= count)
+        {
+            std::nth_element(_nearestGameObjectList.begin(), _nearestGameObjectList.begin() + (count - 1), _nearestGameObjectList.end(), isNearer);
+            if (_nearestGameObjectList[count - 1].distance <= ringMinDistance)
+            {
+                break;
+            }
+        }
+
+        for (int columnIndex = centerColumnIndex - ring; columnIndex <= centerColumnIndex + ring; columnIndex++)
+        {
+            if (columnIndex < 0 || columnIndex >= _spatialColumnCount)
+            {
+                continue;
+            }
+
+            // 中间的列只有上下两个桶在这一圈上
+            int rowStep = (columnIndex == centerColumnIndex - ring || columnIndex == centerColumnIndex + ring) ? 1 : std::max(ring * 2, 1);
+            for (int rowIndex = centerRowIndex - ring; rowIndex <= centerRowIndex + ring; rowIndex += rowStep)
+            {
+                if (rowIndex >= 0 && rowIndex < _spatialRowCount)
+                {
+                    collectNearestInSpatialCell(columnIndex, rowIndex, center, maxRadius, filter);
+                }
+            }
+        }
+    }
+
+    std::sort(_nearestGameObjectList.begin(), _nearestGameObjectList.end(), isNearer);
+    for (int index = 0; index < (int)_nearestGameObjectList.size() && index < count; index++)
+    {
+        gameObjectList.push_back(_nearestGameObjectList[index].gameObject);
+    }
+}
+
+float GameObjectManager::getMaxCollisionRadius()
+{
+    return _maxCollisionRadius;
+}
+
+float GameObjectManager::getMaxExtraEnemyAttackRadius()
+{
+    return _maxExtraEnemyAttackRadius;
+}
+
+Rect GameObjectManager::computeSpatialBounds(GameObject* gameObject)
+{
+    auto& position = gameObject->getPosition();
+    float minX = position.x;
+    float minY = position.y;
+    float maxX = position.x;
+    float maxY = position.y;
+
+    // 到建筑物的距离按照最近的占地格子计算，包围盒需要包含所有占地格子
+    if (gameObject->getGameObjectType() == GameObjectType::Building)
+    {
+        auto building = static_cast<Building*>(gameObject);
+        for (auto& bottomGridInMapPosition : building->getBottomGridInMapPositionList())
+        {
+            minX = std::min(minX, bottomGridInMapPosition.x);
+            minY = std::min(minY, bottomGridInMapPosition.y);
+            maxX = std::max(maxX, bottomGridInMapPosition.x);
+            maxY = std::max(maxY, bottomGridInMapPosition.y);
+        }
+    }
+
+    return Rect(minX, minY, maxX - minX, maxY - minY);
+}
+
+SpatialCellRange GameObjectManager::computeSpatialCellRange(const Rect& bounds)
+{
+    // 地图外的对象放在边缘的桶里
+    SpatialCellRange cellRange;
+    cellRange.minColumnIndex = std::min(std::max((int)floorf(bounds.getMinX() / _spatialCellSize.width), 0), _spatialColumnCount - 1);
+    cellRange.minRowIndex = std::min(std::max((int)floorf(bounds.getMinY() / _spatialCellSize.height), 0), _spatialRowCount - 1);
+    cellRange.maxColumnIndex = std::min(std::max((int)floorf(bounds.getMaxX() / _spatialCellSize.width), 0), _spatialColumnCount - 1);
+    cellRange.maxRowIndex = std::min(std::max((int)floorf(bounds.getMaxY() / _spatialCellSize.height), 0), _spatialRowCount - 1);
+
+    return cellRange;
+}
+
+void GameObjectManager::addToSpatialCells(const SpatialCellElement& element)
+{
+    auto& cellRange = element.cellRange;
+    for (int columnIndex = cellRange.minColumnIndex; columnIndex <= cellRange.maxColumnIndex; columnIndex++)
+    {
+        for (int rowIndex = cellRange.minRowIndex; rowIndex <= cellRange.maxRowIndex; rowIndex++)
+        {
+            _spatialCellList[columnIndex * _spatialRowCount + rowIndex].push_back(element);
+        }
+    }
+}
+
+void GameObjectManager::removeFromSpatialCells(int uniqueID)
+{
+    auto elementIter = _spatialElementMap.find(uniqueID);
+    if (elementIter == _spatialElementMap.end())
+    {
+        return;
+    }
+
+    auto& cellRange = elementIter->second.cellRange;
+    for (int columnIndex = cellRange.minColumnIndex; columnIndex <= cellRange.maxColumnIndex; columnIndex++)
+    {
+        for (int rowIndex = cellRange.minRowIndex; rowIndex <= cellRange.maxRowIndex; rowIndex++)
+        {
+            auto& spatialCell = _spatialCellList[columnIndex * _spatialRowCount + rowIndex];
+            for (int elementIndex = 0; elementIndex < (int)spatialCell.size(); elementIndex++)
+            {
+                if (spatialCell[elementIndex].uniqueID == uniqueID)
+                {
+                    spatialCell[elementIndex] = spatialCell.back();
+                    spatialCell.pop_back();
+                    break;
+                }
+            }
+        }
+    }
+
+    elementIter->second.cellRange = SpatialCellRange();
+}
+
+bool GameObjectManager::isMatchQueryFilter(const SpatialCellElement& element, const GameObjectQueryFilter& filter)
+{
+    bool result = false;
+
+    auto gameObject = element.gameObject;
+    if (element.uniqueID == filter.exceptUniqueID ||
+        (filter.forceType != ForceType::Invalid && gameObject->getForceType() != filter.forceType) ||
+        (filter.gameObjectType != GameObjectType::Invalid && gameObject->getGameObjectType() != filter.gameObjectType) ||
+        (filter.layer == GameObjectLayer::Ground && element.isAir) ||
+        (filter.layer == GameObjectLayer::Air && !element.isAir) ||
+        (!filter.isIncludeReadyToRemove && gameObject->isReadyToRemove()) ||
+        (filter.isEnemyApproachableOnly && !gameObject->canEnemyApproach()))
+    {
+        result = false;
+    }
+    else if (filter.isEnemyApproachableOnly && gameObject->getGameObjectType() == GameObjectType::Building &&
+        static_cast<Building*>(gameObject)->getBuildingStatus() == BuildingStatus::PrepareToBuild)
+    {
+        result = false;
+    }
+    else
+    {
+        result = true;
+    }
+
+    return result;
+}
+
+void GameObjectManager::collectInSpatialCells(const Rect& queryBounds, const GameObjectQueryFilter& filter, const Vec2* center, float radius,
+    vector<GameObject*>& gameObjectList)
+{
+    if (_spatialCellList.empty())
+    {
+        return;
+    }
+
+    auto queryCellRange = computeSpatialCellRange(queryBounds);
+    for (int columnIndex = queryCellRange.minColumnIndex; columnIndex <= queryCellRange.maxColumnIndex; columnIndex++)
+    {
+        for (int rowIndex = queryCellRange.minRowIndex; rowIndex <= queryCellRange.maxRowIndex; rowIndex++)
+        {
+            for (auto& element : _spatialCellList[columnIndex * _spatialRowCount + rowIndex])
+            {
+                // 跨多个桶的建筑物只在与查询范围重叠的第一个桶里返回一次
+                auto& cellRange = element.cellRange;
+                if (columnIndex != std::max(cellRange.minColumnIndex, queryCellRange.minColumnIndex) ||
+                    rowIndex != std::max(cellRange.minRowIndex, queryCellRange.minRowIndex))
+                {
+                    continue;
+                }
+
+                auto& bounds = element.bounds;
+                if (bounds.getMaxX() < queryBounds.getMinX() || bounds.getMinX() > queryBounds.getMaxX() ||
+                    bounds.getMaxY() < queryBounds.getMinY() || bounds.getMinY() > queryBounds.getMaxY())
+                {
+                    continue;
+                }
+
+                if (center)
+                {
+                    Vec2 nearestPosition(std::min(std::max(center->x, bounds.getMinX()), bounds.getMaxX()),
+                        std::min(std::max(center->y, bounds.getMinY()), bounds.getMaxY()));
+                    if (nearestPosition.distanceSquared(*center) > radius * radius)
+                    {
+                        continue;
+                    }
+                }
+
+                if (isMatchQueryFilter(element, filter))
+                {
+                    gameObjectList.push_back(element.gameObject);
+                }
+            }
+        }
+    }
+}
+
+void GameObjectManager::npcCollisionTest()
+{
+    _npcCollisionPairList.clear();
+    collectNpcCollisionPairs(_npcCollisionPairList);
+    for (auto& collisionPair : _npcCollisionPairList)
+    {
+        collisionPair.npc->addCollisionWith(collisionPair.otherNpc, collisionPair.realDistance, collisionPair.constraintDistance);
+        collisionPair.otherNpc->addCollisionWith(collisionPair.npc, collisionPair.realDistance, collisionPair.constraintDistance);
+    }
+
+    for (auto& gameObjectIter : _gameObjectMap)
+    {
+        if (gameObjectIter.second->getGameObjectType() == GameObjectType::Npc)
+        {
+            static_cast<Npc*>(gameObjectIter.second)->resolveCollision();
+        }
+    }
+}
+
+NpcCollisionBenchmarkReport GameObjectManager::runNpcCollisionBenchmark(int frameCount)
+{
+    NpcCollisionBenchmarkReport report;
+    report.frameCount = frameCount;
+    if (frameCount <= 0)
+    {
+        return report;
+    }
+
+    for (auto& gameObjectIter : _gameObjectMap)
+    {
+        if (gameObjectIter.second->getGameObjectType() == GameObjectType::Npc && !gameObjectIter.second->isReadyToRemove())
+        {
+            report.npcCount++;
+        }
+    }
+
+    vector<NpcCollisionPair> pairList;
+    auto startMicroseconds = GameUtils::getMicroseconds();
+    for (int frameIndex = 0; frameIndex < frameCount; frameIndex++)
+    {
+        pairList.clear();
+        collectNpcCollisionPairsByRadiusQuery(pairList);
+    }
+    report.radiusQueryMicroseconds = (GameUtils::getMicroseconds() - startMicroseconds) / frameCount;
+    report.radiusQueryPairCount = (int)pairList.size();
+
+    startMicroseconds = GameUtils::getMicroseconds();
+    for (int frameIndex = 0; frameIndex < frameCount; frameIndex++)
+    {
+        pairList.clear();
+        collectNpcCollisionPairs(pairList);
+    }
+    report.broadphaseMicroseconds = (GameUtils::getMicroseconds() - startMicroseconds) / frameCount;
+    report.broadphasePairCount = (int)pairList.size();
+
+    return report;
+}
+
+void GameObjectManager::collectNpcCollisionPairs(vector<NpcCollisionPair>& pairList)
+{
+    if (_spatialCellList.empty())
+    {
+        return;
+    }
+
+    // 两个npc的碰撞半径之和不超过2 * _maxCollisionRadius，只需要检查这个距离以内的桶；
+    // 每个桶只和右边以及同一列上方的桶配对，相邻的两个桶只检查一次
+    int reachColumnCount = (int)ceilf(_maxCollisionRadius * 2.0f / _spatialCellSize.width);
+    int reachRowCount = (int)ceilf(_maxCollisionRadius * 2.0f / _spatialCellSize.height);
+    for (int columnIndex = 0; columnIndex < _spatialColumnCount; columnIndex++)
+    {
+        for (int rowIndex = 0; rowIndex < _spatialRowCount; rowIndex++)
+        {
+            auto& spatialCell = _spatialCellList[columnIndex * _spatialRowCount + rowIndex];
+            for (int elementIndex = 0; elementIndex < (int)spatialCell.size(); elementIndex++)
+            {
+                auto& element = spatialCell[elementIndex];
+                if (!isCollidable(element))
+                {
+                    continue;
+                }
+
+                for (int otherElementIndex = elementIndex + 1; otherElementIndex < (int)spatialCell.size(); otherElementIndex++)
+                {
+                    testNpcCollisionBetween(element, spatialCell[otherElementIndex], pairList);
+                }
+
+                for (int besideColumnIndex = columnIndex; besideColumnIndex <= std::min(columnIndex + reachColumnCount, _spatialColumnCount - 1); besideColumnIndex++)
+                {
+                    int minBesideRowIndex = besideColumnIndex == columnIndex ? rowIndex + 1 : std::max(rowIndex - reachRowCount, 0);
+                    for (int besideRowIndex = minBesideRowIndex; besideRowIndex <= std::min(rowIndex + reachRowCount, _spatialRowCount - 1); besideRowIndex++)
+                    {
+                        for (auto& otherElement : _spatialCellList[besideColumnIndex * _spatialRowCount + besideRowIndex])
+                        {
+                            testNpcCollisionBetween(element, otherElement, pairList);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void GameObjectManager::collectNpcCollisionPairsByRadiusQuery(vector<NpcCollisionPair>& pairList)
+{
+    // 每个npc查询碰撞半径之和以内的同层npc，每一对会被双方各找到一次，只记录uniqueID小的一方找到的那次
+    vector<GameObject*> nearbyGameObjectList;
+    for (auto& elementIter : _spatialElementMap)
+    {
+        auto& element = elementIter.second;
+        if (!isCollidable(element))
+        {
+            continue;
+        }
+
+        auto npc = static_cast<Npc*>(element.gameObject);
+        GameObjectQueryFilter collisionFilter;
+        collisionFilter.gameObjectType = GameObjectType::Npc;
+        collisionFilter.layer = element.isAir ? GameObjectLayer::Air : GameObjectLayer::Ground;
+        collisionFilter.exceptUniqueID = element.uniqueID;
+
+        queryGameObjectsInRadius(npc->getPosition(), npc->getCollisionRadius() + _maxCollisionRadius, collisionFilter, nearbyGameObjectList);
+        for (auto gameObject : nearbyGameObjectList)
+        {
+            if (gameObject->getUniqueID() < element.uniqueID)
+            {
+                continue;
+            }
+
+            auto otherNpc = static_cast<Npc*>(gameObject);
+            float realDistance = GameUtils::computeDistanceBetween(npc->getPosition(), otherNpc->getPosition());
+            float constraintDistance = npc->getCollisionRadius() + otherNpc->getCollisionRadius();
+            if (realDistance < constraintDistance)
+            {
+                NpcCollisionPair collisionPair;
+                collisionPair.npc = npc;
+                collisionPair.otherNpc = otherNpc;
+                collisionPair.realDistance = realDistance;
+                collisionPair.constraintDistance = constraintDistance;
+                pairList.push_back(collisionPair);
+            }
+        }
+    }
+}
+
+void GameObjectManager::updateLocalAvoidance(float deltaTime)
+{
+    g_avoidanceAgentList.clear();
+    g_avoidanceNpcList.clear();
+
+    for (auto& gameObjectIter : _gameObjectMap)
+    {
+        auto gameObject = gameObjectIter.second;
+        if (gameObject->getGameObjectType() != GameObjectType::Npc || gameObject->isReadyToRemove())
+        {
+            continue;
+        }
+
+        auto npc = static_cast<Npc*>(gameObject);
+
+        AvoidanceAgent agent;
+        agent.position = npc->getPosition();
+        agent.preferredVelocity = npc->computePreferredVelocity();
+        agent.isMoving = (agent.preferredVelocity != Vec2::ZERO);
+        agent.velocity = agent.isMoving ? npc->getAvoidanceVelocity() : Vec2::ZERO;
+        agent.radius = npc->getCollisionRadius();
+        agent.maxSpeed = npc->getPerSecondMoveSpeedByPixel();
+        agent.isAir = npc->isAir();
+
+        g_avoidanceAgentList.push_back(agent);
+        g_avoidanceNpcList.push_back(npc);
+    }
+
+    LocalAvoidanceHelper::computeNewVelocities(g_avoidanceAgentList, deltaTime);
+
+    for (int agentIndex = 0; agentIndex < (int)g_avoidanceAgentList.size(); agentIndex++)
+    {
+        g_avoidanceNpcList[agentIndex]->applyAvoidanceVelocity(g_avoidanceAgentList[agentIndex].newVelocity, deltaTime);
+    }
+}
+
+int GameObjectManager::getAvoidanceAgentCount()
+{
+    return (int)g_avoidanceAgentList.size();
+}
+
+bool GameObjectManager::isCollidable(const SpatialCellElement& element)
+{
+    // 建筑物和建筑物里的防守npc不参与碰撞
+    return element.gameObject->getGameObjectType() == GameObjectType::Npc && !element.gameObject->isReadyToRemove();
+}
+
+void GameObjectManager::testNpcCollisionBetween(const SpatialCellElement& element, const SpatialCellElement& otherElement, vector<NpcCollisionPair>& pairList)
+{
+    // 空军只和空军碰撞，陆军只和陆军碰撞
+    if (element.isAir != otherElement.isAir || !isCollidable(otherElement))
+    {
+        return;
+    }
+
+    auto npc = static_cast<Npc*>(element.gameObject);
+    auto otherNpc = static_cast<Npc*>(otherElement.gameObject);
+    float realDistance = GameUtils::computeDistanceBetween(npc->getPosition(), otherNpc->getPosition());
+    float constraintDistance = npc->getCollisionRadius() + otherNpc->getCollisionRadius();
+    if (realDistance < constraintDistance)
+    {
+        NpcCollisionPair collisionPair;
+        collisionPair.npc = npc;
+        collisionPair.otherNpc = otherNpc;
+        collisionPair.realDistance = realDistance;
+        collisionPair.constraintDistance = constraintDistance;
+        pairList.push_back(collisionPair);
+    }
+}
+
+float GameObjectManager::computeDistanceToSpatialElement(const Vec2& position, const SpatialCellElement& element)
+{
+    auto gameObject = element.gameObject;
+    float distance = GameUtils::computeDistanceBetween(position, gameObject->getPosition());
+
+    // 与Npc::computeArrivePositionBy一致，到建筑物的距离是到最近的占地格子的距离
+    if (gameObject->getGameObjectType() == GameObjectType::Building)
+    {
+        auto building = static_cast<Building*>(gameObject);
+        if (!building->getBottomGridInMapPositionList().empty())
+        {
+            distance = GameUtils::computeDistanceBetween(position, building->computeNearestBottomGridInMapPosition(position));
+        }
+    }
+
+    return distance;
+}
+
+void GameObjectManager::collectNearestInSpatialCell(int columnIndex, int rowIndex, const Vec2& center, float maxRadius, const GameObjectQueryFilter& filter)
+{
+    for (auto& element : _spatialCellList[columnIndex * _spatialRowCount + rowIndex])
+    {
+        // 包围盒到center的距离是实际距离的下界，超出范围的建筑物不需要逐个计算占地格子
+        auto& bounds = element.bounds;
+        Vec2 nearestPosition(std::min(std::max(center.x, bounds.getMinX()), bounds.getMaxX()),
+            std::min(std::max(center.y, bounds.getMinY()), bounds.getMaxY()));
+        if (nearestPosition.distanceSquared(center) > maxRadius * maxRadius)
+        {
+            continue;
+        }
+
+        auto& cellRange = element.cellRange;
+        if (cellRange.minColumnIndex != cellRange.maxColumnIndex || cellRange.minRowIndex != cellRange.maxRowIndex)
+        {
+            if (std::find(_visitedMultiCellUniqueIDList.begin(), _visitedMultiCellUniqueIDList.end(), element.uniqueID) != _visitedMultiCellUniqueIDList.end())
+            {
+                continue;
+            }
+
+            _visitedMultiCellUniqueIDList.push_back(element.uniqueID);
+        }
+
+        if (!isMatchQueryFilter(element, filter))
+        {
+            continue;
+        }
+
+        float distance = computeDistanceToSpatialElement(center, element);
+        if (distance <= maxRadius)
+        {
+            NearestGameObject nearestGameObject;
+            nearestGameObject.distance = distance;
+            nearestGameObject.uniqueID = element.uniqueID;
+            nearestGameObject.gameObject = element.gameObject;
+            _nearestGameObjectList.push_back(nearestGameObject);
+        }
+    }
+}
+
 void GameObjectManager::gameObjectsDepthSort(const Size& tileSize)
 {
     for (auto& gameObjectIter : _gameObjectMap)
@@ -203,35 +996,7 @@ bool GameObjectManager::selectGameObjectsBy(const Rect& rect, const string templ
 
 GameObject* GameObjectManager::getGameObjectContain(const Vec2& cursorPoint)
 {
-    GameObject* gameObject = nullptr;
-
-    for (auto& gameObjectIter : _gameObjectMap)
-    {
-        if (gameObjectIter.second->isReadyToRemove())
-        {
-            continue;
-        }
-
-        if (gameObjectIter.second->getGameObjectType() == GameObjectType::Building)
-        {
-            auto building = static_cast<Building*>(gameObjectIter.second);
-            if (building->getBuildingStatus() == BuildingStatus::PrepareToBuild)
-            {
-                continue;
-            }
-        }
-
-        auto gameObjectRect = computeGameObjectRect(gameObjectIter.second);
-
-        if (gameObjectRect.containsPoint(cursorPoint))
-        {
-            gameObject = gameObjectIter.second;
-
-            break;
-        }
-    }
-
-    return gameObject;
+    return pickGameObjectAt(cursorPoint, ForceType::Invalid, true);
 }
 
 GameObject* GameObjectManager::selectGameObjectBy(const Point& cursorPoint)
@@ -248,24 +1013,11 @@ GameObject* GameObjectManager::selectGameObjectBy(const Point& cursorPoint)
 
 GameObject* GameObjectManager::selectEnemyBy(const Point& cursorPoint)
 {
-    GameObject* enemy = nullptr;
+    GameObject* enemy = pickGameObjectAt(cursorPoint, ForceType::AI, false);
 
-    for (auto& gameObjectIter : _gameObjectMap)
+    if (enemy)
     {
-        if (gameObjectIter.second->isReadyToRemove() || gameObjectIter.second->getForceType() != ForceType::AI)
-        {
-            continue;
-        }
-
-        auto gameObjectRect = computeGameObjectRect(gameObjectIter.second);
-
-        if (gameObjectRect.containsPoint(cursorPoint))
-        {
-            enemy = gameObjectIter.second;
-            gameObjectIter.second->setSelected(true);
-
-            break;
-        }
+        enemy->setSelected(true);
     }
 
     return enemy;
@@ -340,8 +1092,11 @@ void GameObjectManager::npcSelectedByPlayerMoveTo(const Vec2& position, bool sho
         _belongPlayerSelectedNpcIDList.sort(LessDistanceChecker(position));
 
         _npcReadyMoveToTargetDataMap[ForceType::Player]._npcMoveTargetList = computeBelongPlayerSelectedNpcArrivePositionList(position);
+        _npcReadyMoveToTargetDataMap[ForceType::Player]._flowFieldTargetPosition = position;
 
         _npcReadyMoveToTargetDataMap[ForceType::Player]._readyMoveToTargetNpcIDList = _belongPlayerSelectedNpcIDList;
+        _moveOrderNpcIDList = _belongPlayerSelectedNpcIDList;
+        _moveOrderElapsedTime = 0.0f;
         for (auto npcID : _belongPlayerSelectedNpcIDList)
         {
             auto gameObjectIter = _gameObjectMap.find(npcID);
@@ -387,7 +1142,7 @@ void GameObjectManager::npcMoveToTargetOneByOne()
             }
 
             auto targetPosition = dataIter.second._npcMoveTargetList.front();
-            readyMoveToTargetNpc->moveTo(targetPosition);
+            readyMoveToTargetNpc->moveAlongFlowFieldTo(dataIter.second._flowFieldTargetPosition, targetPosition);
             if (readyMoveToTargetNpc->isExecutingMopUpCommand())
             {
                 MopUpCommand mopUpCommand;
@@ -402,6 +1157,54 @@ void GameObjectManager::npcMoveToTargetOneByOne()
     }
 }
 
+void GameObjectManager::updateMoveStatistics(float deltaTime)
+{
+    _lastFrameNpcCollisionCount = _npcCollisionCountInFrame;
+    _npcCollisionCountInFrame = 0;
+
+    if (_moveOrderNpcIDList.empty())
+    {
+        return;
+    }
+
+    // 还在等待出发或者还在移动的npc都算没有到达，死亡的npc不再等待
+    _moveOrderElapsedTime += deltaTime;
+    auto npcIDIter = _moveOrderNpcIDList.begin();
+    while (npcIDIter != _moveOrderNpcIDList.end())
+    {
+        auto gameObjectIter = _gameObjectMap.find(*npcIDIter);
+        auto npc = gameObjectIter != _gameObjectMap.end() ? static_cast<Npc*>(gameObjectIter->second) : nullptr;
+        if (npc && !npc->isReadyToRemove() && (npc->isReadyToMove() || npc->getNpcStatus() == NpcStatus::Move))
+        {
+            ++npcIDIter;
+        }
+        else
+        {
+            npcIDIter = _moveOrderNpcIDList.erase(npcIDIter);
+        }
+    }
+
+    if (_moveOrderNpcIDList.empty())
+    {
+        _lastMoveOrderArriveTime = _moveOrderElapsedTime;
+    }
+}
+
+void GameObjectManager::addNpcCollisionCount(int collisionCount)
+{
+    _npcCollisionCountInFrame += collisionCount;
+}
+
+int GameObjectManager::getLastFrameNpcCollisionCount()
+{
+    return _lastFrameNpcCollisionCount;
+}
+
+float GameObjectManager::getLastMoveOrderArriveTime()
+{
+    return _lastMoveOrderArriveTime;
+}
+
 void GameObjectManager::setSelectedEnemyUniqueID(int uniqueID)
 {
     for (auto& gameObject : _gameObjectMap)
@@ -508,18 +1311,6 @@ void GameObjectManager::selectPlayerTeamMemberBy(int teamID, bool enableSelectMu
     _belongPlayerSelectedNpcIDList = teamMemberIDLists;
 }
 
-Rect GameObjectManager::computeGameObjectRect(GameObject* gameObject)
-{
-    auto mapManager = GameWorldCallBackFunctionsManager::getInstance()->_getMapManager();
-    float mapScale = mapManager->getMapScale();
-
-    auto parentNode = gameObject->getParent();
-    auto worldPosition = parentNode->convertToWorldSpace(gameObject->getPosition());
-    auto contentSize = gameObject->getContentSize() * mapScale;
-
-    return Rect(worldPosition.x - contentSize.width / 2.0f, worldPosition.y - contentSize.height / 2.0f, contentSize.width, contentSize.height);
-}
-
 list<Vec2> GameObjectManager::computeBelongPlayerSelectedNpcArrivePositionList(const Vec2& arrivePosition)
 {
     list<Vec2> arrivePositionList;
@@ -547,12 +1338,12 @@ list<Vec2> GameObjectManager::computeBelongPlayerSelectedNpcArrivePositionList(c
     }
 
 
-    Vec2 turnToNextLineDelta;       // һվҪƶľ
-    Vec2 turnToNextLocationDelta;   // ӵǰŵһλõһŵһλҪƶľ
+    Vec2 turnToNextLineDelta;       // 到达下一个兵站点要移动的距离
+    Vec2 turnToNextLocationDelta;   // 从当前排第一个位置到达下一排第一个位置要移动的距离
     Vec2 startLocation;
     float moveVectorDegree = GameUtils::computeRotatedDegree(firstMoveNpc->getPosition(), arrivePosition);
     if ((moveVectorDegree >= 0.0f && moveVectorDegree < 22.5f) ||
-        (moveVectorDegree >= 337.5 && moveVectorDegree < 360.0f)) // ƶ
+        (moveVectorDegree >= 337.5 && moveVectorDegree < 360.0f)) // 向北移动
     {
         startLocation.x = arrivePosition.x - (LINEUP_MAX_NPC_COUNT_PER_LINE / 2) * MAX_WIDTH_SPACE_BETWEEN_NPC_IN_LINEUP;
         startLocation.y = arrivePosition.y;
@@ -563,7 +1354,7 @@ list<Vec2> GameObjectManager::computeBelongPlayerSelectedNpcArrivePositionList(c
         turnToNextLocationDelta.x = MAX_WIDTH_SPACE_BETWEEN_NPC_IN_LINEUP;
         turnToNextLocationDelta.y = 0.0f;
     }
-    else if (moveVectorDegree >= 22.5f && moveVectorDegree < 67.5f) // 
+    else if (moveVectorDegree >= 22.5f && moveVectorDegree < 67.5f) // 东北
     {
         startLocation.x = arrivePosition.x - (LINEUP_MAX_NPC_COUNT_PER_LINE / 2) * MAX_WIDTH_SPACE_BETWEEN_NPC_IN_LINEUP;
         startLocation.y = arrivePosition.y + (LINEUP_MAX_NPC_COUNT_PER_LINE / 2) * MAX_HEIGHT_SPACE_BETWEEN_NPC_IN_LINEUP;
@@ -574,7 +1365,7 @@ list<Vec2> GameObjectManager::computeBelongPlayerSelectedNpcArrivePositionList(c
         turnToNextLocationDelta.x = MAX_WIDTH_SPACE_BETWEEN_NPC_IN_LINEUP;
         turnToNextLocationDelta.y = -MAX_HEIGHT_SPACE_BETWEEN_NPC_IN_LINEUP;
     }
-    else if (moveVectorDegree >= 67.5 && moveVectorDegree < 112.5f) // 
+    else if (moveVectorDegree >= 67.5 && moveVectorDegree < 112.5f) // 东
     {
         startLocation.x = arrivePosition.x;
         startLocation.y = arrivePosition.y + (LINEUP_MAX_NPC_COUNT_PER_LINE / 2) * MAX_HEIGHT_SPACE_BETWEEN_NPC_IN_LINEUP;
@@ -585,7 +1376,7 @@ list<Vec2> GameObjectManager::computeBelongPlayerSelectedNpcArrivePositionList(c
         turnToNextLocationDelta.x = 0.0f;
         turnToNextLocationDelta.y = -MAX_HEIGHT_SPACE_BETWEEN_NPC_IN_LINEUP;
     }
-    else if (moveVectorDegree >= 112.5f && moveVectorDegree < 157.5f) // 
+    else if (moveVectorDegree >= 112.5f && moveVectorDegree < 157.5f) // 东南
     {
         startLocation.x = arrivePosition.x + (LINEUP_MAX_NPC_COUNT_PER_LINE / 2) * MAX_WIDTH_SPACE_BETWEEN_NPC_IN_LINEUP;
         startLocation.y = arrivePosition.y + (LINEUP_MAX_NPC_COUNT_PER_LINE / 2) * MAX_HEIGHT_SPACE_BETWEEN_NPC_IN_LINEUP;
@@ -596,7 +1387,7 @@ list<Vec2> GameObjectManager::computeBelongPlayerSelectedNpcArrivePositionList(c
         turnToNextLocationDelta.x = -MAX_WIDTH_SPACE_BETWEEN_NPC_IN_LINEUP;
         turnToNextLocationDelta.y = -MAX_HEIGHT_SPACE_BETWEEN_NPC_IN_LINEUP;
     }
-    else if (moveVectorDegree >= 157.5f && moveVectorDegree < 202.5f) // 
+    else if (moveVectorDegree >= 157.5f && moveVectorDegree < 202.5f) // 南
     {
         startLocation.x = arrivePosition.x - (LINEUP_MAX_NPC_COUNT_PER_LINE / 2) * MAX_WIDTH_SPACE_BETWEEN_NPC_IN_LINEUP;
         startLocation.y = arrivePosition.y;
@@ -607,7 +1398,7 @@ list<Vec2> GameObjectManager::computeBelongPlayerSelectedNpcArrivePositionList(c
         turnToNextLocationDelta.x = MAX_WIDTH_SPACE_BETWEEN_NPC_IN_LINEUP;
         turnToNextLocationDelta.y = 0.0f;
     }
-    else if (moveVectorDegree >= 202.5f && moveVectorDegree < 247.5f) // 
+    else if (moveVectorDegree >= 202.5f && moveVectorDegree < 247.5f) // 西南
     {
         startLocation.x = arrivePosition.x - (LINEUP_MAX_NPC_COUNT_PER_LINE / 2) * MAX_WIDTH_SPACE_BETWEEN_NPC_IN_LINEUP;
         startLocation.y = arrivePosition.y + (LINEUP_MAX_NPC_COUNT_PER_LINE / 2) * MAX_HEIGHT_SPACE_BETWEEN_NPC_IN_LINEUP;
@@ -618,7 +1409,7 @@ list<Vec2> GameObjectManager::computeBelongPlayerSelectedNpcArrivePositionList(c
         turnToNextLocationDelta.x = MAX_WIDTH_SPACE_BETWEEN_NPC_IN_LINEUP;
         turnToNextLocationDelta.y = -MAX_HEIGHT_SPACE_BETWEEN_NPC_IN_LINEUP;
     }
-    else if (moveVectorDegree >= 247.5f && moveVectorDegree < 292.5f) // 
+    else if (moveVectorDegree >= 247.5f && moveVectorDegree < 292.5f) // 西
     {
         startLocation.x = arrivePosition.x;
         startLocation.y = arrivePosition.y + (LINEUP_MAX_NPC_COUNT_PER_LINE / 2) * MAX_HEIGHT_SPACE_BETWEEN_NPC_IN_LINEUP;
@@ -629,7 +1420,7 @@ list<Vec2> GameObjectManager::computeBelongPlayerSelectedNpcArrivePositionList(c
         turnToNextLocationDelta.x = 0.0f;
         turnToNextLocationDelta.y = -MAX_HEIGHT_SPACE_BETWEEN_NPC_IN_LINEUP;
     }
-    else // 
+    else // 西北
     {
         startLocation.x = arrivePosition.x + (LINEUP_MAX_NPC_COUNT_PER_LINE / 2) * MAX_WIDTH_SPACE_BETWEEN_NPC_IN_LINEUP;
         startLocation.y = arrivePosition.y + (LINEUP_MAX_NPC_COUNT_PER_LINE / 2) * MAX_HEIGHT_SPACE_BETWEEN_NPC_IN_LINEUP;
@@ -4,14 +4,83 @@ class GameObject;
 class GameWorld;
 class Npc;
 
+const float PICKING_CELL_SIZE = 128.0f;     // 拾取用的桶比空间索引的桶大，一个npc的图片通常只落在1到4个桶中
+const int NPC_COLLISION_BENCHMARK_FRAME_COUNT = 100;
+
 struct NPC_READY_MOVE_TO_END_POSITION_DATA
 {
     list<int> _readyMoveToTargetNpcIDList;
     list<Vec2> _npcMoveTargetList;
+    Vec2 _flowFieldTargetPosition;
 };
 
 typedef unordered_map<int, GameObject*> GameObjectMap;
 
+enum class GameObjectLayer
+{
+    Any,
+
+    Ground,     // 建筑物、建筑物里的防守npc和陆军
+    Air,
+};
+
+// 空间查询的过滤条件，默认不限势力、类型和空军陆军，不返回准备删除的对象
+struct GameObjectQueryFilter
+{
+    ForceType forceType = ForceType::Invalid;
+    GameObjectType gameObjectType = GameObjectType::Invalid;
+    GameObjectLayer layer = GameObjectLayer::Any;
+    int exceptUniqueID = GAME_OBJECT_UNIQUE_ID_INVALID;
+    bool isIncludeReadyToRemove = false;
+    bool isEnemyApproachableOnly = false;  // 排除不能接近的对象和还没有放下的建筑物
+};
+
+// 包围盒覆盖的桶，包含从min到max的所有桶
+struct SpatialCellRange
+{
+    int minColumnIndex = 0;
+    int minRowIndex = 0;
+    int maxColumnIndex = -1;
+    int maxRowIndex = -1;
+};
+
+struct SpatialCellElement
+{
+    GameObject* gameObject = nullptr;
+    int uniqueID = GAME_OBJECT_UNIQUE_ID_INVALID;
+    Rect bounds;                    // npc的包围盒就是它的位置，建筑物的包围盒包含所有占地格子
+    SpatialCellRange cellRange;
+    bool isAir = false;
+    int occupyTileIndex = -1;       // npc所在的格子，建筑物为-1
+    Rect pickingBounds;             // 图片在地图坐标系中占的矩形，用于鼠标拾取
+    SpatialCellRange pickingCellRange;
+};
+
+struct NpcCollisionPair
+{
+    Npc* npc = nullptr;
+    Npc* otherNpc = nullptr;
+    float realDistance = 0.0f;
+    float constraintDistance = 0.0f;
+};
+
+struct NpcCollisionBenchmarkReport
+{
+    int frameCount = 0;
+    int npcCount = 0;
+    int radiusQueryPairCount = 0;
+    int broadphasePairCount = 0;
+    double radiusQueryMicroseconds = 0.0;   // 每帧的平均耗时
+    double broadphaseMicroseconds = 0.0;
+};
+
+struct NearestGameObject
+{
+    float distance = 0.0f;
+    int uniqueID = GAME_OBJECT_UNIQUE_ID_INVALID;
+    GameObject* gameObject = nullptr;
+};
+
 class GameObjectManager
 {
 public:
@@ -30,8 +99,31 @@ public:
     GameObject* getGameObjectBy(int uniqueID);
     const GameObjectMap& getGameObjectMap();
 
+    // 空间索引：地图按格子大小划分成桶，gameObject的位置或者占地格子变化时更新所在的桶
+    void initSpatialGrid(const Size& mapSize, const Size& tileSize);
+    void updateSpatialIndexOf(GameObject* gameObject);
+    // 返回包围盒与圆或者矩形相交的对象，距离等精确判断由调用者完成
+    void queryGameObjectsInRadius(const Vec2& center, float radius, const GameObjectQueryFilter& filter, vector<GameObject*>& gameObjectList);
+    void queryGameObjectsInRect(const Rect& rect, const GameObjectQueryFilter& filter, vector<GameObject*>& gameObjectList);
+    // 按距离从近到远返回maxRadius以内最多count个对象，到建筑物的距离按最近的占地格子计算，距离相同时uniqueID小的在前；
+    // 从center所在的桶开始一圈一圈向外查找，找够count个并且外圈不可能更近时停止
+    void queryNearestGameObjects(const Vec2& center, float maxRadius, int count, const GameObjectQueryFilter& filter, vector<GameObject*>& gameObjectList);
+    float getMaxCollisionRadius();
+    // 每个格子中npc的数量，随npc跨越格子时增量更新，放置建筑物和寻找出兵点时不再遍历所有对象
+    int getNpcCountInTile(int columnIndex, int rowIndex);
+    bool isTileCoveredByNpc(const Vec2& inMapPosition);
+    // 每帧调用一次：在空间索引中找出所有重叠的npc对，每一对只检测一次，全部找完以后各个npc再根据结果移动
+    void npcCollisionTest();
+    // 在当前战场上把碰撞检测重复frameCount帧，对比每个npc各自查询半径内对象（原来的做法）与一次遍历空间索引的耗时，只找碰撞对，不移动npc
+    NpcCollisionBenchmarkReport runNpcCollisionBenchmark(int frameCount);
+    // 每帧在npcCollisionTest之前调用一次：所有npc一起求解避让速度，移动中的npc按结果修正位置
+    void updateLocalAvoidance(float deltaTime);
+    int getAvoidanceAgentCount();
+    float getMaxExtraEnemyAttackRadius();
+
     void gameObjectsDepthSort(const Size& tileSize);
 
+    // 鼠标下有多个对象重叠时返回显示在最前面的一个；cursorPoint是屏幕坐标，每次查询只转换一次到地图坐标系
     GameObject* getGameObjectContain(const Vec2& cursorPoint);
     bool selectGameObjectsBy(const Rect& rect, const string templateName = "");
     GameObject* selectGameObjectBy(const Point& cursorPoint);
@@ -57,10 +149,36 @@ public:
     void teamMemberJumpIntoScreenBy(int teamID);
 
     bool hasSelectPlayerGameObject();
+
+    // 每帧调用一次，统计上一帧发生碰撞的次数，以及最近一次多个npc一起移动时全部到达所用的时间
+    void updateMoveStatistics(float deltaTime);
+    void addNpcCollisionCount(int collisionCount);
+    int getLastFrameNpcCollisionCount();
+    float getLastMoveOrderArriveTime();
 private:
-    Rect computeGameObjectRect(GameObject* gameObject);
+    Rect computePickingBounds(GameObject* gameObject);
+    SpatialCellRange computePickingCellRange(const Rect& bounds);
+    void updatePickingCells(SpatialCellElement& element);
+    void removeFromPickingCells(SpatialCellElement& element);
+    GameObject* pickGameObjectAt(const Vec2& cursorPoint, ForceType forceType, bool isExceptPrepareToBuild);
     list<Vec2> computeBelongPlayerSelectedNpcArrivePositionList(const Vec2& arrivePosition);
 
+    Rect computeSpatialBounds(GameObject* gameObject);
+    SpatialCellRange computeSpatialCellRange(const Rect& bounds);
+    void addToSpatialCells(const SpatialCellElement& element);
+    void removeFromSpatialCells(int uniqueID);
+    void updateOccupyTile(SpatialCellElement& element);
+    void releaseOccupyTile(SpatialCellElement& element);
+    bool isMatchQueryFilter(const SpatialCellElement& element, const GameObjectQueryFilter& filter);
+    bool isCollidable(const SpatialCellElement& element);
+    void collectNpcCollisionPairs(vector<NpcCollisionPair>& pairList);
+    void collectNpcCollisionPairsByRadiusQuery(vector<NpcCollisionPair>& pairList);
+    void testNpcCollisionBetween(const SpatialCellElement& element, const SpatialCellElement& otherElement, vector<NpcCollisionPair>& pairList);
+    float computeDistanceToSpatialElement(const Vec2& position, const SpatialCellElement& element);
+    void collectNearestInSpatialCell(int columnIndex, int rowIndex, const Vec2& center, float maxRadius, const GameObjectQueryFilter& filter);
+    void collectInSpatialCells(const Rect& queryBounds, const GameObjectQueryFilter& filter, const Vec2* center, float radius,
+        vector<GameObject*>& gameObjectList);
+
     GameObjectMap _gameObjectMap;
     unordered_map<ForceType, NPC_READY_MOVE_TO_END_POSITION_DATA> _npcReadyMoveToTargetDataMap;
 
@@ -75,4 +193,26 @@ private:
 
     list<int> _belongPlayerSelectedNpcIDList;
     unordered_map<int, list<int>> _playerTeamMemberIDsMap;
+
+    int _npcCollisionCountInFrame = 0;
+    int _lastFrameNpcCollisionCount = 0;
+    list<int> _moveOrderNpcIDList;
+    float _moveOrderElapsedTime = 0.0f;
+    float _lastMoveOrderArriveTime = 0.0f;
+
+    vector<vector<SpatialCellElement>> _spatialCellList;    // 下标与格子一致：columnIndex * _spatialRowCount + rowIndex
+    unordered_map<int, SpatialCellElement> _spatialElementMap;
+    Size _spatialCellSize;
+    int _spatialColumnCount = 0;
+    int _spatialRowCount = 0;
+    float _maxCollisionRadius = 0.0f;
+    float _maxExtraEnemyAttackRadius = 0.0f;
+    vector<NearestGameObject> _nearestGameObjectList;
+    vector<NpcCollisionPair> _npcCollisionPairList;
+    vector<int> _visitedMultiCellUniqueIDList;
+    vector<int> _npcCountInTileList;    // 桶和格子的行列数相同，下标同样是columnIndex * _spatialRowCount + rowIndex
+
+    vector<vector<SpatialCellElement>> _pickingCellList;    // 下标：columnIndex * _pickingRowCount + rowIndex
+    int _pickingColumnCount = 0;
+    int _pickingRowCount = 0;
 };
\ No newline at end of file
@@ -119,6 +119,31 @@ void GameScene::onKeyReleased(EventKeyboard::KeyCode keyCode, Event* event)
         }
     }
         break;
+    case EventKeyboard::KeyCode::KEY_F6:
+    {
+        g_setting.allowCooperativePath = !g_setting.allowCooperativePath;
+    }
+        break;
+    case EventKeyboard::KeyCode::KEY_F7:
+    {
+        g_setting.allowNavMeshPath = !g_setting.allowNavMeshPath;
+    }
+        break;
+    case EventKeyboard::KeyCode::KEY_F8:
+    {
+        g_setting.allowLocalAvoidance = !g_setting.allowLocalAvoidance;
+    }
+        break;
+    case EventKeyboard::KeyCode::KEY_F9:
+    {
+        _gameWorld->runAOEDamageBenchmark();
+    }
+        break;
+    case EventKeyboard::KeyCode::KEY_F11:
+    {
+        _gameWorld->runNpcCollisionBenchmark();
+    }
+        break;
     case EventKeyboard::KeyCode::KEY_0:
     case EventKeyboard::KeyCode::KEY_1:
     case EventKeyboard::KeyCode::KEY_2:
@@ -201,7 +226,7 @@ void GameScene::onMouseDown(Event* event)
 
 void GameScene::onMouseUp(Event* event)
 {
-    // ϶״̬ĻȻԴmouseUp¼
+    // 如果玩家鼠标是拖动状态的话，仍然可以触发mouseUp事件
     if (_gameUI->isCursorInGameMainUI() &&
         _gameWorld->isMouseClick())
     {
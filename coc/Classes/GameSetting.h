@@ -3,6 +3,9 @@
 struct GameSetting
 {
     bool allowDebugDraw = false;
+    bool allowCooperativePath = false;     // 多个npc一起移动时在时空预约表中互相避让
+    bool allowNavMeshPath = false;         // 在合并后的导航网格上寻路，路径用漏斗算法拉直
+    bool allowLocalAvoidance = false;      // 移动中的npc按ORCA互相避让，代替碰撞后的推挤
     string fontName = "arial.ttf";
     Color4F playerForceColor = Color4F(248.0f / 255.0f, 200.0f / 255.0f, 40.0f / 255.0f, 1.0f);
     Color4F aiForceColor = Color4F(164.0f / 255.0f, 72.0f / 255.0f, 192.0f / 255.0f, 1.0f);
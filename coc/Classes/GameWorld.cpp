@@ -7,7 +7,16 @@
 #include "GameWorld.h"
 #include "BulletManager.h"
 #include "GameWorldCallBackFunctionsManager.h"
-#include "AutoFindPathHelper.h"
+#include "FlowFieldHelper.h"
+#include "PathCacheHelper.h"
+#include "HierarchicalPathHelper.h"
+#include "PathRequestService.h"
+#include "IncrementalPathPlanner.h"
+#include "PathSmoothHelper.h"
+#include "CooperativePathHelper.h"
+#include "LandmarkHelper.h"
+#include "NavMeshHelper.h"
+#include "BuildingRouteHelper.h"
 #include "Utils.h"
 #include "Building.h"
 #include "SpecialEffectManager.h"
@@ -54,6 +63,7 @@ bool GameWorld::init()
 
     _gameObjectManager = GameObjectManager::getInstance();
     _gameObjectManager->init(this);
+    _gameObjectManager->initSpatialGrid(_mapManager->getMapSize(), _mapManager->getTileSize());
 
     _gameObjectSelectBox = GameObjectSelectBox::create();
     _gameObjectSelectBox->setGlobalZOrder(MAX_GAME_OBJECT_COUNT);
@@ -82,7 +92,7 @@ bool GameWorld::init()
     director->getEventDispatcher()->addCustomEventListener("ClearDebugDraw", CC_CALLBACK_0(GameWorld::onClearDebugDraw, this));
 
     initEditedGameObjects();
-    initMapGIDTable();
+    initNpcCreatePointBatchList();
 
     _soundManager->playRandomBackgroundMusicOneByOne();
     scheduleUpdate();
@@ -193,19 +203,16 @@ void GameWorld::initEditedGameObjects()
         }
     }
 
-    // ҪȴAIBuildingλõٽţTileEditor༭壬Ϸлλ
+    // 要等待AI势力的Building，完成位置调整后，再进行缩放，否则在TileEditor编辑的物体，在游戏中会错位
     delayAjustScreen();
     _holdingBuildingID = GAME_OBJECT_UNIQUE_ID_INVALID;
 }
 
-void GameWorld::initMapGIDTable()
+void GameWorld::initNpcCreatePointBatchList()
 {
     auto mapSize = _mapManager->getMapSize();
-    _mapGIDTable.resize(mapSize.width);
-    for (int i = 0; i < (int)_mapGIDTable.size(); i ++)
-    {
-        _mapGIDTable[i].resize(mapSize.height);
-    }
+    _npcCreatePointBatchList.assign((int)mapSize.width * (int)mapSize.height, 0);
+    _npcCreatePointBatch = 0;
 }
 
 void GameWorld::update(float deltaTime)
@@ -227,6 +234,19 @@ void GameWorld::update(float deltaTime)
         _mapManager->updateMapPosition();
     }
 
+    _pathRepairCountInFrame = 0;
+    LandmarkHelper::update();
+    BuildingRouteHelper::update();
+    PathRequestService::update();
+    CooperativePathHelper::update(deltaTime);
+    _gameObjectManager->updateMoveStatistics(deltaTime);
+    if (g_setting.allowLocalAvoidance)
+    {
+        _gameObjectManager->updateLocalAvoidance(deltaTime);
+    }
+    _gameObjectManager->npcCollisionTest();
+    _bulletManager->update();
+
     _gameObjectManager->gameObjectsDepthSort(_mapManager->getTileSize());
     _gameObjectManager->npcMoveToTargetOneByOne();
     _gameObjectManager->removeAllReadyToRemoveGameObjects();
@@ -392,7 +412,80 @@ void GameWorld::syncCursorPoint(const Vec2& cursorPoint)
     _gameObjectSelectBox->syncCursorPoint(cursorPoint);
 }
 
-list<Vec2> GameWorld::computePathList(const Vec2& inMapStartPosition, const Vec2& inMapEndPosition, bool isAllowEndTileNodeToMoveIn /*= false*/)
+list<Vec2> GameWorld::computePathListByFlowField(int npcUniqueID, const Vec2& inMapFlowFieldEndPosition, const Vec2& inMapEndPosition, bool isAllowEndTileNodeToMoveIn)
+{
+    list<Vec2> pointPathList;
+
+    auto npc = _gameObjectManager->getGameObjectBy(npcUniqueID);
+    if (npc)
+    {
+        auto flowFieldEndTileSubscript = _mapManager->getTileSubscript(inMapFlowFieldEndPosition);
+        auto flowFieldEndTileNode = _mapManager->getTileNodeAt((int)flowFieldEndTileSubscript.x, (int)flowFieldEndTileSubscript.y);
+
+        pointPathList = computePathListBy(npc->getPosition(), inMapEndPosition, isAllowEndTileNodeToMoveIn, flowFieldEndTileNode, npcUniqueID);
+    }
+
+    return pointPathList;
+}
+
+list<Vec2> GameWorld::computePathListByFlowFieldToNearest(int npcUniqueID, const vector<Vec2>& inMapEndPositionList, bool isAllowEndTileNodeToMoveIn)
+{
+    list<Vec2> pointPathList;
+
+    auto npc = _gameObjectManager->getGameObjectBy(npcUniqueID);
+    if (!npc)
+    {
+        return pointPathList;
+    }
+
+    auto inMapStartPosition = npc->getPosition();
+    auto startTileSubscript = _mapManager->getTileSubscript(inMapStartPosition);
+    auto startTileNode = _mapManager->getTileNodeAt((int)startTileSubscript.x, (int)startTileSubscript.y);
+
+    auto endTileNodeList = computeReachableEndTileNodeList(startTileNode, inMapEndPositionList, isAllowEndTileNodeToMoveIn);
+    if (!endTileNodeList.empty())
+    {
+        auto tileNodePathList = FlowFieldHelper::computeTileNodePathListToNearest(startTileNode, endTileNodeList,
+            isAllowEndTileNodeToMoveIn, _mapManager->getNavigationVersion());
+        if (!tileNodePathList.empty())
+        {
+            auto inMapEndPosition = getInMapEndPositionAt(tileNodePathList.front(), inMapEndPositionList);
+            int unsmoothedTileNodeCount = computeCooperativeTileNodePathList(npcUniqueID, isAllowEndTileNodeToMoveIn, tileNodePathList);
+            pointPathList = convertToPointPathList(tileNodePathList, inMapStartPosition, inMapEndPosition, isAllowEndTileNodeToMoveIn, unsmoothedTileNodeCount);
+        }
+    }
+
+    return pointPathList;
+}
+
+list<Vec2> GameWorld::computePathListByBuildingRoute(int npcUniqueID, int buildingUniqueID)
+{
+    list<Vec2> pointPathList;
+
+    auto npc = _gameObjectManager->getGameObjectBy(npcUniqueID);
+    auto building = dynamic_cast<Building*>(_gameObjectManager->getGameObjectBy(buildingUniqueID));
+    if (!npc || !building)
+    {
+        return pointPathList;
+    }
+
+    auto inMapStartPosition = npc->getPosition();
+    auto startTileSubscript = _mapManager->getTileSubscript(inMapStartPosition);
+    auto startTileNode = _mapManager->getTileNodeAt((int)startTileSubscript.x, (int)startTileSubscript.y);
+
+    auto tileNodePathList = BuildingRouteHelper::computeTileNodePathListToBuilding(startTileNode, buildingUniqueID);
+    if (!tileNodePathList.empty())
+    {
+        auto inMapEndPosition = getInMapEndPositionAt(tileNodePathList.front(), building->getBottomGridInMapPositionList());
+        int unsmoothedTileNodeCount = computeCooperativeTileNodePathList(npcUniqueID, true, tileNodePathList);
+        pointPathList = convertToPointPathList(tileNodePathList, inMapStartPosition, inMapEndPosition, true, unsmoothedTileNodeCount);
+    }
+
+    return pointPathList;
+}
+
+list<Vec2> GameWorld::computePathListBy(const Vec2& inMapStartPosition, const Vec2& inMapEndPosition, bool isAllowEndTileNodeToMoveIn, TileNode* flowFieldEndTileNode,
+    int cooperativeNpcUniqueID /* = GAME_OBJECT_UNIQUE_ID_INVALID */)
 {
     list<Vec2> pointPathList;
 
@@ -401,47 +494,387 @@ list<Vec2> GameWorld::computePathList(const Vec2& inMapStartPosition, const Vec2
 
     auto endTileSubscript = _mapManager->getTileSubscript(inMapEndPosition);
     auto endTileNode = _mapManager->getTileNodeAt((int)endTileSubscript.x, (int)endTileSubscript.y);
-    auto distanceBetweenTileAndNpc = inMapEndPosition - endTileNode->leftTopPosition;
 
-    // ʱnpcƶһϰ
-    int originalGID = endTileNode->gid;
-    if (isAllowEndTileNodeToMoveIn)
+    // 允许npc移动到最后一个障碍格内时，作为寻路的参数传下去，不修改格子本身；
+    // 起点和终点不连通时不需要寻路
+    if (_mapManager->isTileNodeReachable(startTileNode, endTileNode, isAllowEndTileNodeToMoveIn))
     {
-        endTileNode->gid = PASSABLE_ID;
+        list<TileNode*> tileNodePathList;
+        if (startTileNode == endTileNode)
+        {
+            tileNodePathList.push_back(startTileNode);
+        }
+        else
+        {
+            tileNodePathList = FlowFieldHelper::computeTileNodePathListBetween(startTileNode, flowFieldEndTileNode, endTileNode,
+                isAllowEndTileNodeToMoveIn, _mapManager->getNavigationVersion());
+        }
+
+        int unsmoothedTileNodeCount = 0;
+        if (cooperativeNpcUniqueID != GAME_OBJECT_UNIQUE_ID_INVALID)
+        {
+            unsmoothedTileNodeCount = computeCooperativeTileNodePathList(cooperativeNpcUniqueID, isAllowEndTileNodeToMoveIn, tileNodePathList);
+        }
+
+        pointPathList = convertToPointPathList(tileNodePathList, inMapStartPosition, inMapEndPosition, isAllowEndTileNodeToMoveIn, unsmoothedTileNodeCount);
+    }
+
+    return pointPathList;
+}
+
+int GameWorld::computeCooperativeTileNodePathList(int npcUniqueID, bool isAllowEndTileNodeToMoveIn, list<TileNode*>& tileNodePathList)
+{
+    int unsmoothedTileNodeCount = 0;
+
+    auto npc = static_cast<Npc*>(_gameObjectManager->getGameObjectBy(npcUniqueID));
+    if (g_setting.allowCooperativePath && npc)
+    {
+        unsmoothedTileNodeCount = CooperativePathHelper::computeCooperativeTileNodePathList(npcUniqueID, npc->getPerSecondMoveSpeedByPixel(),
+            isAllowEndTileNodeToMoveIn, tileNodePathList);
     }
 
-    if (endTileNode->gid != OBSTACLE_ID)
+    return unsmoothedTileNodeCount;
+}
+
+list<Vec2> GameWorld::convertToPointPathList(const list<TileNode*>& tileNodePathList, const Vec2& inMapStartPosition, const Vec2& inMapEndPosition, bool isAllowEndTileNodeToMoveIn,
+    int unsmoothedTileNodeCount /* = 0 */)
+{
+    list<Vec2> pointPathList;
+
+    if (tileNodePathList.size() == 1)
     {
-        if (startTileNode != endTileNode)
+        // 起点和终点在同一个格子内
+        if (!GameUtils::isVec2Equal(inMapStartPosition, inMapEndPosition))
+        {
+            pointPathList.push_front(inMapEndPosition);
+        }
+    }
+    else if (!tileNodePathList.empty())
+    {
+        // 格子路径从终点排到起点，终点格子就是第一个；拉直以后只剩下拐点，npc不需要每个格子都重新创建移动动作
+        auto distanceBetweenTileAndNpc = inMapEndPosition - tileNodePathList.front()->leftTopPosition;
+        list<TileNode*> smoothTileNodePathList;
+        if (unsmoothedTileNodeCount > 0)
+        {
+            // 协作寻路窗口内的格子为了错开别的npc才绕开，拉直以后npc又会挤到一起，只拉直窗口之后的部分
+            auto windowBeginIter = tileNodePathList.end();
+            std::advance(windowBeginIter, -std::min(unsmoothedTileNodeCount, (int)tileNodePathList.size()));
+            smoothTileNodePathList = PathSmoothHelper::smoothTileNodePathList(list<TileNode*>(tileNodePathList.begin(), std::next(windowBeginIter)), isAllowEndTileNodeToMoveIn);
+            smoothTileNodePathList.insert(smoothTileNodePathList.end(), std::next(windowBeginIter), tileNodePathList.end());
+        }
+        else
         {
-            auto tileNodePathList = AutoFindPathHelper::computeTileNodePathListBetween(startTileNode, endTileNode);
+            smoothTileNodePathList = PathSmoothHelper::smoothTileNodePathList(tileNodePathList, isAllowEndTileNodeToMoveIn);
+        }
 
-            for (auto tileNodePath : tileNodePathList)
-            {
-                pointPathList.push_front(tileNodePath->leftTopPosition + distanceBetweenTileAndNpc);
-            }
+        for (auto tileNodePath : smoothTileNodePathList)
+        {
+            pointPathList.push_front(tileNodePath->leftTopPosition + distanceBetweenTileAndNpc);
+        }
 
-            if (!pointPathList.empty())
-            {
-                //һ㣬˿Ժ
-                pointPathList.pop_front();
-            }
+        //第一个点是起点，因此可以忽略
+        pointPathList.pop_front();
+    }
+
+    return pointPathList;
+}
+
+int GameWorld::requestPathList(const Vec2& inMapStartPosition, const Vec2& inMapEndPosition, bool isAllowEndTileNodeToMoveIn)
+{
+    return requestPathListToNearest(inMapStartPosition, vector<Vec2>(1, inMapEndPosition), isAllowEndTileNodeToMoveIn);
+}
+
+int GameWorld::requestPathListToNearest(const Vec2& inMapStartPosition, const vector<Vec2>& inMapEndPositionList, bool isAllowEndTileNodeToMoveIn)
+{
+    auto startTileSubscript = _mapManager->getTileSubscript(inMapStartPosition);
+    auto startTileNode = _mapManager->getTileNodeAt((int)startTileSubscript.x, (int)startTileSubscript.y);
+
+    int requestID = 0;
+    bool shouldAddToPathCache = false;
+    list<Vec2> navMeshPointPathList;
+    bool hasNavMeshPointPathList = false;
+    auto endTileNodeList = computeReachableEndTileNodeList(startTileNode, inMapEndPositionList, isAllowEndTileNodeToMoveIn);
+    if (g_setting.allowNavMeshPath && !endTileNodeList.empty() &&
+        computeNavMeshPointPathList(inMapStartPosition, inMapEndPositionList, endTileNodeList, isAllowEndTileNodeToMoveIn, navMeshPointPathList))
+    {
+        // 导航网格只扩展几十个多边形，直接在主线程中算完，结果仍然通过请求取回；
+        // 结果是坐标点而不是格子，不交给PathRequestService检查，取回时在tryGetRequestedPathList中检查
+        requestID = PathRequestService::addFinishedRequest(nullptr, vector<TileNode*>(), isAllowEndTileNodeToMoveIn, list<TileNode*>());
+        hasNavMeshPointPathList = true;
+    }
+    else if (endTileNodeList.size() == 1)
+    {
+        // 只有一个终点时先查路径缓存，命中就不必交给工作线程；终点本来就可以通行时，是否允许进入终点不影响结果，可以共用同一条缓存
+        list<TileNode*> tileNodePathList;
+        auto endTileNode = endTileNodeList.front();
+        if (PathCacheHelper::findPathList(startTileNode, endTileNode, endTileNode->gid == OBSTACLE_ID, tileNodePathList))
+        {
+            requestID = PathRequestService::addFinishedRequest(startTileNode, endTileNodeList, isAllowEndTileNodeToMoveIn, tileNodePathList);
         }
         else
         {
-            if (!GameUtils::isVec2Equal(inMapStartPosition, inMapEndPosition))
+            // 距离远时先在区块抽象图上找出途经的过渡点，工作线程只需要在相邻的过渡点之间细化
+            vector<TileNode*> waypointList;
+            HierarchicalPathHelper::computeWaypointList(startTileNode, endTileNode, waypointList);
+            requestID = PathRequestService::requestTileNodePathListThrough(startTileNode, waypointList, endTileNodeList, isAllowEndTileNodeToMoveIn);
+            shouldAddToPathCache = true;
+        }
+    }
+    else if (!endTileNodeList.empty())
+    {
+        requestID = PathRequestService::requestTileNodePathListToNearest(startTileNode, endTileNodeList, isAllowEndTileNodeToMoveIn);
+    }
+    else
+    {
+        requestID = PathRequestService::addFinishedRequest(startTileNode, endTileNodeList, isAllowEndTileNodeToMoveIn, list<TileNode*>());
+    }
+
+    auto& pathRequestPosition = _pathRequestPositionMap[requestID];
+    pathRequestPosition.inMapStartPosition = inMapStartPosition;
+    pathRequestPosition.inMapEndPositionList = inMapEndPositionList;
+    pathRequestPosition.isAllowEndTileNodeToMoveIn = isAllowEndTileNodeToMoveIn;
+    if (shouldAddToPathCache)
+    {
+        pathRequestPosition.startTileNode = startTileNode;
+        pathRequestPosition.endTileNode = endTileNodeList.front();
+    }
+    if (hasNavMeshPointPathList)
+    {
+        pathRequestPosition.hasPointPathList = true;
+        pathRequestPosition.pointPathList.swap(navMeshPointPathList);
+        pathRequestPosition.navigationVersion = _mapManager->getNavigationVersion();
+    }
+
+    return requestID;
+}
+
+bool GameWorld::computeNavMeshPointPathList(const Vec2& inMapStartPosition, const vector<Vec2>& inMapEndPositionList, const vector<TileNode*>& endTileNodeList,
+    bool isAllowEndTileNodeToMoveIn, list<Vec2>& pointPathList)
+{
+    bool result = false;
+
+    // 与Npc::computeArrivePositionBy选择建筑物占地格子的方式一致
+    Vec2 nearestEndPosition;
+    float minDistanceSquared = FLT_MAX;
+    for (auto& inMapEndPosition : inMapEndPositionList)
+    {
+        auto endTileSubscript = _mapManager->getTileSubscript(inMapEndPosition);
+        auto endTileNode = _mapManager->getTileNodeAt((int)endTileSubscript.x, (int)endTileSubscript.y);
+        float distanceSquared = inMapStartPosition.distanceSquared(inMapEndPosition);
+        if (distanceSquared < minDistanceSquared && std::find(endTileNodeList.begin(), endTileNodeList.end(), endTileNode) != endTileNodeList.end())
+        {
+            minDistanceSquared = distanceSquared;
+            nearestEndPosition = inMapEndPosition;
+        }
+    }
+
+    if (minDistanceSquared != FLT_MAX)
+    {
+        result = NavMeshHelper::computePointPathList(inMapStartPosition, nearestEndPosition, isAllowEndTileNodeToMoveIn, pointPathList);
+    }
+
+    return result;
+}
+
+void GameWorld::recomputeNavMeshPointPathList(PathRequestPosition& pathRequestPosition)
+{
+    auto startTileSubscript = _mapManager->getTileSubscript(pathRequestPosition.inMapStartPosition);
+    auto startTileNode = _mapManager->getTileNodeAt((int)startTileSubscript.x, (int)startTileSubscript.y);
+
+    list<Vec2> pointPathList;
+    auto endTileNodeList = computeReachableEndTileNodeList(startTileNode, pathRequestPosition.inMapEndPositionList, pathRequestPosition.isAllowEndTileNodeToMoveIn);
+    if (!endTileNodeList.empty() &&
+        !computeNavMeshPointPathList(pathRequestPosition.inMapStartPosition, pathRequestPosition.inMapEndPositionList, endTileNodeList,
+        pathRequestPosition.isAllowEndTileNodeToMoveIn, pointPathList))
+    {
+        // 很少发生，直接在主线程中用格子寻路，不再提交新的请求
+        auto tileNodePathList = FlowFieldHelper::computeTileNodePathListToNearest(startTileNode, endTileNodeList,
+            pathRequestPosition.isAllowEndTileNodeToMoveIn, _mapManager->getNavigationVersion());
+        if (!tileNodePathList.empty())
+        {
+            auto inMapEndPosition = getInMapEndPositionAt(tileNodePathList.front(), pathRequestPosition.inMapEndPositionList);
+            pointPathList = convertToPointPathList(tileNodePathList, pathRequestPosition.inMapStartPosition, inMapEndPosition,
+                pathRequestPosition.isAllowEndTileNodeToMoveIn);
+        }
+    }
+
+    pathRequestPosition.pointPathList.swap(pointPathList);
+    pathRequestPosition.navigationVersion = _mapManager->getNavigationVersion();
+}
+
+vector<TileNode*> GameWorld::computeReachableEndTileNodeList(TileNode* startTileNode, const vector<Vec2>& inMapEndPositionList, bool isAllowEndTileNodeToMoveIn)
+{
+    vector<TileNode*> endTileNodeList;
+
+    // 与起点不连通的终点不参与搜索，全部不连通时不需要寻路
+    for (auto& inMapEndPosition : inMapEndPositionList)
+    {
+        auto endTileSubscript = _mapManager->getTileSubscript(inMapEndPosition);
+        auto endTileNode = _mapManager->getTileNodeAt((int)endTileSubscript.x, (int)endTileSubscript.y);
+        if (_mapManager->isTileNodeReachable(startTileNode, endTileNode, isAllowEndTileNodeToMoveIn))
+        {
+            endTileNodeList.push_back(endTileNode);
+        }
+    }
+
+    return endTileNodeList;
+}
+
+Vec2 GameWorld::getInMapEndPositionAt(TileNode* endTileNode, const vector<Vec2>& inMapEndPositionList)
+{
+    Vec2 inMapEndPosition;
+    if (!inMapEndPositionList.empty())
+    {
+        inMapEndPosition = inMapEndPositionList.front();
+    }
+
+    for (auto& position : inMapEndPositionList)
+    {
+        auto tileSubscript = _mapManager->getTileSubscript(position);
+        if (_mapManager->getTileNodeAt((int)tileSubscript.x, (int)tileSubscript.y) == endTileNode)
+        {
+            inMapEndPosition = position;
+            break;
+        }
+    }
+
+    return inMapEndPosition;
+}
+
+bool GameWorld::tryGetRequestedPathList(int requestID, list<Vec2>& pointPathList)
+{
+    bool result = false;
+
+    list<TileNode*> tileNodePathList;
+    if (PathRequestService::tryGetTileNodePathList(requestID, tileNodePathList))
+    {
+        pointPathList.clear();
+
+        auto pathRequestPositionIter = _pathRequestPositionMap.find(requestID);
+        if (pathRequestPositionIter != _pathRequestPositionMap.end())
+        {
+            auto& pathRequestPosition = pathRequestPositionIter->second;
+            if (pathRequestPosition.hasPointPathList)
             {
-                pointPathList.push_front(inMapEndPosition);
+                if (pathRequestPosition.navigationVersion != _mapManager->getNavigationVersion() &&
+                    isPathListBlocked(pathRequestPosition.inMapStartPosition, pathRequestPosition.pointPathList, pathRequestPosition.isAllowEndTileNodeToMoveIn))
+                {
+                    // 新放置的建筑物挡住了路径，按照最新的地图重新计算
+                    recomputeNavMeshPointPathList(pathRequestPosition);
+                }
+                pointPathList.swap(pathRequestPosition.pointPathList);
             }
+            else
+            {
+                if (pathRequestPosition.startTileNode)
+                {
+                    // 取回的结果已经按照最新的通行数据检查过，之后格子变化时由缓存自己淘汰
+                    PathCacheHelper::addPathList(pathRequestPosition.startTileNode, pathRequestPosition.endTileNode,
+                        pathRequestPosition.endTileNode->gid == OBSTACLE_ID, tileNodePathList);
+                }
+
+                auto endTileNode = tileNodePathList.empty() ? nullptr : tileNodePathList.front();
+                auto inMapEndPosition = getInMapEndPositionAt(endTileNode, pathRequestPosition.inMapEndPositionList);
+                pointPathList = convertToPointPathList(tileNodePathList, pathRequestPosition.inMapStartPosition, inMapEndPosition,
+                    pathRequestPosition.isAllowEndTileNodeToMoveIn);
+            }
+            _pathRequestPositionMap.erase(pathRequestPositionIter);
         }
+
+        result = true;
     }
 
-    if (isAllowEndTileNodeToMoveIn)
+    return result;
+}
+
+void GameWorld::cancelPathRequest(int requestID)
+{
+    PathRequestService::cancelRequest(requestID);
+    _pathRequestPositionMap.erase(requestID);
+}
+
+bool GameWorld::isPathListBlocked(const Vec2& inMapCurrentPosition, const list<Vec2>& pointPathList, bool isAllowEndTileNodeToMoveIn)
+{
+    bool result = false;
+
+    // 路径拉直以后相邻两个点之间可能隔着很多格子，需要沿着直线检查
+    auto fromTileSubscript = _mapManager->getTileSubscript(inMapCurrentPosition);
+    auto fromTileNode = _mapManager->getTileNodeAt((int)fromTileSubscript.x, (int)fromTileSubscript.y);
+    auto endPointIter = pointPathList.empty() ? pointPathList.end() : --pointPathList.end();
+    for (auto pointIter = pointPathList.begin(); !result && pointIter != pointPathList.end(); ++pointIter)
     {
-        endTileNode->gid = originalGID;
+        auto toTileSubscript = _mapManager->getTileSubscript(*pointIter);
+        auto toTileNode = _mapManager->getTileNodeAt((int)toTileSubscript.x, (int)toTileSubscript.y);
+
+        bool isEndTileNodePassable = isAllowEndTileNodeToMoveIn && pointIter == endPointIter;
+        result = !PathSmoothHelper::hasLineOfSight(fromTileNode, toTileNode, isEndTileNodePassable);
+
+        fromTileNode = toTileNode;
     }
 
-    return pointPathList;
+    return result;
+}
+
+bool GameWorld::repairPathList(int npcUniqueID, const Vec2& inMapCurrentPosition, bool isAllowEndTileNodeToMoveIn, list<Vec2>& pointPathList)
+{
+    bool result = false;
+
+    if (!pointPathList.empty() && _pathRepairCountInFrame < MAX_PATH_REPAIR_COUNT_PER_FRAME)
+    {
+        _pathRepairCountInFrame++;
+
+        auto inMapEndPosition = pointPathList.back();
+        auto endTileSubscript = _mapManager->getTileSubscript(inMapEndPosition);
+        auto endTileNode = _mapManager->getTileNodeAt((int)endTileSubscript.x, (int)endTileSubscript.y);
+
+        auto startTileSubscript = _mapManager->getTileSubscript(inMapCurrentPosition);
+        auto startTileNode = _mapManager->getTileNodeAt((int)startTileSubscript.x, (int)startTileSubscript.y);
+
+        // 终点变了就换一个寻路器，否则沿用上次的搜索结果
+        auto& pathPlanner = _pathPlannerMap[npcUniqueID];
+        if (pathPlanner &&
+            (pathPlanner->getEndTileNode() != endTileNode || pathPlanner->isEndTileNodePassable() != isAllowEndTileNodeToMoveIn))
+        {
+            CC_SAFE_DELETE(pathPlanner);
+        }
+
+        if (!pathPlanner)
+        {
+            pathPlanner = new IncrementalPathPlanner(endTileNode, isAllowEndTileNodeToMoveIn);
+        }
+
+        list<TileNode*> tileNodePathList;
+        if (startTileNode == endTileNode)
+        {
+            tileNodePathList.push_back(startTileNode);
+        }
+        else if (_mapManager->isTileNodeReachable(startTileNode, endTileNode, isAllowEndTileNodeToMoveIn))
+        {
+            tileNodePathList = pathPlanner->computeTileNodePathListFrom(startTileNode);
+            _debugInfo.lastPathRepairExpandedNodeCount = pathPlanner->getLastExpandedNodeCount();
+        }
+
+        pointPathList = convertToPointPathList(tileNodePathList, inMapCurrentPosition, inMapEndPosition, isAllowEndTileNodeToMoveIn);
+
+        result = true;
+    }
+
+    return result;
+}
+
+void GameWorld::removePathPlanner(int npcUniqueID)
+{
+    auto pathPlannerIter = _pathPlannerMap.find(npcUniqueID);
+    if (pathPlannerIter != _pathPlannerMap.end())
+    {
+        delete pathPlannerIter->second;
+        _pathPlannerMap.erase(pathPlannerIter);
+    }
+}
+
+void GameWorld::releasePathReservations(int npcUniqueID)
+{
+    CooperativePathHelper::releaseReservations(npcUniqueID);
 }
 
 MapManager* GameWorld::getMapManager()
@@ -487,39 +920,18 @@ vector<Vec2> GameWorld::computeNpcCreatePointList(int buildingUniqueID, int read
 
     auto mapSize = _mapManager->getMapSize();
 
-    // ˢµͼϰֲ
     if (shouldRefreshMap)
     {
-        for (int columnIndex = 0; columnIndex < (int)mapSize.width; columnIndex++)
-        {
-            for (int rowIndex = 0; rowIndex < (int)mapSize.height; rowIndex++)
-            {
-                auto tileNode = _mapManager->getTileNodeAt(columnIndex, rowIndex);
-                _mapGIDTable[columnIndex][rowIndex] = tileNode->gid;
-            }
-        }
-    }
-
-    // 㳡ѴڵnpcռõĸӣΪ˱´npcѱnpcռõĸϣغ
-    auto& gameObjectMap = _gameObjectManager->getGameObjectMap();
-    for (auto& gameObjectIter : gameObjectMap)
-    {
-        auto gameObject = gameObjectIter.second;
-        if (gameObject->getGameObjectType() == GameObjectType::Npc)
-        {
-            auto gameObjectPosition = gameObject->getPosition();
-            auto gameObjectOccupyTileNodeSubscript = _mapManager->getTileSubscript(gameObjectPosition);
-            _mapGIDTable[(int)gameObjectOccupyTileNodeSubscript.x][(int)gameObjectOccupyTileNodeSubscript.y] = OBSTACLE_ID;
-        }
+        _npcCreatePointBatch++;
     }
 
-    // ҪѰΧƻصbottomGridЩΪnpcĽڵ㣬ʱҪ*ʶĽڵ
+    // 这里需要寻找围绕基地的bottomGrid的那些可以作为npc创建点的节点，此时需要遍历*标识的节点
     // * * * * *
     // * # # # *
     // * # # # *
     // * # # # *
     // * * * * *
-    // ҪҵϽ*±꣬ʹ½*±꣬ȻԴΪݽб
+    // 因此需要找到处于左上角*的下标，和处于右下角*的下标，然后以此为依据进行遍历
     auto building = _gameObjectManager->getGameObjectBy(buildingUniqueID);
     if (building)
     {
@@ -541,23 +953,8 @@ vector<Vec2> GameWorld::computeNpcCreatePointList(int buildingUniqueID, int read
         {
             for (int columnIndex = leftTopStartSearchColumnIndex; columnIndex <= rightBottomStartSearchColumnIndex; columnIndex ++)
             {
-                if (_mapGIDTable[columnIndex][leftTopStartSearchRowIndex] != OBSTACLE_ID &&
-                    (int)npcCreatePointList.size() < readyToCreateNpcCount)
-                {
-                    auto tileNodeInTopLine = _mapManager->getTileNodeAt(columnIndex, leftTopStartSearchRowIndex);
-                    npcCreatePointList.push_back(tileNodeInTopLine->leftTopPosition);
-
-                    _mapGIDTable[columnIndex][leftTopStartSearchRowIndex] = OBSTACLE_ID;
-                }
-
-                if (_mapGIDTable[columnIndex][rightBottomStartSearchRowIndex] != OBSTACLE_ID &&
-                    (int)npcCreatePointList.size() < readyToCreateNpcCount)
-                {
-                    auto tileNodeInBottomLine = _mapManager->getTileNodeAt(columnIndex, rightBottomStartSearchRowIndex);
-                    npcCreatePointList.push_back(tileNodeInBottomLine->leftTopPosition);
-
-                    _mapGIDTable[columnIndex][rightBottomStartSearchRowIndex] = OBSTACLE_ID;
-                }
+                tryAddNpcCreatePoint(columnIndex, leftTopStartSearchRowIndex, readyToCreateNpcCount, npcCreatePointList);
+                tryAddNpcCreatePoint(columnIndex, rightBottomStartSearchRowIndex, readyToCreateNpcCount, npcCreatePointList);
 
                 if ((int)npcCreatePointList.size() >= readyToCreateNpcCount)
                 {
@@ -567,23 +964,8 @@ vector<Vec2> GameWorld::computeNpcCreatePointList(int buildingUniqueID, int read
 
             for (int rowIndex = leftTopStartSearchRowIndex; rowIndex <= rightBottomStartSearchRowIndex; rowIndex ++)
             {
-                if (_mapGIDTable[leftTopStartSearchColumnIndex][rowIndex] != OBSTACLE_ID &&
-                    (int)npcCreatePointList.size() < readyToCreateNpcCount)
-                {
-                    auto tileNodeInLeftLine = _mapManager->getTileNodeAt(leftTopStartSearchColumnIndex, rowIndex);
-                    npcCreatePointList.push_back(tileNodeInLeftLine->leftTopPosition);
-
-                    _mapGIDTable[leftTopStartSearchColumnIndex][rowIndex] = OBSTACLE_ID;
-                }
-
-                if (_mapGIDTable[rightBottomStartSearchColumnIndex][rowIndex] != OBSTACLE_ID &&
-                    (int)npcCreatePointList.size() < readyToCreateNpcCount)
-                {
-                    auto tileNodeInRightLine = _mapManager->getTileNodeAt(rightBottomStartSearchColumnIndex, rowIndex);
-                    npcCreatePointList.push_back(tileNodeInRightLine->leftTopPosition);
-
-                    _mapGIDTable[rightBottomStartSearchColumnIndex][rowIndex] = OBSTACLE_ID;
-                }
+                tryAddNpcCreatePoint(leftTopStartSearchColumnIndex, rowIndex, readyToCreateNpcCount, npcCreatePointList);
+                tryAddNpcCreatePoint(rightBottomStartSearchColumnIndex, rowIndex, readyToCreateNpcCount, npcCreatePointList);
 
                 if ((int)npcCreatePointList.size() >= readyToCreateNpcCount)
                 {
@@ -591,6 +973,13 @@ vector<Vec2> GameWorld::computeNpcCreatePointList(int buildingUniqueID, int read
                 }
             }
 
+            // 已经扩展到整张地图时不再继续，剩下的npc不创建
+            if (leftTopStartSearchColumnIndex == 0 && leftTopStartSearchRowIndex == 0 &&
+                rightBottomStartSearchColumnIndex == (int)(mapSize.width - 1) && rightBottomStartSearchRowIndex == (int)(mapSize.height - 1))
+            {
+                break;
+            }
+
             leftTopStartSearchColumnIndex = std::max(leftTopStartSearchColumnIndex - 1, 0);
             leftTopStartSearchRowIndex = std::max(leftTopStartSearchRowIndex - 1, 0);
 
@@ -602,6 +991,27 @@ vector<Vec2> GameWorld::computeNpcCreatePointList(int buildingUniqueID, int read
     return npcCreatePointList;
 }
 
+void GameWorld::tryAddNpcCreatePoint(int columnIndex, int rowIndex, int readyToCreateNpcCount, vector<Vec2>& npcCreatePointList)
+{
+    if ((int)npcCreatePointList.size() >= readyToCreateNpcCount)
+    {
+        return;
+    }
+
+    // 避免新创建的npc创建在障碍格或者已被其他npc占用的格子上，出现重合现象
+    auto tileNode = _mapManager->getTileNodeAt(columnIndex, rowIndex);
+    int tileIndex = columnIndex * (int)_mapManager->getMapSize().height + rowIndex;
+    if (tileNode->gid == OBSTACLE_ID ||
+        _gameObjectManager->getNpcCountInTile(columnIndex, rowIndex) > 0 ||
+        _npcCreatePointBatchList[tileIndex] == _npcCreatePointBatch)
+    {
+        return;
+    }
+
+    npcCreatePointList.push_back(tileNode->leftTopPosition);
+    _npcCreatePointBatchList[tileIndex] = _npcCreatePointBatch;
+}
+
 void GameWorld::createReinforcement(ForceType forceType, const string& npcTemplateName, int npcCount)
 {
     int buildingUniqueID = GAME_OBJECT_UNIQUE_ID_INVALID;
@@ -638,6 +1048,28 @@ const DebugInfo& GameWorld::getDebugInfo()
 {
     _debugInfo.mapDebugInfo = _mapManager->getMapDebugInfo(TileMapLayerType::GameObjcetLayer);
     _debugInfo.gameObjectCount = (int)_gameObjectManager->getGameObjectMap().size();
+    _debugInfo.pathCacheHitCount = PathCacheHelper::getHitCount();
+    _debugInfo.pathCacheMissCount = PathCacheHelper::getMissCount();
+    _debugInfo.pathCacheEvictedCount = PathCacheHelper::getEvictedCount();
+    _debugInfo.pendingPathRequestCount = PathRequestService::getPendingRequestCount();
+    _debugInfo.waitingPathRequestCount = PathRequestService::getWaitingRequestCount();
+    _debugInfo.searchingPathRequestCount = PathRequestService::getSearchingRequestCount();
+    _debugInfo.lastFrameExpandedNodeCount = PathRequestService::getLastFrameExpandedNodeCount();
+    _debugInfo.pathPlannerCount = (int)_pathPlannerMap.size();
+    _debugInfo.validLandmarkCount = LandmarkHelper::getValidLandmarkCount();
+    _debugInfo.allowNavMeshPath = g_setting.allowNavMeshPath;
+    _debugInfo.navMeshPolygonCount = NavMeshHelper::getPolygonCount();
+    _debugInfo.lastNavMeshExpandedNodeCount = NavMeshHelper::getLastSearchExpandedNodeCount();
+    _debugInfo.buildingRouteCount = BuildingRouteHelper::getRouteCount();
+    _debugInfo.pendingBuildingRouteCount = BuildingRouteHelper::getPendingRouteCount();
+    _debugInfo.buildingRouteHitCount = BuildingRouteHelper::getHitCount();
+    _debugInfo.allowLocalAvoidance = g_setting.allowLocalAvoidance;
+    _debugInfo.avoidanceAgentCount = g_setting.allowLocalAvoidance ? _gameObjectManager->getAvoidanceAgentCount() : 0;
+    _debugInfo.allowCooperativePath = g_setting.allowCooperativePath;
+    _debugInfo.pathReservationCount = CooperativePathHelper::getReservationCount();
+    _debugInfo.cooperativeDetourCount = CooperativePathHelper::getDetourCount();
+    _debugInfo.lastFrameNpcCollisionCount = _gameObjectManager->getLastFrameNpcCollisionCount();
+    _debugInfo.lastMoveOrderArriveTime = _gameObjectManager->getLastMoveOrderArriveTime();
 
     return _debugInfo;
 }
@@ -776,6 +1208,32 @@ void GameWorld::onJumpToPlayerBaseCamp()
     }
 }
 
+void GameWorld::runAOEDamageBenchmark()
+{
+    auto report = _bulletManager->runAOEDamageBenchmark(AOE_BENCHMARK_IMPACT_COUNT);
+    _debugInfo.aoeBenchmarkImpactCount = report.impactCount;
+    _debugInfo.aoeBenchmarkHitCount = report.indexedHitCount;
+    _debugInfo.aoeBenchmarkFullScanMicroseconds = (float)report.fullScanMicroseconds;
+    _debugInfo.aoeBenchmarkIndexedMicroseconds = (float)report.indexedMicroseconds;
+
+    log("AOE benchmark: impacts = %d, game objects = %d, hits = %d (full scan %d), full scan = %.1fus, indexed = %.1fus",
+        report.impactCount, (int)_gameObjectManager->getGameObjectMap().size(), report.indexedHitCount, report.fullScanHitCount,
+        report.fullScanMicroseconds, report.indexedMicroseconds);
+}
+
+void GameWorld::runNpcCollisionBenchmark()
+{
+    auto report = _gameObjectManager->runNpcCollisionBenchmark(NPC_COLLISION_BENCHMARK_FRAME_COUNT);
+    _debugInfo.npcCollisionBenchmarkNpcCount = report.npcCount;
+    _debugInfo.npcCollisionBenchmarkPairCount = report.broadphasePairCount;
+    _debugInfo.npcCollisionBenchmarkRadiusQueryMicroseconds = (float)report.radiusQueryMicroseconds;
+    _debugInfo.npcCollisionBenchmarkBroadphaseMicroseconds = (float)report.broadphaseMicroseconds;
+
+    log("Collision benchmark: frames = %d, npcs = %d, pairs = %d (radius query %d), radius query = %.1fus, broadphase = %.1fus",
+        report.frameCount, report.npcCount, report.broadphasePairCount, report.radiusQueryPairCount,
+        report.radiusQueryMicroseconds, report.broadphaseMicroseconds);
+}
+
 bool GameWorld::isPlayerHoldingBuilding()
 {
     return _holdingBuildingID != GAME_OBJECT_UNIQUE_ID_INVALID;
@@ -908,6 +1366,13 @@ void GameWorld::onLost()
 
 void GameWorld::clear()
 {
+    // 寻路器注册在格子变化的通知列表里，要在格子释放之前删除
+    for (auto& pathPlannerIter : _pathPlannerMap)
+    {
+        delete pathPlannerIter.second;
+    }
+    _pathPlannerMap.clear();
+
     if (_mapManager != nullptr)
     {
         CC_SAFE_DELETE(_mapManager);
@@ -9,12 +9,71 @@ class SpecialEffectManager;
 class ForceManager;
 class GameUICallbackFunctionsManager;
 class SoundManager;
+class IncrementalPathPlanner;
+struct TileNode;
+
+const int MAX_PATH_REPAIR_COUNT_PER_FRAME = 8;
 
 struct DebugInfo
 {
     MapDebugInfo mapDebugInfo;
 
     int gameObjectCount = 0;
+
+    int pathCacheHitCount = 0;
+    int pathCacheMissCount = 0;
+    int pathCacheEvictedCount = 0;
+
+    int pendingPathRequestCount = 0;
+    int waitingPathRequestCount = 0;
+    int searchingPathRequestCount = 0;
+    int lastFrameExpandedNodeCount = 0;
+
+    int pathPlannerCount = 0;
+    int lastPathRepairExpandedNodeCount = 0;
+    int validLandmarkCount = 0;
+
+    bool allowNavMeshPath = false;
+    int navMeshPolygonCount = 0;
+    int lastNavMeshExpandedNodeCount = 0;
+
+    int buildingRouteCount = 0;
+    int pendingBuildingRouteCount = 0;
+    int buildingRouteHitCount = 0;
+
+    bool allowLocalAvoidance = false;
+    int avoidanceAgentCount = 0;
+
+    int aoeBenchmarkImpactCount = 0;
+    int aoeBenchmarkHitCount = 0;
+    float aoeBenchmarkFullScanMicroseconds = 0.0f;
+    float aoeBenchmarkIndexedMicroseconds = 0.0f;
+
+    int npcCollisionBenchmarkNpcCount = 0;
+    int npcCollisionBenchmarkPairCount = 0;
+    float npcCollisionBenchmarkRadiusQueryMicroseconds = 0.0f;
+    float npcCollisionBenchmarkBroadphaseMicroseconds = 0.0f;
+
+    bool allowCooperativePath = false;
+    int pathReservationCount = 0;
+    int cooperativeDetourCount = 0;
+    int lastFrameNpcCollisionCount = 0;
+    float lastMoveOrderArriveTime = 0.0f;
+};
+
+struct PathRequestPosition
+{
+    Vec2 inMapStartPosition;
+    vector<Vec2> inMapEndPositionList;     // 有多个终点时，取回结果以后按照到达的格子选出对应的位置
+    bool isAllowEndTileNodeToMoveIn = false;
+
+    // 只有一个终点、没有命中路径缓存的请求，取回结果以后放进缓存
+    TileNode* startTileNode = nullptr;
+    TileNode* endTileNode = nullptr;
+
+    bool hasPointPathList = false;  // 导航网格在提交请求时就已经给出了拉直的坐标点
+    list<Vec2> pointPathList;
+    int navigationVersion = 0;      // 算出pointPathList时的地图版本，取回时地图变了就检查坐标点之间是否被挡住
 };
 
 class GameWorld : public Node
@@ -38,7 +97,24 @@ public:
 
     void syncCursorPoint(const Vec2& cursorPoint);
 
-    list<Vec2>  computePathList(const Vec2& inMapStartPosition, const Vec2& inMapEndPosition, bool isAllowEndTileNodeToMoveIn = false);
+    // 流场路径从npc当前位置出发，开启协作寻路时还会避开同一批npc预约的格子
+    list<Vec2>  computePathListByFlowField(int npcUniqueID, const Vec2& inMapFlowFieldEndPosition, const Vec2& inMapEndPosition, bool isAllowEndTileNodeToMoveIn);
+    // 沿着从所有终点同时出发的流场走到最近的一个终点，多个npc攻击同一个建筑物时共用
+    list<Vec2>  computePathListByFlowFieldToNearest(int npcUniqueID, const vector<Vec2>& inMapEndPositionList, bool isAllowEndTileNodeToMoveIn);
+    // npc在另一个建筑物附近时查建筑物之间的路线表，走进目标建筑物的占地格子；查不到时返回空列表
+    list<Vec2>  computePathListByBuildingRoute(int npcUniqueID, int buildingUniqueID);
+    // 在工作线程中寻路，之后通过tryGetRequestedPathList取回结果，取回之前返回false
+    int requestPathList(const Vec2& inMapStartPosition, const Vec2& inMapEndPosition, bool isAllowEndTileNodeToMoveIn);
+    // 到达inMapEndPositionList中任意一个位置即可，一次搜索找出代价最小的那个
+    int requestPathListToNearest(const Vec2& inMapStartPosition, const vector<Vec2>& inMapEndPositionList, bool isAllowEndTileNodeToMoveIn);
+    bool tryGetRequestedPathList(int requestID, list<Vec2>& pointPathList);
+    void cancelPathRequest(int requestID);
+    // 从当前位置沿着路径直线走过的格子中有障碍物时返回true，允许进入终点时不检查最后一个格子
+    bool isPathListBlocked(const Vec2& inMapCurrentPosition, const list<Vec2>& pointPathList, bool isAllowEndTileNodeToMoveIn);
+    // 用npc自己的增量寻路器修复剩余路径，终点不变；本帧修复次数用完时返回false，下一帧再试
+    bool repairPathList(int npcUniqueID, const Vec2& inMapCurrentPosition, bool isAllowEndTileNodeToMoveIn, list<Vec2>& pointPathList);
+    void removePathPlanner(int npcUniqueID);
+    void releasePathReservations(int npcUniqueID);
     MapManager* getMapManager();
     const DebugInfo& getDebugInfo();
     void createReinforcement(ForceType forceType, const string& npcTemplateName, int npcCount);    
@@ -54,6 +130,8 @@ public:
 
     void onPlayerManipulateTeamBy(int teamID);
     void onJumpToPlayerBaseCamp();
+    void runAOEDamageBenchmark();
+    void runNpcCollisionBenchmark();
 
     bool isPlayerHoldingBuilding();
 
@@ -63,14 +141,29 @@ public:
 private:
     bool init() override;
     void initEditedGameObjects();
-    void initMapGIDTable();
+    void initNpcCreatePointBatchList();
 
     void update(float deltaTime) override;
     void onMouseScroll(Event* event);
     void constructBuilding();
     void cancelConstructBuilding();
 
+    list<Vec2> computePathListBy(const Vec2& inMapStartPosition, const Vec2& inMapEndPosition, bool isAllowEndTileNodeToMoveIn, TileNode* flowFieldEndTileNode,
+        int cooperativeNpcUniqueID = GAME_OBJECT_UNIQUE_ID_INVALID);
+    // 没有开启协作寻路时返回0，否则返回路径从起点数起不能拉直的格子数
+    int computeCooperativeTileNodePathList(int npcUniqueID, bool isAllowEndTileNodeToMoveIn, list<TileNode*>& tileNodePathList);
+    // 拉直格子路径后转换成npc移动用的坐标点，起点一侧的unsmoothedTileNodeCount个格子保持原样
+    list<Vec2> convertToPointPathList(const list<TileNode*>& tileNodePathList, const Vec2& inMapStartPosition, const Vec2& inMapEndPosition, bool isAllowEndTileNodeToMoveIn,
+        int unsmoothedTileNodeCount = 0);
+    // 导航网格一次只搜索一个终点，多个终点时取直线距离最近的可达终点；起点在障碍格内等情况下返回false，改用格子寻路
+    bool computeNavMeshPointPathList(const Vec2& inMapStartPosition, const vector<Vec2>& inMapEndPositionList, const vector<TileNode*>& endTileNodeList,
+        bool isAllowEndTileNodeToMoveIn, list<Vec2>& pointPathList);
+    // 取回时导航网格的结果已经被挡住，按照最新的地图重新计算，导航网格拒绝时改用格子寻路
+    void recomputeNavMeshPointPathList(PathRequestPosition& pathRequestPosition);
+    vector<TileNode*> computeReachableEndTileNodeList(TileNode* startTileNode, const vector<Vec2>& inMapEndPositionList, bool isAllowEndTileNodeToMoveIn);
+    Vec2 getInMapEndPositionAt(TileNode* endTileNode, const vector<Vec2>& inMapEndPositionList);
     vector<Vec2> computeNpcCreatePointList(int buildingUniqueID, int readyToCreateNpcCount, bool shouldRefreshMap);
+    void tryAddNpcCreatePoint(int columnIndex, int rowIndex, int readyToCreateNpcCount, vector<Vec2>& npcCreatePointList);
 
     bool isLeftButtonMultyClick();
     bool isTeamContinuousCalledInAFlash(int teamID);
@@ -110,7 +203,15 @@ private:
 
     int _playerBaseCampUniqueID = GAME_OBJECT_UNIQUE_ID_INVALID;
     int _aiBaseCampUniqueID = GAME_OBJECT_UNIQUE_ID_INVALID;
-    vector<vector<int>> _mapGIDTable;   // Ѱnpcλãnpcônpcռõĸϰ
+    // 寻找npc出兵点时，障碍格和有npc的格子直接查MapManager和GameObjectManager，这个表只记录每个格子最后一次被选为出兵点的批次，
+    // 同一批次中已经选过的格子不再选，shouldRefreshMap为true时开始新的批次
+    vector<int> _npcCreatePointBatchList;
+    int _npcCreatePointBatch = 0;
+
+    vector<GameObject*> _pillboxList;   // 可相互争夺的建筑物列表
+
+    unordered_map<int, PathRequestPosition> _pathRequestPositionMap;
 
-    vector<GameObject*> _pillboxList;   // ໥Ľб
+    unordered_map<int, IncrementalPathPlanner*> _pathPlannerMap;   // key是npc的uniqueID
+    int _pathRepairCountInFrame = 0;
 };
\ No newline at end of file
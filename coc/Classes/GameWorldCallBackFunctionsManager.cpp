@@ -20,7 +20,16 @@ void GameWorldCallBackFunctionsManager::registerCallBackFunctions(GameWorld* gam
 {
     _createBullet = CC_CALLBACK_3(GameWorld::createBullet, gameWorld);
     _removeGameObjectBy = CC_CALLBACK_1(GameWorld::removeGameObjectBy, gameWorld);
-    _computePathList = CC_CALLBACK_3(GameWorld::computePathList, gameWorld);
+    _computePathListByFlowField = CC_CALLBACK_4(GameWorld::computePathListByFlowField, gameWorld);
+    _computePathListByFlowFieldToNearest = CC_CALLBACK_3(GameWorld::computePathListByFlowFieldToNearest, gameWorld);
+    _computePathListByBuildingRoute = CC_CALLBACK_2(GameWorld::computePathListByBuildingRoute, gameWorld);
+    _requestPathListToNearest = CC_CALLBACK_3(GameWorld::requestPathListToNearest, gameWorld);
+    _tryGetRequestedPathList = CC_CALLBACK_2(GameWorld::tryGetRequestedPathList, gameWorld);
+    _cancelPathRequest = CC_CALLBACK_1(GameWorld::cancelPathRequest, gameWorld);
+    _isPathListBlocked = CC_CALLBACK_3(GameWorld::isPathListBlocked, gameWorld);
+    _repairPathList = CC_CALLBACK_4(GameWorld::repairPathList, gameWorld);
+    _removePathPlanner = CC_CALLBACK_1(GameWorld::removePathPlanner, gameWorld);
+    _releasePathReservations = CC_CALLBACK_1(GameWorld::releasePathReservations, gameWorld);
     _getMapManager = CC_CALLBACK_0(GameWorld::getMapManager, gameWorld);
     _createSpecialEffect = CC_CALLBACK_3(GameWorld::createSpecialEffect, gameWorld);
     _getDebugInfo = CC_CALLBACK_0(GameWorld::getDebugInfo, gameWorld);
@@ -13,7 +13,16 @@ public:
 
     std::function<void(BulletType, int, int)> _createBullet;
     std::function<void(int)> _removeGameObjectBy;
-    std::function<list<Vec2>(const Vec2&, const Vec2&, bool)> _computePathList;
+    std::function<list<Vec2>(int, const Vec2&, const Vec2&, bool)> _computePathListByFlowField;
+    std::function<list<Vec2>(int, const vector<Vec2>&, bool)> _computePathListByFlowFieldToNearest;
+    std::function<list<Vec2>(int, int)> _computePathListByBuildingRoute;
+    std::function<int(const Vec2&, const vector<Vec2>&, bool)> _requestPathListToNearest;
+    std::function<bool(int, list<Vec2>&)> _tryGetRequestedPathList;
+    std::function<void(int)> _cancelPathRequest;
+    std::function<bool(const Vec2&, const list<Vec2>&, bool)> _isPathListBlocked;
+    std::function<bool(int, const Vec2&, bool, list<Vec2>&)> _repairPathList;
+    std::function<void(int)> _removePathPlanner;
+    std::function<void(int)> _releasePathReservations;
     std::function<MapManager*()> _getMapManager;
     std::function<void(const string&, const Vec2&, bool)> _createSpecialEffect;
     std::function<const DebugInfo&()> _getDebugInfo;
@@ -0,0 +1,683 @@
+#include "Base.h"
+#include "MapManager.h"
+#include "AutoFindPathHelper.h"
+#include "HierarchicalPathHelper.h"
+
+const int NODE_INDEX_INVALID = -1;
+const int WEIGHT_INFINITE = INT_MAX;
+const int MAX_SINGLE_ENTRANCE_LENGTH = 6;  // 入口长度小于这个值时只在中间放一个过渡点，否则在两端各放一个
+
+enum BorderDirection
+{
+    ColumnBorder = 0,   // 与列号+1的区块相邻的边界
+    RowBorder,          // 与行号+1的区块相邻的边界
+
+    BorderDirectionCount
+};
+
+struct AbstractEdge
+{
+    int targetNodeIndex = NODE_INDEX_INVALID;
+    int weight = 0;
+};
+
+// 抽象图上的节点，每个节点对应区块边界上的一个过渡格子
+struct AbstractNode
+{
+    int columnIndex = 0;
+    int rowIndex = 0;
+    int clusterIndex = 0;
+    int entranceNodeIndex = NODE_INDEX_INVALID; // 边界另一侧与之相连的节点
+    vector<AbstractEdge> intraEdgeList;         // 同一区块内可到达的其他节点
+};
+
+struct Cluster
+{
+    int minColumnIndex = 0;
+    int minRowIndex = 0;
+    int maxColumnIndex = 0;
+    int maxRowIndex = 0;
+    vector<int> nodeIndexList;
+};
+
+struct AbstractSearchNode
+{
+    int gotoStartNodeWeight = 0;
+    int gotoEndNodeWeight = WEIGHT_INFINITE;   // 只有终点所在区块内的节点才有效
+    int parentNodeIndex = NODE_INDEX_INVALID;
+    unsigned int generation = 0;
+    bool isClosed = false;
+};
+
+typedef pair<int, int> OpenListElement;     // <sumWeight, nodeIndex>
+
+static NavigationGrid* g_navigationGrid = nullptr;
+static int g_maxColumnCount = 0;
+static int g_maxRowCount = 0;
+
+static vector<Cluster> g_clusterList;
+static int g_clusterColumnCount = 0;
+static int g_clusterRowCount = 0;
+
+static vector<AbstractNode> g_nodeList;
+static vector<int> g_freeNodeIndexList;
+static vector<vector<int>> g_borderNodeIndexList;   // 下标为clusterIndex * BorderDirectionCount + BorderDirection
+
+static vector<int> g_localWeightList;
+static vector<OpenListElement> g_localOpenList;
+
+static vector<AbstractSearchNode> g_abstractSearchNodeList;
+static vector<OpenListElement> g_abstractOpenList;
+static vector<AbstractEdge> g_startEdgeList;
+static vector<int> g_abstractPathNodeIndexList;
+static unsigned int g_currentGeneration = 0;
+static int g_startNodeIndex = NODE_INDEX_INVALID;
+static int g_endNodeIndex = NODE_INDEX_INVALID;
+static TileNode* g_startTileNode = nullptr;
+static TileNode* g_endTileNode = nullptr;
+static bool g_isEndTileNodePassable = false;
+
+static int computeWeightBetween(int fromColumnIndex, int fromRowIndex, int toColumnIndex, int toRowIndex)
+{
+    int rowDistance = std::abs(toRowIndex - fromRowIndex);
+    int columnDistance = std::abs(toColumnIndex - fromColumnIndex);
+    int slopStepCount = std::min(rowDistance, columnDistance);
+    int straightStepCount = std::max(rowDistance, columnDistance) - slopStepCount;
+
+    return slopStepCount * MOVE_SLOP_WEIGHT + straightStepCount * MOVE_STRAIGHT_WEIGHT;
+}
+
+void HierarchicalPathHelper::initNavigationGrid(NavigationGrid& navigationGrid)
+{
+    g_navigationGrid = &navigationGrid;
+    g_maxColumnCount = navigationGrid.columnCount;
+    g_maxRowCount = navigationGrid.rowCount;
+
+    g_localWeightList.assign(PATH_CLUSTER_SIZE * PATH_CLUSTER_SIZE, WEIGHT_INFINITE);
+    g_localOpenList.reserve(PATH_CLUSTER_SIZE * PATH_CLUSTER_SIZE * 8);
+
+    initClusterList();
+
+    g_nodeList.clear();
+    g_freeNodeIndexList.clear();
+    g_borderNodeIndexList.assign(g_clusterList.size() * BorderDirectionCount, vector<int>());
+    g_abstractSearchNodeList.clear();
+    g_currentGeneration = 0;
+
+    set<int> clusterIndexSet;
+    for (int clusterIndex = 0; clusterIndex < (int)g_clusterList.size(); clusterIndex++)
+    {
+        clusterIndexSet.insert(clusterIndex);
+    }
+    rebuildClusters(clusterIndexSet);
+}
+
+list<TileNode*> HierarchicalPathHelper::computeTileNodePathListBetween(TileNode* startNode, TileNode* endNode, bool isEndTileNodePassable /* = false */)
+{
+    int tileDistance = std::max(std::abs(endNode->columnIndex - startNode->columnIndex), std::abs(endNode->rowIndex - startNode->rowIndex));
+    if (tileDistance < HIERARCHICAL_SEARCH_MIN_TILE_DISTANCE)
+    {
+        return AutoFindPathHelper::computeTileNodePathListBetween(startNode, endNode, isEndTileNodePassable);
+    }
+
+    // 抽象图上从终点出发计算代价时不检查终点本身能否通行，只有细化最后一段路时需要这个标记
+    g_isEndTileNodePassable = isEndTileNodePassable;
+    if (!searchAbstractPath(startNode, endNode))
+    {
+        // 有些只能斜穿区块边角的通路不会生成过渡点，抽象图上找不到路径时退回到完整寻路
+        return AutoFindPathHelper::computeTileNodePathListBetween(startNode, endNode, isEndTileNodePassable);
+    }
+
+    return refineAbstractPath();
+}
+
+bool HierarchicalPathHelper::computeWaypointList(TileNode* startNode, TileNode* endNode, vector<TileNode*>& waypointList)
+{
+    bool result = false;
+
+    waypointList.clear();
+    int tileDistance = std::max(std::abs(endNode->columnIndex - startNode->columnIndex), std::abs(endNode->rowIndex - startNode->rowIndex));
+    if (tileDistance >= HIERARCHICAL_SEARCH_MIN_TILE_DISTANCE && searchAbstractPath(startNode, endNode))
+    {
+        // 跨越区块边界的两个过渡点是相邻格子，只保留进入新区块的那个，每一段细化都在一个区块附近
+        for (int pathIndex = 1; pathIndex + 1 < (int)g_abstractPathNodeIndexList.size(); pathIndex++)
+        {
+            auto tileNode = getAbstractNodeTileNode(g_abstractPathNodeIndexList[pathIndex]);
+            auto previousTileNode = getAbstractNodeTileNode(g_abstractPathNodeIndexList[pathIndex - 1]);
+            if (tileNode != startNode && tileNode != endNode &&
+                getClusterIndex(tileNode->columnIndex, tileNode->rowIndex) != getClusterIndex(previousTileNode->columnIndex, previousTileNode->rowIndex))
+            {
+                waypointList.push_back(tileNode);
+            }
+        }
+
+        result = true;
+    }
+
+    return result;
+}
+
+void HierarchicalPathHelper::onTileNodesGIDChanged(const vector<TileNode*>& tileNodeList)
+{
+    set<int> clusterIndexSet;
+    for (auto tileNode : tileNodeList)
+    {
+        clusterIndexSet.insert(getClusterIndex(tileNode->columnIndex, tileNode->rowIndex));
+    }
+
+    rebuildClusters(clusterIndexSet);
+}
+
+void HierarchicalPathHelper::initClusterList()
+{
+    g_clusterColumnCount = (g_maxColumnCount + PATH_CLUSTER_SIZE - 1) / PATH_CLUSTER_SIZE;
+    g_clusterRowCount = (g_maxRowCount + PATH_CLUSTER_SIZE - 1) / PATH_CLUSTER_SIZE;
+
+    g_clusterList.clear();
+    g_clusterList.resize(g_clusterColumnCount * g_clusterRowCount);
+
+    for (int clusterColumnIndex = 0; clusterColumnIndex < g_clusterColumnCount; clusterColumnIndex++)
+    {
+        for (int clusterRowIndex = 0; clusterRowIndex < g_clusterRowCount; clusterRowIndex++)
+        {
+            auto& cluster = g_clusterList[clusterColumnIndex * g_clusterRowCount + clusterRowIndex];
+            cluster.minColumnIndex = clusterColumnIndex * PATH_CLUSTER_SIZE;
+            cluster.minRowIndex = clusterRowIndex * PATH_CLUSTER_SIZE;
+            cluster.maxColumnIndex = std::min(cluster.minColumnIndex + PATH_CLUSTER_SIZE, g_maxColumnCount) - 1;
+            cluster.maxRowIndex = std::min(cluster.minRowIndex + PATH_CLUSTER_SIZE, g_maxRowCount) - 1;
+        }
+    }
+}
+
+void HierarchicalPathHelper::rebuildClusters(const set<int>& clusterIndexSet)
+{
+    // 区块内格子的变化会影响它四条边上的过渡点，而过渡点的变化又会影响相邻区块内部的连通关系
+    set<int> borderIndexSet;
+    set<int> relinkClusterIndexSet;
+    for (auto clusterIndex : clusterIndexSet)
+    {
+        int clusterColumnIndex = clusterIndex / g_clusterRowCount;
+        int clusterRowIndex = clusterIndex % g_clusterRowCount;
+        relinkClusterIndexSet.insert(clusterIndex);
+
+        if (clusterColumnIndex + 1 < g_clusterColumnCount)
+        {
+            borderIndexSet.insert(clusterIndex * BorderDirectionCount + ColumnBorder);
+            relinkClusterIndexSet.insert(clusterIndex + g_clusterRowCount);
+        }
+        if (clusterColumnIndex > 0)
+        {
+            borderIndexSet.insert((clusterIndex - g_clusterRowCount) * BorderDirectionCount + ColumnBorder);
+            relinkClusterIndexSet.insert(clusterIndex - g_clusterRowCount);
+        }
+        if (clusterRowIndex + 1 < g_clusterRowCount)
+        {
+            borderIndexSet.insert(clusterIndex * BorderDirectionCount + RowBorder);
+            relinkClusterIndexSet.insert(clusterIndex + 1);
+        }
+        if (clusterRowIndex > 0)
+        {
+            borderIndexSet.insert((clusterIndex - 1) * BorderDirectionCount + RowBorder);
+            relinkClusterIndexSet.insert(clusterIndex - 1);
+        }
+    }
+
+    for (auto borderIndex : borderIndexSet)
+    {
+        removeBorderEntrances(borderIndex);
+        buildBorderEntrances(borderIndex);
+    }
+
+    for (auto clusterIndex : relinkClusterIndexSet)
+    {
+        buildIntraEdges(clusterIndex);
+    }
+}
+
+void HierarchicalPathHelper::buildBorderEntrances(int borderIndex)
+{
+    auto& cluster = g_clusterList[borderIndex / BorderDirectionCount];
+    bool isColumnBorder = (borderIndex % BorderDirectionCount == ColumnBorder);
+
+    // 沿着边界扫描两侧都可通行的连续格子，每一段连续格子作为一个入口
+    int borderLength = isColumnBorder ? (cluster.maxRowIndex - cluster.minRowIndex + 1) : (cluster.maxColumnIndex - cluster.minColumnIndex + 1);
+    int entranceStartOffset = -1;
+    for (int offset = 0; offset <= borderLength; offset++)
+    {
+        bool isOpen = false;
+        if (offset < borderLength)
+        {
+            if (isColumnBorder)
+            {
+                isOpen = isPassable(cluster.maxColumnIndex, cluster.minRowIndex + offset) &&
+                    isPassable(cluster.maxColumnIndex + 1, cluster.minRowIndex + offset);
+            }
+            else
+            {
+                isOpen = isPassable(cluster.minColumnIndex + offset, cluster.maxRowIndex) &&
+                    isPassable(cluster.minColumnIndex + offset, cluster.maxRowIndex + 1);
+            }
+        }
+
+        if (isOpen)
+        {
+            if (entranceStartOffset < 0)
+            {
+                entranceStartOffset = offset;
+            }
+            continue;
+        }
+
+        if (entranceStartOffset < 0)
+        {
+            continue;
+        }
+
+        int entranceEndOffset = offset - 1;
+        vector<int> transitionOffsetList;
+        if (entranceEndOffset - entranceStartOffset + 1 < MAX_SINGLE_ENTRANCE_LENGTH)
+        {
+            transitionOffsetList.push_back((entranceStartOffset + entranceEndOffset) / 2);
+        }
+        else
+        {
+            transitionOffsetList.push_back(entranceStartOffset);
+            transitionOffsetList.push_back(entranceEndOffset);
+        }
+
+        for (auto transitionOffset : transitionOffsetList)
+        {
+            if (isColumnBorder)
+            {
+                int rowIndex = cluster.minRowIndex + transitionOffset;
+                addEntrance(cluster.maxColumnIndex, rowIndex, cluster.maxColumnIndex + 1, rowIndex, borderIndex);
+            }
+            else
+            {
+                int columnIndex = cluster.minColumnIndex + transitionOffset;
+                addEntrance(columnIndex, cluster.maxRowIndex, columnIndex, cluster.maxRowIndex + 1, borderIndex);
+            }
+        }
+
+        entranceStartOffset = -1;
+    }
+}
+
+void HierarchicalPathHelper::removeBorderEntrances(int borderIndex)
+{
+    auto& borderNodeIndexList = g_borderNodeIndexList[borderIndex];
+    for (auto nodeIndex : borderNodeIndexList)
+    {
+        auto& node = g_nodeList[nodeIndex];
+        auto& clusterNodeIndexList = g_clusterList[node.clusterIndex].nodeIndexList;
+        clusterNodeIndexList.erase(std::remove(clusterNodeIndexList.begin(), clusterNodeIndexList.end(), nodeIndex), clusterNodeIndexList.end());
+
+        node.entranceNodeIndex = NODE_INDEX_INVALID;
+        node.intraEdgeList.clear();
+        g_freeNodeIndexList.push_back(nodeIndex);
+    }
+
+    borderNodeIndexList.clear();
+}
+
+void HierarchicalPathHelper::addEntrance(int columnIndex, int rowIndex, int besideColumnIndex, int besideRowIndex, int borderIndex)
+{
+    int nodeIndex = createAbstractNode(columnIndex, rowIndex);
+    int besideNodeIndex = createAbstractNode(besideColumnIndex, besideRowIndex);
+
+    g_nodeList[nodeIndex].entranceNodeIndex = besideNodeIndex;
+    g_nodeList[besideNodeIndex].entranceNodeIndex = nodeIndex;
+
+    g_borderNodeIndexList[borderIndex].push_back(nodeIndex);
+    g_borderNodeIndexList[borderIndex].push_back(besideNodeIndex);
+}
+
+int HierarchicalPathHelper::createAbstractNode(int columnIndex, int rowIndex)
+{
+    int nodeIndex = NODE_INDEX_INVALID;
+    if (g_freeNodeIndexList.empty())
+    {
+        nodeIndex = (int)g_nodeList.size();
+        g_nodeList.push_back(AbstractNode());
+    }
+    else
+    {
+        nodeIndex = g_freeNodeIndexList.back();
+        g_freeNodeIndexList.pop_back();
+    }
+
+    auto& node = g_nodeList[nodeIndex];
+    node.columnIndex = columnIndex;
+    node.rowIndex = rowIndex;
+    node.clusterIndex = getClusterIndex(columnIndex, rowIndex);
+    node.entranceNodeIndex = NODE_INDEX_INVALID;
+    node.intraEdgeList.clear();
+
+    g_clusterList[node.clusterIndex].nodeIndexList.push_back(nodeIndex);
+
+    return nodeIndex;
+}
+
+void HierarchicalPathHelper::buildIntraEdges(int clusterIndex)
+{
+    auto& nodeIndexList = g_clusterList[clusterIndex].nodeIndexList;
+    for (auto nodeIndex : nodeIndexList)
+    {
+        auto& node = g_nodeList[nodeIndex];
+        node.intraEdgeList.clear();
+
+        computeLocalWeightsFrom(clusterIndex, node.columnIndex, node.rowIndex);
+        for (auto targetNodeIndex : nodeIndexList)
+        {
+            if (targetNodeIndex == nodeIndex)
+            {
+                continue;
+            }
+
+            auto& targetNode = g_nodeList[targetNodeIndex];
+            int weight = getLocalWeight(clusterIndex, targetNode.columnIndex, targetNode.rowIndex);
+            if (weight != WEIGHT_INFINITE)
+            {
+                AbstractEdge edge;
+                edge.targetNodeIndex = targetNodeIndex;
+                edge.weight = weight;
+                node.intraEdgeList.push_back(edge);
+            }
+        }
+    }
+}
+
+void HierarchicalPathHelper::computeLocalWeightsFrom(int clusterIndex, int columnIndex, int rowIndex)
+{
+    // 区块内的Dijkstra，移动规则与AutoFindPathHelper相同，只是不允许离开区块
+    auto& cluster = g_clusterList[clusterIndex];
+    std::fill(g_localWeightList.begin(), g_localWeightList.end(), WEIGHT_INFINITE);
+    g_localOpenList.clear();
+
+    int startLocalIndex = (columnIndex - cluster.minColumnIndex) * PATH_CLUSTER_SIZE + (rowIndex - cluster.minRowIndex);
+    g_localWeightList[startLocalIndex] = 0;
+    g_localOpenList.push_back(OpenListElement(0, startLocalIndex));
+
+    while (!g_localOpenList.empty())
+    {
+        std::pop_heap(g_localOpenList.begin(), g_localOpenList.end(), std::greater<OpenListElement>());
+        auto currentElement = g_localOpenList.back();
+        g_localOpenList.pop_back();
+
+        int currentWeight = currentElement.first;
+        if (currentWeight > g_localWeightList[currentElement.second])
+        {
+            continue;
+        }
+
+        int currentColumnIndex = cluster.minColumnIndex + currentElement.second / PATH_CLUSTER_SIZE;
+        int currentRowIndex = cluster.minRowIndex + currentElement.second % PATH_CLUSTER_SIZE;
+
+        for (int besideColumnIndex = std::max(currentColumnIndex - 1, cluster.minColumnIndex); besideColumnIndex <= std::min(currentColumnIndex + 1, cluster.maxColumnIndex); besideColumnIndex++)
+        {
+            for (int besideRowIndex = std::max(currentRowIndex - 1, cluster.minRowIndex); besideRowIndex <= std::min(currentRowIndex + 1, cluster.maxRowIndex); besideRowIndex++)
+            {
+                if ((besideColumnIndex == currentColumnIndex && besideRowIndex == currentRowIndex) ||
+                    !isPassable(besideColumnIndex, besideRowIndex))
+                {
+                    continue;
+                }
+
+                int moveWeight = MOVE_STRAIGHT_WEIGHT;
+                if (besideColumnIndex != currentColumnIndex && besideRowIndex != currentRowIndex)
+                {
+                    moveWeight = MOVE_SLOP_WEIGHT;
+                }
+
+                int besideLocalIndex = (besideColumnIndex - cluster.minColumnIndex) * PATH_CLUSTER_SIZE + (besideRowIndex - cluster.minRowIndex);
+                if (currentWeight + moveWeight < g_localWeightList[besideLocalIndex])
+                {
+                    g_localWeightList[besideLocalIndex] = currentWeight + moveWeight;
+                    g_localOpenList.push_back(OpenListElement(currentWeight + moveWeight, besideLocalIndex));
+                    std::push_heap(g_localOpenList.begin(), g_localOpenList.end(), std::greater<OpenListElement>());
+                }
+            }
+        }
+    }
+}
+
+int HierarchicalPathHelper::getLocalWeight(int clusterIndex, int columnIndex, int rowIndex)
+{
+    auto& cluster = g_clusterList[clusterIndex];
+    return g_localWeightList[(columnIndex - cluster.minColumnIndex) * PATH_CLUSTER_SIZE + (rowIndex - cluster.minRowIndex)];
+}
+
+bool HierarchicalPathHelper::searchAbstractPath(TileNode* startNode, TileNode* endNode)
+{
+    bool result = false;
+
+    g_startTileNode = startNode;
+    g_endTileNode = endNode;
+
+    // 起点和终点作为两个临时节点接入抽象图，下标排在所有过渡点之后
+    g_startNodeIndex = (int)g_nodeList.size();
+    g_endNodeIndex = g_startNodeIndex + 1;
+    if ((int)g_abstractSearchNodeList.size() < g_endNodeIndex + 1)
+    {
+        g_abstractSearchNodeList.resize(g_endNodeIndex + 1);
+    }
+
+    g_currentGeneration++;
+    if (g_currentGeneration == 0)
+    {
+        for (auto& searchNode : g_abstractSearchNodeList)
+        {
+            searchNode.generation = 0;
+        }
+        g_currentGeneration = 1;
+    }
+
+    if (!connectStartAndEndNode())
+    {
+        return result;
+    }
+
+    g_abstractOpenList.clear();
+    getAbstractSearchNode(g_startNodeIndex).gotoStartNodeWeight = 0;
+    getAbstractSearchNode(g_startNodeIndex).isClosed = true;
+    for (auto& edge : g_startEdgeList)
+    {
+        tryUpdateAbstractSearchNode(edge.targetNodeIndex, g_startNodeIndex, edge.weight);
+    }
+
+    while (!g_abstractOpenList.empty())
+    {
+        std::pop_heap(g_abstractOpenList.begin(), g_abstractOpenList.end(), std::greater<OpenListElement>());
+        int currentNodeIndex = g_abstractOpenList.back().second;
+        g_abstractOpenList.pop_back();
+
+        auto& currentSearchNode = getAbstractSearchNode(currentNodeIndex);
+        if (currentSearchNode.isClosed)
+        {
+            continue;
+        }
+        currentSearchNode.isClosed = true;
+
+        if (currentNodeIndex == g_endNodeIndex)
+        {
+            result = true;
+            break;
+        }
+
+        int gotoStartNodeWeight = currentSearchNode.gotoStartNodeWeight;
+        if (currentSearchNode.gotoEndNodeWeight != WEIGHT_INFINITE)
+        {
+            tryUpdateAbstractSearchNode(g_endNodeIndex, currentNodeIndex, gotoStartNodeWeight + currentSearchNode.gotoEndNodeWeight);
+        }
+
+        auto& currentNode = g_nodeList[currentNodeIndex];
+        if (currentNode.entranceNodeIndex != NODE_INDEX_INVALID)
+        {
+            tryUpdateAbstractSearchNode(currentNode.entranceNodeIndex, currentNodeIndex, gotoStartNodeWeight + MOVE_STRAIGHT_WEIGHT);
+        }
+
+        for (auto& edge : currentNode.intraEdgeList)
+        {
+            tryUpdateAbstractSearchNode(edge.targetNodeIndex, currentNodeIndex, gotoStartNodeWeight + edge.weight);
+        }
+    }
+
+    if (result)
+    {
+        g_abstractPathNodeIndexList.clear();
+        int nodeIndex = g_endNodeIndex;
+        while (nodeIndex != NODE_INDEX_INVALID)
+        {
+            g_abstractPathNodeIndexList.push_back(nodeIndex);
+            nodeIndex = g_abstractSearchNodeList[nodeIndex].parentNodeIndex;
+        }
+        std::reverse(g_abstractPathNodeIndexList.begin(), g_abstractPathNodeIndexList.end());
+    }
+
+    return result;
+}
+
+bool HierarchicalPathHelper::connectStartAndEndNode()
+{
+    int startClusterIndex = getClusterIndex(g_startTileNode->columnIndex, g_startTileNode->rowIndex);
+    computeLocalWeightsFrom(startClusterIndex, g_startTileNode->columnIndex, g_startTileNode->rowIndex);
+
+    g_startEdgeList.clear();
+    for (auto nodeIndex : g_clusterList[startClusterIndex].nodeIndexList)
+    {
+        auto& node = g_nodeList[nodeIndex];
+        int weight = getLocalWeight(startClusterIndex, node.columnIndex, node.rowIndex);
+        if (weight != WEIGHT_INFINITE)
+        {
+            AbstractEdge edge;
+            edge.targetNodeIndex = nodeIndex;
+            edge.weight = weight;
+            g_startEdgeList.push_back(edge);
+        }
+    }
+
+    // 移动代价是对称的，从终点出发算出的代价就是各过渡点到终点的代价
+    int endClusterIndex = getClusterIndex(g_endTileNode->columnIndex, g_endTileNode->rowIndex);
+    computeLocalWeightsFrom(endClusterIndex, g_endTileNode->columnIndex, g_endTileNode->rowIndex);
+
+    bool canReachEndNode = false;
+    for (auto nodeIndex : g_clusterList[endClusterIndex].nodeIndexList)
+    {
+        auto& node = g_nodeList[nodeIndex];
+        int weight = getLocalWeight(endClusterIndex, node.columnIndex, node.rowIndex);
+        if (weight != WEIGHT_INFINITE)
+        {
+            getAbstractSearchNode(nodeIndex).gotoEndNodeWeight = weight;
+            canReachEndNode = true;
+        }
+    }
+
+    return !g_startEdgeList.empty() && canReachEndNode;
+}
+
+AbstractSearchNode& HierarchicalPathHelper::getAbstractSearchNode(int nodeIndex)
+{
+    auto& searchNode = g_abstractSearchNodeList[nodeIndex];
+    if (searchNode.generation != g_currentGeneration)
+    {
+        searchNode.generation = g_currentGeneration;
+        searchNode.gotoStartNodeWeight = WEIGHT_INFINITE;
+        searchNode.gotoEndNodeWeight = WEIGHT_INFINITE;
+        searchNode.parentNodeIndex = NODE_INDEX_INVALID;
+        searchNode.isClosed = false;
+    }
+
+    return searchNode;
+}
+
+void HierarchicalPathHelper::tryUpdateAbstractSearchNode(int nodeIndex, int parentNodeIndex, int newGotoStartNodeWeight)
+{
+    auto& searchNode = getAbstractSearchNode(nodeIndex);
+    if (searchNode.isClosed || newGotoStartNodeWeight >= searchNode.gotoStartNodeWeight)
+    {
+        return;
+    }
+
+    searchNode.gotoStartNodeWeight = newGotoStartNodeWeight;
+    searchNode.parentNodeIndex = parentNodeIndex;
+
+    // 开放列表不支持更新键值，旧的元素在弹出时根据isClosed跳过
+    int sumWeight = newGotoStartNodeWeight;
+    if (nodeIndex != g_endNodeIndex)
+    {
+        auto& node = g_nodeList[nodeIndex];
+        sumWeight += computeWeightBetween(node.columnIndex, node.rowIndex, g_endTileNode->columnIndex, g_endTileNode->rowIndex);
+    }
+
+    g_abstractOpenList.push_back(OpenListElement(sumWeight, nodeIndex));
+    std::push_heap(g_abstractOpenList.begin(), g_abstractOpenList.end(), std::greater<OpenListElement>());
+}
+
+TileNode* HierarchicalPathHelper::getAbstractNodeTileNode(int nodeIndex)
+{
+    if (nodeIndex == g_startNodeIndex)
+    {
+        return g_startTileNode;
+    }
+
+    if (nodeIndex == g_endNodeIndex)
+    {
+        return g_endTileNode;
+    }
+
+    auto& node = g_nodeList[nodeIndex];
+    return &g_navigationGrid->tileNodeList[node.columnIndex * g_maxRowCount + node.rowIndex];
+}
+
+list<TileNode*> HierarchicalPathHelper::refineAbstractPath()
+{
+    // 返回的路径与AutoFindPathHelper一致，从终点排到起点
+    list<TileNode*> pathList;
+    pathList.push_front(g_startTileNode);
+
+    for (int pathIndex = 0; pathIndex + 1 < (int)g_abstractPathNodeIndexList.size(); pathIndex++)
+    {
+        auto fromTileNode = getAbstractNodeTileNode(g_abstractPathNodeIndexList[pathIndex]);
+        auto toTileNode = getAbstractNodeTileNode(g_abstractPathNodeIndexList[pathIndex + 1]);
+        if (fromTileNode == toTileNode)
+        {
+            continue;
+        }
+
+        int clusterIndex = getClusterIndex(fromTileNode->columnIndex, fromTileNode->rowIndex);
+        if (clusterIndex != getClusterIndex(toTileNode->columnIndex, toTileNode->rowIndex))
+        {
+            // 跨越区块边界的两个过渡点本身就是相邻格子
+            pathList.push_front(toTileNode);
+            continue;
+        }
+
+        // 同一区块内的路段只在区块范围内寻路
+        auto& cluster = g_clusterList[clusterIndex];
+        auto segmentPathList = AutoFindPathHelper::computeTileNodePathListInArea(fromTileNode, toTileNode,
+            cluster.minColumnIndex, cluster.minRowIndex, cluster.maxColumnIndex, cluster.maxRowIndex,
+            g_isEndTileNodePassable && toTileNode == g_endTileNode);
+        if (segmentPathList.empty())
+        {
+            return AutoFindPathHelper::computeTileNodePathListBetween(g_startTileNode, g_endTileNode, g_isEndTileNodePassable);
+        }
+
+        segmentPathList.pop_back();
+        for (auto iter = segmentPathList.rbegin(); iter != segmentPathList.rend(); ++iter)
+        {
+            pathList.push_front(*iter);
+        }
+    }
+
+    return pathList;
+}
+
+int HierarchicalPathHelper::getClusterIndex(int columnIndex, int rowIndex)
+{
+    return (columnIndex / PATH_CLUSTER_SIZE) * g_clusterRowCount + rowIndex / PATH_CLUSTER_SIZE;
+}
+
+bool HierarchicalPathHelper::isPassable(int columnIndex, int rowIndex)
+{
+    return g_navigationGrid->passableList[columnIndex * g_maxRowCount + rowIndex];
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+const int PATH_CLUSTER_SIZE = 10;   // 区块的边长（格子数）
+const int HIERARCHICAL_SEARCH_MIN_TILE_DISTANCE = PATH_CLUSTER_SIZE * 2;   // 起点终点距离小于这个值时直接在格子上寻路
+
+struct AbstractSearchNode;
+
+class HierarchicalPathHelper
+{
+public:
+    static void initNavigationGrid(NavigationGrid& navigationGrid);
+    static list<TileNode*> computeTileNodePathListBetween(TileNode* startNode, TileNode* endNode, bool isEndTileNodePassable = false);
+    // 只在抽象图上搜索，不细化：按顺序返回路径进入每个区块时经过的过渡点，不包含起点和终点，由调用者逐段细化；
+    // 距离太近或者抽象图上找不到路径时返回false
+    static bool computeWaypointList(TileNode* startNode, TileNode* endNode, vector<TileNode*>& waypointList);
+
+    static void onTileNodesGIDChanged(const vector<TileNode*>& tileNodeList);
+
+private:
+    static void initClusterList();
+    static void rebuildClusters(const set<int>& clusterIndexSet);
+
+    static void buildBorderEntrances(int borderIndex);
+    static void removeBorderEntrances(int borderIndex);
+    static void addEntrance(int columnIndex, int rowIndex, int besideColumnIndex, int besideRowIndex, int borderIndex);
+    static int createAbstractNode(int columnIndex, int rowIndex);
+    static void buildIntraEdges(int clusterIndex);
+
+    static void computeLocalWeightsFrom(int clusterIndex, int columnIndex, int rowIndex);
+    static int getLocalWeight(int clusterIndex, int columnIndex, int rowIndex);
+
+    static bool searchAbstractPath(TileNode* startNode, TileNode* endNode);
+    static bool connectStartAndEndNode();
+    static AbstractSearchNode& getAbstractSearchNode(int nodeIndex);
+    static void tryUpdateAbstractSearchNode(int nodeIndex, int parentNodeIndex, int newGotoStartNodeWeight);
+    static TileNode* getAbstractNodeTileNode(int nodeIndex);
+    static list<TileNode*> refineAbstractPath();
+
+    static int getClusterIndex(int columnIndex, int rowIndex);
+    static bool isPassable(int columnIndex, int rowIndex);
+
+    HierarchicalPathHelper();
+    ~HierarchicalPathHelper();
+};
@@ -0,0 +1,380 @@
+#include "Base.h"
+#include "MapManager.h"
+#include "AutoFindPathHelper.h"
+#include "IncrementalPathPlanner.h"
+
+const int HEAP_INDEX_INVALID = -1;
+const int WEIGHT_INFINITE = INT_MAX / 2;    // 留出余量，加上移动代价和启发值以后不会溢出
+
+static NavigationGrid* g_navigationGrid = nullptr;
+static int g_maxColumnCount = 0;
+static int g_maxRowCount = 0;
+
+static vector<IncrementalPathPlanner*> g_plannerList;
+
+static int computeWeightBetween(int fromTileIndex, int toTileIndex)
+{
+    int rowDistance = std::abs(toTileIndex % g_maxRowCount - fromTileIndex % g_maxRowCount);
+    int columnDistance = std::abs(toTileIndex / g_maxRowCount - fromTileIndex / g_maxRowCount);
+    int slopStepCount = std::min(rowDistance, columnDistance);
+    int straightStepCount = std::max(rowDistance, columnDistance) - slopStepCount;
+
+    return slopStepCount * MOVE_SLOP_WEIGHT + straightStepCount * MOVE_STRAIGHT_WEIGHT;
+}
+
+static int addWeight(int weight, int moveWeight)
+{
+    return weight >= WEIGHT_INFINITE ? WEIGHT_INFINITE : weight + moveWeight;
+}
+
+void IncrementalPathPlanner::initNavigationGrid(NavigationGrid& navigationGrid)
+{
+    g_navigationGrid = &navigationGrid;
+    g_maxColumnCount = navigationGrid.columnCount;
+    g_maxRowCount = navigationGrid.rowCount;
+
+    // 旧地图上的搜索结果已经没有意义，下次寻路时重新搜索
+    for (auto planner : g_plannerList)
+    {
+        planner->_isSearchInitialized = false;
+    }
+}
+
+void IncrementalPathPlanner::onTileNodesGIDChanged(const vector<TileNode*>& tileNodeList)
+{
+    for (auto planner : g_plannerList)
+    {
+        if (!planner->_isSearchInitialized)
+        {
+            continue;
+        }
+
+        for (auto tileNode : tileNodeList)
+        {
+            planner->_changedTileIndexList.push_back(tileNode->columnIndex * g_maxRowCount + tileNode->rowIndex);
+        }
+    }
+}
+
+IncrementalPathPlanner::IncrementalPathPlanner(TileNode* endNode, bool isEndTileNodePassable)
+{
+    _endNode = endNode;
+    _endTileIndex = endNode->columnIndex * g_maxRowCount + endNode->rowIndex;
+    _isEndTileNodePassable = isEndTileNodePassable;
+
+    g_plannerList.push_back(this);
+}
+
+IncrementalPathPlanner::~IncrementalPathPlanner()
+{
+    g_plannerList.erase(std::remove(g_plannerList.begin(), g_plannerList.end(), this), g_plannerList.end());
+}
+
+list<TileNode*> IncrementalPathPlanner::computeTileNodePathListFrom(TileNode* startNode)
+{
+    _expandedNodeCount = 0;
+    _startTileIndex = startNode->columnIndex * g_maxRowCount + startNode->rowIndex;
+
+    if (!_isSearchInitialized)
+    {
+        initSearch();
+    }
+    else
+    {
+        _keyModifier += computeWeightBetween(_lastStartTileIndex, _startTileIndex);
+
+        // 格子通行状态改变只影响走进这个格子的代价，因此需要更新的是它周围的格子
+        for (auto changedTileIndex : _changedTileIndexList)
+        {
+            updateNodesBeside(changedTileIndex);
+        }
+        _changedTileIndexList.clear();
+    }
+    _lastStartTileIndex = _startTileIndex;
+
+    computeShortestPath();
+
+    return getPathList();
+}
+
+TileNode* IncrementalPathPlanner::getEndTileNode()
+{
+    return _endNode;
+}
+
+bool IncrementalPathPlanner::isEndTileNodePassable()
+{
+    return _isEndTileNodePassable;
+}
+
+int IncrementalPathPlanner::getLastExpandedNodeCount()
+{
+    return _expandedNodeCount;
+}
+
+void IncrementalPathPlanner::initSearch()
+{
+    int tileCount = g_maxColumnCount * g_maxRowCount;
+    _gotoEndNodeWeightList.assign(tileCount, WEIGHT_INFINITE);
+    _lookAheadWeightList.assign(tileCount, WEIGHT_INFINITE);
+    _keyList.assign(tileCount, PlannerKey(WEIGHT_INFINITE, WEIGHT_INFINITE));
+    _heapIndexList.assign(tileCount, HEAP_INDEX_INVALID);
+    _openHeap.clear();
+    _changedTileIndexList.clear();
+    _keyModifier = 0;
+
+    _lookAheadWeightList[_endTileIndex] = 0;
+    pushToOpenList(_endTileIndex, computeKey(_endTileIndex));
+
+    _isSearchInitialized = true;
+}
+
+void IncrementalPathPlanner::computeShortestPath()
+{
+    while (!_openHeap.empty() &&
+        (_keyList[_openHeap.front()] < computeKey(_startTileIndex) ||
+        _lookAheadWeightList[_startTileIndex] != _gotoEndNodeWeightList[_startTileIndex]))
+    {
+        int tileIndex = _openHeap.front();
+        auto oldKey = _keyList[tileIndex];
+        auto newKey = computeKey(tileIndex);
+        _expandedNodeCount++;
+
+        if (oldKey < newKey)
+        {
+            // 起点移动以后旧的优先级偏小，更新后放回开放列表
+            _keyList[tileIndex] = newKey;
+            siftDown(0);
+        }
+        else if (_gotoEndNodeWeightList[tileIndex] > _lookAheadWeightList[tileIndex])
+        {
+            _gotoEndNodeWeightList[tileIndex] = _lookAheadWeightList[tileIndex];
+            removeFromOpenList(tileIndex);
+            updateNodesBeside(tileIndex);
+        }
+        else
+        {
+            _gotoEndNodeWeightList[tileIndex] = WEIGHT_INFINITE;
+            updateNodesBeside(tileIndex);
+            updateNode(tileIndex);
+        }
+    }
+}
+
+list<TileNode*> IncrementalPathPlanner::getPathList()
+{
+    list<TileNode*> pathList;
+    if (_gotoEndNodeWeightList[_startTileIndex] >= WEIGHT_INFINITE)
+    {
+        return pathList;
+    }
+
+    // 从起点开始，每一步都走向代价最小的相邻格子
+    int tileIndex = _startTileIndex;
+    pathList.push_front(&g_navigationGrid->tileNodeList[tileIndex]);
+    while (tileIndex != _endTileIndex && (int)pathList.size() <= (int)_gotoEndNodeWeightList.size())
+    {
+        int columnIndex = tileIndex / g_maxRowCount;
+        int rowIndex = tileIndex % g_maxRowCount;
+        int nextTileIndex = tileIndex;
+        int minWeight = WEIGHT_INFINITE;
+
+        for (int besideColumnIndex = std::max(columnIndex - 1, 0); besideColumnIndex <= std::min(columnIndex + 1, g_maxColumnCount - 1); besideColumnIndex++)
+        {
+            for (int besideRowIndex = std::max(rowIndex - 1, 0); besideRowIndex <= std::min(rowIndex + 1, g_maxRowCount - 1); besideRowIndex++)
+            {
+                int besideTileIndex = besideColumnIndex * g_maxRowCount + besideRowIndex;
+                if (besideTileIndex == tileIndex || !isPassable(besideTileIndex))
+                {
+                    continue;
+                }
+
+                int moveWeight = (besideColumnIndex != columnIndex && besideRowIndex != rowIndex) ? MOVE_SLOP_WEIGHT : MOVE_STRAIGHT_WEIGHT;
+                int weight = addWeight(_gotoEndNodeWeightList[besideTileIndex], moveWeight);
+                if (weight < minWeight)
+                {
+                    minWeight = weight;
+                    nextTileIndex = besideTileIndex;
+                }
+            }
+        }
+
+        if (nextTileIndex == tileIndex)
+        {
+            pathList.clear();
+            break;
+        }
+
+        tileIndex = nextTileIndex;
+        pathList.push_front(&g_navigationGrid->tileNodeList[tileIndex]);
+    }
+
+    if (tileIndex != _endTileIndex)
+    {
+        pathList.clear();
+    }
+
+    return pathList;
+}
+
+void IncrementalPathPlanner::updateNode(int tileIndex)
+{
+    if (tileIndex != _endTileIndex)
+    {
+        _lookAheadWeightList[tileIndex] = computeLookAheadWeight(tileIndex);
+    }
+
+    if (isInOpenList(tileIndex))
+    {
+        removeFromOpenList(tileIndex);
+    }
+
+    if (_gotoEndNodeWeightList[tileIndex] != _lookAheadWeightList[tileIndex])
+    {
+        pushToOpenList(tileIndex, computeKey(tileIndex));
+    }
+}
+
+void IncrementalPathPlanner::updateNodesBeside(int tileIndex)
+{
+    int columnIndex = tileIndex / g_maxRowCount;
+    int rowIndex = tileIndex % g_maxRowCount;
+
+    for (int besideColumnIndex = std::max(columnIndex - 1, 0); besideColumnIndex <= std::min(columnIndex + 1, g_maxColumnCount - 1); besideColumnIndex++)
+    {
+        for (int besideRowIndex = std::max(rowIndex - 1, 0); besideRowIndex <= std::min(rowIndex + 1, g_maxRowCount - 1); besideRowIndex++)
+        {
+            int besideTileIndex = besideColumnIndex * g_maxRowCount + besideRowIndex;
+            if (besideTileIndex != tileIndex)
+            {
+                updateNode(besideTileIndex);
+            }
+        }
+    }
+}
+
+int IncrementalPathPlanner::computeLookAheadWeight(int tileIndex)
+{
+    // 移动规则与AutoFindPathHelper相同，只有走进的格子需要可以通行
+    int minWeight = WEIGHT_INFINITE;
+    int columnIndex = tileIndex / g_maxRowCount;
+    int rowIndex = tileIndex % g_maxRowCount;
+
+    for (int besideColumnIndex = std::max(columnIndex - 1, 0); besideColumnIndex <= std::min(columnIndex + 1, g_maxColumnCount - 1); besideColumnIndex++)
+    {
+        for (int besideRowIndex = std::max(rowIndex - 1, 0); besideRowIndex <= std::min(rowIndex + 1, g_maxRowCount - 1); besideRowIndex++)
+        {
+            int besideTileIndex = besideColumnIndex * g_maxRowCount + besideRowIndex;
+            if (besideTileIndex == tileIndex || !isPassable(besideTileIndex))
+            {
+                continue;
+            }
+
+            int moveWeight = (besideColumnIndex != columnIndex && besideRowIndex != rowIndex) ? MOVE_SLOP_WEIGHT : MOVE_STRAIGHT_WEIGHT;
+            minWeight = std::min(minWeight, addWeight(_gotoEndNodeWeightList[besideTileIndex], moveWeight));
+        }
+    }
+
+    return minWeight;
+}
+
+PlannerKey IncrementalPathPlanner::computeKey(int tileIndex)
+{
+    int weight = std::min(_gotoEndNodeWeightList[tileIndex], _lookAheadWeightList[tileIndex]);
+    return PlannerKey(addWeight(weight, computeWeightBetween(_startTileIndex, tileIndex) + _keyModifier), weight);
+}
+
+bool IncrementalPathPlanner::isPassable(int tileIndex)
+{
+    if (tileIndex == _endTileIndex && _isEndTileNodePassable)
+    {
+        return true;
+    }
+
+    return g_navigationGrid->passableList[tileIndex];
+}
+
+bool IncrementalPathPlanner::isInOpenList(int tileIndex)
+{
+    return _heapIndexList[tileIndex] != HEAP_INDEX_INVALID;
+}
+
+void IncrementalPathPlanner::pushToOpenList(int tileIndex, const PlannerKey& key)
+{
+    _keyList[tileIndex] = key;
+    _openHeap.push_back(tileIndex);
+
+    int heapIndex = (int)_openHeap.size() - 1;
+    _heapIndexList[tileIndex] = heapIndex;
+    siftUp(heapIndex);
+}
+
+void IncrementalPathPlanner::removeFromOpenList(int tileIndex)
+{
+    int heapIndex = _heapIndexList[tileIndex];
+    int lastHeapIndex = (int)_openHeap.size() - 1;
+
+    swapHeapElement(heapIndex, lastHeapIndex);
+    _openHeap.pop_back();
+    _heapIndexList[tileIndex] = HEAP_INDEX_INVALID;
+
+    if (heapIndex < lastHeapIndex)
+    {
+        siftUp(heapIndex);
+        siftDown(heapIndex);
+    }
+}
+
+void IncrementalPathPlanner::siftUp(int heapIndex)
+{
+    while (heapIndex > 0)
+    {
+        int parentHeapIndex = (heapIndex - 1) / 2;
+        if (!(_keyList[_openHeap[heapIndex]] < _keyList[_openHeap[parentHeapIndex]]))
+        {
+            break;
+        }
+
+        swapHeapElement(heapIndex, parentHeapIndex);
+        heapIndex = parentHeapIndex;
+    }
+}
+
+void IncrementalPathPlanner::siftDown(int heapIndex)
+{
+    int heapSize = (int)_openHeap.size();
+    while (true)
+    {
+        int leftChildHeapIndex = heapIndex * 2 + 1;
+        int rightChildHeapIndex = leftChildHeapIndex + 1;
+        int highestPriorityHeapIndex = heapIndex;
+
+        if (leftChildHeapIndex < heapSize &&
+            _keyList[_openHeap[leftChildHeapIndex]] < _keyList[_openHeap[highestPriorityHeapIndex]])
+        {
+            highestPriorityHeapIndex = leftChildHeapIndex;
+        }
+
+        if (rightChildHeapIndex < heapSize &&
+            _keyList[_openHeap[rightChildHeapIndex]] < _keyList[_openHeap[highestPriorityHeapIndex]])
+        {
+            highestPriorityHeapIndex = rightChildHeapIndex;
+        }
+
+        if (highestPriorityHeapIndex == heapIndex)
+        {
+            break;
+        }
+
+        swapHeapElement(heapIndex, highestPriorityHeapIndex);
+        heapIndex = highestPriorityHeapIndex;
+    }
+}
+
+void IncrementalPathPlanner::swapHeapElement(int leftHeapIndex, int rightHeapIndex)
+{
+    std::swap(_openHeap[leftHeapIndex], _openHeap[rightHeapIndex]);
+
+    _heapIndexList[_openHeap[leftHeapIndex]] = leftHeapIndex;
+    _heapIndexList[_openHeap[rightHeapIndex]] = rightHeapIndex;
+}
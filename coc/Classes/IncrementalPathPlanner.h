@@ -0,0 +1,58 @@
+#pragma once
+
+typedef pair<int, int> PlannerKey;  // D* Lite的优先级，先比较first再比较second
+
+// D* Lite增量寻路，从终点往起点搜索，因此npc沿路移动时不需要重新搜索，
+// 格子的通行状态改变后也只修复受影响的部分
+class IncrementalPathPlanner
+{
+public:
+    static void initNavigationGrid(NavigationGrid& navigationGrid);
+    static void onTileNodesGIDChanged(const vector<TileNode*>& tileNodeList);
+
+    IncrementalPathPlanner(TileNode* endNode, bool isEndTileNodePassable);
+    ~IncrementalPathPlanner();
+
+    // 第一次调用时完整搜索一次，之后只处理上次调用以来改变过的格子，返回的路径格式与AutoFindPathHelper一致
+    list<TileNode*> computeTileNodePathListFrom(TileNode* startNode);
+
+    TileNode* getEndTileNode();
+    bool isEndTileNodePassable();
+    int getLastExpandedNodeCount();
+
+private:
+    void initSearch();
+    void computeShortestPath();
+    list<TileNode*> getPathList();
+
+    void updateNode(int tileIndex);
+    void updateNodesBeside(int tileIndex);
+    int computeLookAheadWeight(int tileIndex);
+    PlannerKey computeKey(int tileIndex);
+    bool isPassable(int tileIndex);
+
+    bool isInOpenList(int tileIndex);
+    void pushToOpenList(int tileIndex, const PlannerKey& key);
+    void removeFromOpenList(int tileIndex);
+    void siftUp(int heapIndex);
+    void siftDown(int heapIndex);
+    void swapHeapElement(int leftHeapIndex, int rightHeapIndex);
+
+    TileNode* _endNode = nullptr;
+    int _endTileIndex = 0;
+    bool _isEndTileNodePassable = false;
+
+    int _startTileIndex = 0;
+    int _lastStartTileIndex = 0;
+    int _keyModifier = 0;       // 起点移动后累加的启发值修正，避免重排开放列表
+    bool _isSearchInitialized = false;
+
+    vector<int> _gotoEndNodeWeightList;     // g
+    vector<int> _lookAheadWeightList;       // rhs
+    vector<PlannerKey> _keyList;
+    vector<int> _heapIndexList;
+    vector<int> _openHeap;
+
+    vector<int> _changedTileIndexList;      // 上次寻路以来通行状态改变过的格子
+    int _expandedNodeCount = 0;
+};
@@ -0,0 +1,275 @@
+#include "Base.h"
+#include "MapManager.h"
+#include "AutoFindPathHelper.h"
+#include "LandmarkHelper.h"
+#include <memory>
+#include <queue>
+
+struct Landmark
+{
+    std::shared_ptr<const LandmarkDistanceTable> distanceTable;
+    bool isStale = false;
+};
+
+typedef pair<int, int> OpenListElement;     // <weight, tileIndex>
+
+static NavigationGrid* g_navigationGrid = nullptr;
+static int g_maxColumnCount = 0;
+static int g_maxRowCount = 0;
+
+static vector<Landmark> g_landmarkList;
+static std::shared_ptr<const LandmarkTableSet> g_landmarkTableSet;
+static vector<OpenListElement> g_openList;
+static bool g_isEnabled = true;
+static int g_rebuildCount = 0;
+
+void LandmarkHelper::initNavigationGrid(NavigationGrid& navigationGrid)
+{
+    g_navigationGrid = &navigationGrid;
+    g_maxColumnCount = navigationGrid.columnCount;
+    g_maxRowCount = navigationGrid.rowCount;
+
+    g_landmarkList.clear();
+    g_openList.clear();
+    g_rebuildCount = 0;
+
+    selectLandmarks();
+    publishLandmarkTableSet();
+}
+
+void LandmarkHelper::update()
+{
+    // 过期的距离表不再参与寻路，重新计算完一张就立即发布，不会在一帧内集中计算所有路标
+    for (auto& landmark : g_landmarkList)
+    {
+        if (landmark.isStale)
+        {
+            auto distanceTable = std::make_shared<LandmarkDistanceTable>();
+            distanceTable->landmarkTileIndex = findPassableTileIndexNear(landmark.distanceTable->landmarkTileIndex);
+            buildDistanceList(distanceTable->landmarkTileIndex, distanceTable->distanceList);
+
+            landmark.distanceTable = distanceTable;
+            landmark.isStale = false;
+            g_rebuildCount++;
+
+            publishLandmarkTableSet();
+            break;
+        }
+    }
+}
+
+void LandmarkHelper::onTileNodesGIDChanged(const vector<TileNode*>& tileNodeList)
+{
+    // 障碍格的增减会让到路标的代价变大或者变小，旧的差值可能高估实际代价，所有距离表都要重新计算
+    for (auto& landmark : g_landmarkList)
+    {
+        landmark.isStale = true;
+    }
+
+    publishLandmarkTableSet();
+}
+
+std::shared_ptr<const LandmarkTableSet> LandmarkHelper::getLandmarkTableSet()
+{
+    return g_isEnabled ? g_landmarkTableSet : nullptr;
+}
+
+void LandmarkHelper::setEnabled(bool isEnabled)
+{
+    g_isEnabled = isEnabled;
+}
+
+bool LandmarkHelper::isEnabled()
+{
+    return g_isEnabled;
+}
+
+int LandmarkHelper::getValidLandmarkCount()
+{
+    return g_landmarkTableSet ? (int)g_landmarkTableSet->tableList.size() : 0;
+}
+
+int LandmarkHelper::getRebuildCount()
+{
+    return g_rebuildCount;
+}
+
+void LandmarkHelper::selectLandmarks()
+{
+    int seedTileIndex = findLargestComponentTileIndex();
+    if (seedTileIndex < 0)
+    {
+        return;
+    }
+
+    // 每次选出离已有路标最远的格子，第一个路标是离种子格子最远的格子，路标因此分散在最大连通区域的边缘
+    vector<int> nearestLandmarkDistanceList;
+    buildDistanceList(seedTileIndex, nearestLandmarkDistanceList);
+
+    for (int landmarkIndex = 0; landmarkIndex < LANDMARK_COUNT; landmarkIndex++)
+    {
+        int landmarkTileIndex = -1;
+        int maxDistance = 0;
+        for (int tileIndex = 0; tileIndex < (int)nearestLandmarkDistanceList.size(); tileIndex++)
+        {
+            int distance = nearestLandmarkDistanceList[tileIndex];
+            if (distance != LANDMARK_DISTANCE_INFINITE && distance > maxDistance)
+            {
+                maxDistance = distance;
+                landmarkTileIndex = tileIndex;
+            }
+        }
+
+        if (landmarkTileIndex < 0)
+        {
+            break;
+        }
+
+        auto distanceTable = std::make_shared<LandmarkDistanceTable>();
+        distanceTable->landmarkTileIndex = landmarkTileIndex;
+        buildDistanceList(landmarkTileIndex, distanceTable->distanceList);
+        for (int tileIndex = 0; tileIndex < (int)nearestLandmarkDistanceList.size(); tileIndex++)
+        {
+            nearestLandmarkDistanceList[tileIndex] = std::min(nearestLandmarkDistanceList[tileIndex], distanceTable->distanceList[tileIndex]);
+        }
+
+        Landmark landmark;
+        landmark.distanceTable = distanceTable;
+        g_landmarkList.push_back(landmark);
+    }
+}
+
+int LandmarkHelper::findLargestComponentTileIndex()
+{
+    int largestComponentTileIndex = -1;
+    int largestComponentTileCount = 0;
+
+    auto& passableList = g_navigationGrid->passableList;
+    vector<bool> isVisitedList(passableList.size(), false);
+    vector<int> tileIndexQueue;
+    tileIndexQueue.reserve(passableList.size());
+    for (int tileIndex = 0; tileIndex < (int)passableList.size(); tileIndex++)
+    {
+        if (!passableList[tileIndex] || isVisitedList[tileIndex])
+        {
+            continue;
+        }
+
+        tileIndexQueue.clear();
+        tileIndexQueue.push_back(tileIndex);
+        isVisitedList[tileIndex] = true;
+        for (int queueIndex = 0; queueIndex < (int)tileIndexQueue.size(); queueIndex++)
+        {
+            int columnIndex = tileIndexQueue[queueIndex] / g_maxRowCount;
+            int rowIndex = tileIndexQueue[queueIndex] % g_maxRowCount;
+            for (int besideColumnIndex = max(columnIndex - 1, 0); besideColumnIndex <= min(columnIndex + 1, g_maxColumnCount - 1); besideColumnIndex++)
+            {
+                for (int besideRowIndex = max(rowIndex - 1, 0); besideRowIndex <= min(rowIndex + 1, g_maxRowCount - 1); besideRowIndex++)
+                {
+                    int besideTileIndex = besideColumnIndex * g_maxRowCount + besideRowIndex;
+                    if (passableList[besideTileIndex] && !isVisitedList[besideTileIndex])
+                    {
+                        isVisitedList[besideTileIndex] = true;
+                        tileIndexQueue.push_back(besideTileIndex);
+                    }
+                }
+            }
+        }
+
+        if ((int)tileIndexQueue.size() > largestComponentTileCount)
+        {
+            largestComponentTileCount = (int)tileIndexQueue.size();
+            largestComponentTileIndex = tileIndex;
+        }
+    }
+
+    return largestComponentTileIndex;
+}
+
+int LandmarkHelper::findPassableTileIndexNear(int tileIndex)
+{
+    int columnIndex = tileIndex / g_maxRowCount;
+    int rowIndex = tileIndex % g_maxRowCount;
+    for (int range = 0; range <= LANDMARK_RELOCATE_RANGE; range++)
+    {
+        for (int besideColumnIndex = max(columnIndex - range, 0); besideColumnIndex <= min(columnIndex + range, g_maxColumnCount - 1); besideColumnIndex++)
+        {
+            for (int besideRowIndex = max(rowIndex - range, 0); besideRowIndex <= min(rowIndex + range, g_maxRowCount - 1); besideRowIndex++)
+            {
+                int besideTileIndex = besideColumnIndex * g_maxRowCount + besideRowIndex;
+                if (g_navigationGrid->passableList[besideTileIndex])
+                {
+                    return besideTileIndex;
+                }
+            }
+        }
+    }
+
+    // 附近都是障碍，距离表全部不连通，这个路标不提供任何信息
+    return tileIndex;
+}
+
+void LandmarkHelper::buildDistanceList(int sourceTileIndex, vector<int>& distanceList)
+{
+    auto& passableList = g_navigationGrid->passableList;
+    distanceList.assign(passableList.size(), LANDMARK_DISTANCE_INFINITE);
+    if (!passableList[sourceTileIndex])
+    {
+        return;
+    }
+
+    // 移动规则与AutoFindPathHelper一致：八方向，只能经过可通行的格子
+    distanceList[sourceTileIndex] = 0;
+    g_openList.clear();
+    g_openList.push_back(OpenListElement(0, sourceTileIndex));
+    while (!g_openList.empty())
+    {
+        std::pop_heap(g_openList.begin(), g_openList.end(), std::greater<OpenListElement>());
+        auto openListElement = g_openList.back();
+        g_openList.pop_back();
+
+        int tileIndex = openListElement.second;
+        if (openListElement.first > distanceList[tileIndex])
+        {
+            continue;
+        }
+
+        int columnIndex = tileIndex / g_maxRowCount;
+        int rowIndex = tileIndex % g_maxRowCount;
+        for (int besideColumnIndex = max(columnIndex - 1, 0); besideColumnIndex <= min(columnIndex + 1, g_maxColumnCount - 1); besideColumnIndex++)
+        {
+            for (int besideRowIndex = max(rowIndex - 1, 0); besideRowIndex <= min(rowIndex + 1, g_maxRowCount - 1); besideRowIndex++)
+            {
+                int besideTileIndex = besideColumnIndex * g_maxRowCount + besideRowIndex;
+                if (!passableList[besideTileIndex])
+                {
+                    continue;
+                }
+
+                int moveWeight = (besideColumnIndex != columnIndex && besideRowIndex != rowIndex) ? MOVE_SLOP_WEIGHT : MOVE_STRAIGHT_WEIGHT;
+                int distance = openListElement.first + moveWeight;
+                if (distance < distanceList[besideTileIndex])
+                {
+                    distanceList[besideTileIndex] = distance;
+                    g_openList.push_back(OpenListElement(distance, besideTileIndex));
+                    std::push_heap(g_openList.begin(), g_openList.end(), std::greater<OpenListElement>());
+                }
+            }
+        }
+    }
+}
+
+void LandmarkHelper::publishLandmarkTableSet()
+{
+    // 已经发布的集合可能还在被工作线程使用，每次都发布新的集合，旧集合在不再被引用时自动释放
+    auto landmarkTableSet = std::make_shared<LandmarkTableSet>();
+    for (auto& landmark : g_landmarkList)
+    {
+        if (!landmark.isStale)
+        {
+            landmarkTableSet->tableList.push_back(landmark.distanceTable);
+        }
+    }
+
+    g_landmarkTableSet = landmarkTableSet;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+const int LANDMARK_COUNT = 8;
+const int LANDMARK_DISTANCE_INFINITE = INT_MAX;
+const int LANDMARK_RELOCATE_RANGE = 3;     // 路标格子变成障碍时，在这个范围内找一个可通行的格子代替
+
+struct LandmarkDistanceTable
+{
+    int landmarkTileIndex = 0;
+    vector<int> distanceList;   // 从路标出发到每个格子的最短代价，不连通的格子为LANDMARK_DISTANCE_INFINITE
+};
+
+// 与当前格子状态一致的距离表，发布以后不再修改，工作线程可以和主线程同时读取
+struct LandmarkTableSet
+{
+    vector<std::shared_ptr<const LandmarkDistanceTable>> tableList;
+};
+
+// ALT启发值：关卡加载时选出几个分散的路标格子，预先计算它们到所有格子的最短代价，
+// 由三角不等式，任意两个格子到同一路标的代价之差不会超过它们之间的实际代价，绕开大片建筑物时比对角线距离紧得多
+class LandmarkHelper
+{
+public:
+    static void initNavigationGrid(NavigationGrid& navigationGrid);
+    static void update();   // 每帧调用一次，最多重新计算一张过期的距离表
+    static void onTileNodesGIDChanged(const vector<TileNode*>& tileNodeList);
+
+    // 没有开启时返回空指针
+    static std::shared_ptr<const LandmarkTableSet> getLandmarkTableSet();
+    static void setEnabled(bool isEnabled);
+    static bool isEnabled();
+
+    static int getValidLandmarkCount();
+    static int getRebuildCount();
+
+private:
+    static void selectLandmarks();
+    static int findLargestComponentTileIndex();
+    static int findPassableTileIndexNear(int tileIndex);
+    static void buildDistanceList(int sourceTileIndex, vector<int>& distanceList);
+    static void publishLandmarkTableSet();
+
+    LandmarkHelper();
+    ~LandmarkHelper();
+};
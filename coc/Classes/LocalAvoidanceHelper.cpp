@@ -0,0 +1,579 @@
+#include "Base.h"
+#include "MapManager.h"
+#include "LocalAvoidanceHelper.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+const float AVOIDANCE_EPSILON = 0.00001f;
+
+// 速度平面上的有向直线，允许的速度在direction的左侧
+struct AvoidanceLine
+{
+    Vec2 point;
+    Vec2 direction;
+};
+
+// 一次求解陆军或者空军时共用的数据，邻居在主线程中找好，工作线程只读，各自写不同agent的newVelocity
+struct AvoidanceLayer
+{
+    vector<AvoidanceAgent>* agentList = nullptr;
+    vector<int> movingAgentIndexList;
+    vector<vector<int>> neighborIndexLists;    // 与movingAgentIndexList一一对应
+    bool isAir = false;
+    float deltaTime = 0.0f;
+};
+
+static NavigationGrid* g_navigationGrid = nullptr;
+static int g_maxColumnCount = 0;
+static int g_maxRowCount = 0;
+static bool g_isAvailable = false;
+
+static Vec2 g_originPosition;
+static Vec2 g_columnAxis;
+static Vec2 g_rowAxis;
+static float g_determinant = 0.0f;
+
+// 工作线程常驻，每帧只唤醒一次；主线程也领取任务，全部完成以后才返回
+static vector<std::thread> g_workerThreadList;
+static std::mutex g_workerMutex;
+static std::condition_variable g_workerCondition;      // 有任务可以领取或者需要退出
+static std::condition_variable g_finishedCondition;    // 一层的所有任务都已经完成
+static AvoidanceLayer* g_solvingLayer = nullptr;       // 还有任务没有领取完的一层
+static int g_nextMovingIndex = 0;
+static int g_unfinishedAgentCount = 0;
+static bool g_isStopping = false;
+
+// 以下三个线性规划与RVO2库中的实现一致：
+// 在半径为maxSpeed的圆内找满足前lineIndex条约束、并且最接近optimizeVelocity的速度
+static bool linearProgram1(const vector<AvoidanceLine>& lineList, int lineIndex, float maxSpeed, const Vec2& optimizeVelocity,
+    bool isOptimizeDirection, Vec2& result)
+{
+    auto& line = lineList[lineIndex];
+    float dotProduct = line.point.dot(line.direction);
+    float discriminant = dotProduct * dotProduct + maxSpeed * maxSpeed - line.point.lengthSquared();
+    if (discriminant < 0.0f)
+    {
+        return false;
+    }
+
+    float sqrtDiscriminant = sqrtf(discriminant);
+    float leftT = -dotProduct - sqrtDiscriminant;
+    float rightT = -dotProduct + sqrtDiscriminant;
+    for (int index = 0; index < lineIndex; index++)
+    {
+        float denominator = line.direction.cross(lineList[index].direction);
+        float numerator = lineList[index].direction.cross(line.point - lineList[index].point);
+        if (fabs(denominator) <= AVOIDANCE_EPSILON)
+        {
+            // 两条约束平行，并且这条约束完全落在另一条的禁止区域内
+            if (numerator < 0.0f)
+            {
+                return false;
+            }
+
+            continue;
+        }
+
+        float t = numerator / denominator;
+        if (denominator >= 0.0f)
+        {
+            rightT = std::min(rightT, t);
+        }
+        else
+        {
+            leftT = std::max(leftT, t);
+        }
+
+        if (leftT > rightT)
+        {
+            return false;
+        }
+    }
+
+    if (isOptimizeDirection)
+    {
+        result = line.point + line.direction * (optimizeVelocity.dot(line.direction) > 0.0f ? rightT : leftT);
+    }
+    else
+    {
+        float t = line.direction.dot(optimizeVelocity - line.point);
+        result = line.point + line.direction * std::min(std::max(t, leftT), rightT);
+    }
+
+    return true;
+}
+
+// 返回第一条无法满足的约束的下标，全部满足时返回约束数量
+static int linearProgram2(const vector<AvoidanceLine>& lineList, float maxSpeed, const Vec2& optimizeVelocity, bool isOptimizeDirection, Vec2& result)
+{
+    if (isOptimizeDirection)
+    {
+        result = optimizeVelocity * maxSpeed;
+    }
+    else if (optimizeVelocity.lengthSquared() > maxSpeed * maxSpeed)
+    {
+        result = optimizeVelocity.getNormalized() * maxSpeed;
+    }
+    else
+    {
+        result = optimizeVelocity;
+    }
+
+    for (int lineIndex = 0; lineIndex < (int)lineList.size(); lineIndex++)
+    {
+        if (lineList[lineIndex].direction.cross(lineList[lineIndex].point - result) > 0.0f)
+        {
+            auto oldResult = result;
+            if (!linearProgram1(lineList, lineIndex, maxSpeed, optimizeVelocity, isOptimizeDirection, result))
+            {
+                result = oldResult;
+                return lineIndex;
+            }
+        }
+    }
+
+    return (int)lineList.size();
+}
+
+// 约束无解时（比如被围住），障碍格的约束必须满足，npc之间的约束按照违反程度最小的方式放宽
+static void linearProgram3(const vector<AvoidanceLine>& lineList, int obstacleLineCount, int beginLineIndex, float maxSpeed, Vec2& result)
+{
+    float distance = 0.0f;
+    vector<AvoidanceLine> projectedLineList;
+    for (int lineIndex = beginLineIndex; lineIndex < (int)lineList.size(); lineIndex++)
+    {
+        auto& line = lineList[lineIndex];
+        if (line.direction.cross(line.point - result) <= distance)
+        {
+            continue;
+        }
+
+        projectedLineList.assign(lineList.begin(), lineList.begin() + obstacleLineCount);
+        for (int otherLineIndex = obstacleLineCount; otherLineIndex < lineIndex; otherLineIndex++)
+        {
+            auto& otherLine = lineList[otherLineIndex];
+
+            AvoidanceLine projectedLine;
+            float determinant = line.direction.cross(otherLine.direction);
+            if (fabs(determinant) <= AVOIDANCE_EPSILON)
+            {
+                if (line.direction.dot(otherLine.direction) > 0.0f)
+                {
+                    continue;
+                }
+
+                projectedLine.point = (line.point + otherLine.point) * 0.5f;
+            }
+            else
+            {
+                projectedLine.point = line.point + line.direction * (otherLine.direction.cross(line.point - otherLine.point) / determinant);
+            }
+
+            projectedLine.direction = (otherLine.direction - line.direction).getNormalized();
+            projectedLineList.push_back(projectedLine);
+        }
+
+        auto oldResult = result;
+        if (linearProgram2(projectedLineList, maxSpeed, Vec2(-line.direction.y, line.direction.x), true, result) < (int)projectedLineList.size())
+        {
+            result = oldResult;
+        }
+
+        distance = line.direction.cross(line.point - result);
+    }
+}
+
+static float computeDistanceToSegment(const Vec2& position, const Vec2& startPosition, const Vec2& endPosition, Vec2& nearestPosition)
+{
+    auto segment = endPosition - startPosition;
+    float t = segment.lengthSquared() > 0.0f ? (position - startPosition).dot(segment) / segment.lengthSquared() : 0.0f;
+    nearestPosition = startPosition + segment * std::min(std::max(t, 0.0f), 1.0f);
+
+    return position.distance(nearestPosition);
+}
+
+void LocalAvoidanceHelper::initNavigationGrid(NavigationGrid& navigationGrid)
+{
+    clear();
+
+    g_navigationGrid = &navigationGrid;
+    g_maxColumnCount = navigationGrid.columnCount;
+    g_maxRowCount = navigationGrid.rowCount;
+
+    g_isAvailable = false;
+    if (g_maxColumnCount > 1 && g_maxRowCount > 1)
+    {
+        g_originPosition = navigationGrid.tileNodeList[0].leftTopPosition;
+        g_columnAxis = navigationGrid.tileNodeList[g_maxRowCount].leftTopPosition - g_originPosition;
+        g_rowAxis = navigationGrid.tileNodeList[1].leftTopPosition - g_originPosition;
+        g_determinant = g_columnAxis.cross(g_rowAxis);
+        g_isAvailable = (fabs(g_determinant) > AVOIDANCE_EPSILON);
+    }
+
+    startWorkerThreads();
+}
+
+void LocalAvoidanceHelper::clear()
+{
+    std::unique_lock<std::mutex> lock(g_workerMutex);
+    g_isStopping = true;
+    lock.unlock();
+    g_workerCondition.notify_all();
+
+    for (auto& workerThread : g_workerThreadList)
+    {
+        workerThread.join();
+    }
+    g_workerThreadList.clear();
+
+    g_isStopping = false;
+}
+
+void LocalAvoidanceHelper::computeNewVelocities(vector<AvoidanceAgent>& agentList, float deltaTime)
+{
+    for (auto& agent : agentList)
+    {
+        agent.newVelocity = agent.isMoving ? agent.preferredVelocity : Vec2::ZERO;
+    }
+
+    if (deltaTime <= 0.0f)
+    {
+        return;
+    }
+
+    solveLayer(agentList, false, deltaTime);
+    solveLayer(agentList, true, deltaTime);
+}
+
+void LocalAvoidanceHelper::solveLayer(vector<AvoidanceAgent>& agentList, bool isAir, float deltaTime)
+{
+    AvoidanceLayer layer;
+    layer.agentList = &agentList;
+    layer.isAir = isAir;
+    layer.deltaTime = deltaTime;
+
+    float maxRadius = 0.0f;
+    float maxSpeed = 0.0f;
+    auto& movingAgentIndexList = layer.movingAgentIndexList;
+    for (int agentIndex = 0; agentIndex < (int)agentList.size(); agentIndex++)
+    {
+        auto& agent = agentList[agentIndex];
+        if (agent.isAir == isAir)
+        {
+            maxRadius = std::max(maxRadius, agent.radius);
+            maxSpeed = std::max(maxSpeed, agent.maxSpeed);
+            if (agent.isMoving)
+            {
+                movingAgentIndexList.push_back(agentIndex);
+            }
+        }
+    }
+
+    if (movingAgentIndexList.empty())
+    {
+        return;
+    }
+
+    // 两个npc在时间窗口内相向而行能够走过的距离以外，不可能在窗口内相撞
+    float neighborDistance = maxRadius * 2.0f + maxSpeed * 2.0f * AVOIDANCE_TIME_HORIZON;
+    unordered_map<long long, vector<int>> cellAgentIndexMap;
+    for (int agentIndex = 0; agentIndex < (int)agentList.size(); agentIndex++)
+    {
+        auto& agent = agentList[agentIndex];
+        if (agent.isAir == isAir)
+        {
+            long long columnIndex = (long long)floorf(agent.position.x / neighborDistance);
+            long long rowIndex = (long long)floorf(agent.position.y / neighborDistance);
+            cellAgentIndexMap[(columnIndex << 32) ^ (rowIndex & 0xffffffff)].push_back(agentIndex);
+        }
+    }
+
+    auto& neighborIndexLists = layer.neighborIndexLists;
+    neighborIndexLists.resize(movingAgentIndexList.size());
+    vector<pair<float, int>> candidateList;
+    for (int movingIndex = 0; movingIndex < (int)movingAgentIndexList.size(); movingIndex++)
+    {
+        int agentIndex = movingAgentIndexList[movingIndex];
+        auto& agent = agentList[agentIndex];
+        long long columnIndex = (long long)floorf(agent.position.x / neighborDistance);
+        long long rowIndex = (long long)floorf(agent.position.y / neighborDistance);
+
+        candidateList.clear();
+        for (long long besideColumnIndex = columnIndex - 1; besideColumnIndex <= columnIndex + 1; besideColumnIndex++)
+        {
+            for (long long besideRowIndex = rowIndex - 1; besideRowIndex <= rowIndex + 1; besideRowIndex++)
+            {
+                auto cellIter = cellAgentIndexMap.find((besideColumnIndex << 32) ^ (besideRowIndex & 0xffffffff));
+                if (cellIter == cellAgentIndexMap.end())
+                {
+                    continue;
+                }
+
+                for (auto otherAgentIndex : cellIter->second)
+                {
+                    float distanceSquared = agent.position.distanceSquared(agentList[otherAgentIndex].position);
+                    if (otherAgentIndex != agentIndex && distanceSquared < neighborDistance * neighborDistance)
+                    {
+                        candidateList.push_back(make_pair(distanceSquared, otherAgentIndex));
+                    }
+                }
+            }
+        }
+
+        int neighborCount = std::min((int)candidateList.size(), MAX_AVOIDANCE_NEIGHBOR_COUNT);
+        std::partial_sort(candidateList.begin(), candidateList.begin() + neighborCount, candidateList.end());
+        for (int candidateIndex = 0; candidateIndex < neighborCount; candidateIndex++)
+        {
+            neighborIndexLists[movingIndex].push_back(candidateList[candidateIndex].second);
+        }
+    }
+
+    if ((int)movingAgentIndexList.size() < MIN_PARALLEL_AVOIDANCE_AGENT_COUNT || g_workerThreadList.empty())
+    {
+        solveAgentRange(&layer, 0, (int)movingAgentIndexList.size());
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(g_workerMutex);
+    g_solvingLayer = &layer;
+    g_nextMovingIndex = 0;
+    g_unfinishedAgentCount = (int)movingAgentIndexList.size();
+    lock.unlock();
+    g_workerCondition.notify_all();
+
+    while (solveNextAgentRange())
+    {
+    }
+
+    // layer是局部变量，工作线程手上的任务算完以后才能返回
+    lock.lock();
+    while (g_unfinishedAgentCount > 0)
+    {
+        g_finishedCondition.wait(lock);
+    }
+}
+
+void LocalAvoidanceHelper::solveAgentRange(AvoidanceLayer* layer, int beginIndex, int endIndex)
+{
+    vector<AvoidanceLine> lineList;
+    for (int movingIndex = beginIndex; movingIndex < endIndex; movingIndex++)
+    {
+        auto& agent = (*layer->agentList)[layer->movingAgentIndexList[movingIndex]];
+        agent.newVelocity = computeNewVelocity(agent, *layer, layer->neighborIndexLists[movingIndex], lineList);
+    }
+}
+
+bool LocalAvoidanceHelper::solveNextAgentRange()
+{
+    std::unique_lock<std::mutex> lock(g_workerMutex);
+    if (!g_solvingLayer)
+    {
+        return false;
+    }
+
+    auto layer = g_solvingLayer;
+    int beginIndex = g_nextMovingIndex;
+    int endIndex = std::min(beginIndex + AVOIDANCE_AGENT_COUNT_PER_TASK, (int)layer->movingAgentIndexList.size());
+    g_nextMovingIndex = endIndex;
+    if (endIndex == (int)layer->movingAgentIndexList.size())
+    {
+        g_solvingLayer = nullptr;
+    }
+    lock.unlock();
+
+    solveAgentRange(layer, beginIndex, endIndex);
+
+    lock.lock();
+    g_unfinishedAgentCount -= endIndex - beginIndex;
+    if (g_unfinishedAgentCount == 0)
+    {
+        g_finishedCondition.notify_all();
+    }
+
+    return true;
+}
+
+void LocalAvoidanceHelper::startWorkerThreads()
+{
+    int workerThreadCount = std::min((int)std::thread::hardware_concurrency(), MAX_AVOIDANCE_THREAD_COUNT) - 1;
+    for (int threadIndex = 0; threadIndex < workerThreadCount; threadIndex++)
+    {
+        g_workerThreadList.push_back(std::thread(&LocalAvoidanceHelper::runWorkerThread));
+    }
+}
+
+void LocalAvoidanceHelper::runWorkerThread()
+{
+    bool isStopping = false;
+    while (!isStopping)
+    {
+        std::unique_lock<std::mutex> lock(g_workerMutex);
+        while (!g_isStopping && !g_solvingLayer)
+        {
+            g_workerCondition.wait(lock);
+        }
+        isStopping = g_isStopping;
+        lock.unlock();
+
+        if (!isStopping)
+        {
+            solveNextAgentRange();
+        }
+    }
+}
+
+Vec2 LocalAvoidanceHelper::computeNewVelocity(const AvoidanceAgent& agent, const AvoidanceLayer& layer, const vector<int>& neighborIndexList,
+    vector<AvoidanceLine>& lineList)
+{
+    lineList.clear();
+
+    // 空军不受地形影响
+    if (!layer.isAir)
+    {
+        addObstacleLines(agent, layer.deltaTime, lineList);
+    }
+    int obstacleLineCount = (int)lineList.size();
+
+    float inverseTimeHorizon = 1.0f / AVOIDANCE_TIME_HORIZON;
+    for (auto neighborIndex : neighborIndexList)
+    {
+        auto& neighbor = (*layer.agentList)[neighborIndex];
+        auto relativePosition = neighbor.position - agent.position;
+        auto relativeVelocity = agent.velocity - neighbor.velocity;
+        float distanceSquared = relativePosition.lengthSquared();
+        float combinedRadius = agent.radius + neighbor.radius;
+
+        AvoidanceLine line;
+        Vec2 u;
+        if (distanceSquared > combinedRadius * combinedRadius)
+        {
+            // 速度障碍是截断的圆锥，w是相对速度到截断圆心的向量
+            auto w = relativeVelocity - relativePosition * inverseTimeHorizon;
+            float wLengthSquared = w.lengthSquared();
+            float dotProduct = w.dot(relativePosition);
+            if (dotProduct < 0.0f && dotProduct * dotProduct > combinedRadius * combinedRadius * wLengthSquared)
+            {
+                // 投影到截断的圆弧上
+                float wLength = sqrtf(wLengthSquared);
+                auto unitW = w / wLength;
+                line.direction = Vec2(unitW.y, -unitW.x);
+                u = unitW * (combinedRadius * inverseTimeHorizon - wLength);
+            }
+            else
+            {
+                // 投影到圆锥的两条边上
+                float leg = sqrtf(distanceSquared - combinedRadius * combinedRadius);
+                if (relativePosition.cross(w) > 0.0f)
+                {
+                    line.direction = Vec2(relativePosition.x * leg - relativePosition.y * combinedRadius,
+                        relativePosition.x * combinedRadius + relativePosition.y * leg) / distanceSquared;
+                }
+                else
+                {
+                    line.direction = -Vec2(relativePosition.x * leg + relativePosition.y * combinedRadius,
+                        -relativePosition.x * combinedRadius + relativePosition.y * leg) / distanceSquared;
+                }
+
+                u = line.direction * relativeVelocity.dot(line.direction) - relativeVelocity;
+            }
+        }
+        else
+        {
+            // 已经重叠，在这一帧内分开
+            float inverseDeltaTime = 1.0f / layer.deltaTime;
+            auto w = relativeVelocity - relativePosition * inverseDeltaTime;
+            float wLength = w.length();
+            auto unitW = wLength > AVOIDANCE_EPSILON ? w / wLength : Vec2(0.0f, -1.0f);
+            line.direction = Vec2(unitW.y, -unitW.x);
+            u = unitW * (combinedRadius * inverseDeltaTime - wLength);
+        }
+
+        line.point = agent.velocity + u * (neighbor.isMoving ? 0.5f : 1.0f);
+        lineList.push_back(line);
+    }
+
+    Vec2 newVelocity;
+    int failedLineIndex = linearProgram2(lineList, agent.maxSpeed, agent.preferredVelocity, false, newVelocity);
+    if (failedLineIndex < (int)lineList.size())
+    {
+        linearProgram3(lineList, obstacleLineCount, failedLineIndex, agent.maxSpeed, newVelocity);
+    }
+
+    return newVelocity;
+}
+
+void LocalAvoidanceHelper::addObstacleLines(const AvoidanceAgent& agent, float deltaTime, vector<AvoidanceLine>& lineList)
+{
+    if (!g_isAvailable)
+    {
+        return;
+    }
+
+    // 格子在地图上是菱形，先换算出需要检查的行列范围，再逐个计算到菱形边的最近距离
+    float range = agent.radius + agent.maxSpeed * AVOIDANCE_OBSTACLE_TIME_HORIZON;
+    int columnRange = (int)ceilf(range * g_rowAxis.length() / fabs(g_determinant));
+    int rowRange = (int)ceilf(range * g_columnAxis.length() / fabs(g_determinant));
+
+    auto tilePosition = convertToTilePosition(agent.position);
+    int columnIndex = (int)floorf(tilePosition.x);
+    int rowIndex = (int)floorf(tilePosition.y);
+    for (int besideColumnIndex = std::max(columnIndex - columnRange, 0); besideColumnIndex <= std::min(columnIndex + columnRange, g_maxColumnCount - 1); besideColumnIndex++)
+    {
+        for (int besideRowIndex = std::max(rowIndex - rowRange, 0); besideRowIndex <= std::min(rowIndex + rowRange, g_maxRowCount - 1); besideRowIndex++)
+        {
+            if (g_navigationGrid->passableList[besideColumnIndex * g_maxRowCount + besideRowIndex] ||
+                (besideColumnIndex == columnIndex && besideRowIndex == rowIndex))
+            {
+                continue;
+            }
+
+            Vec2 vertexList[4] = {
+                convertToInMapPosition(Vec2((float)besideColumnIndex, (float)besideRowIndex)),
+                convertToInMapPosition(Vec2(besideColumnIndex + 1.0f, (float)besideRowIndex)),
+                convertToInMapPosition(Vec2(besideColumnIndex + 1.0f, besideRowIndex + 1.0f)),
+                convertToInMapPosition(Vec2((float)besideColumnIndex, besideRowIndex + 1.0f)),
+            };
+
+            float distance = FLT_MAX;
+            Vec2 nearestPosition;
+            for (int vertexIndex = 0; vertexIndex < 4; vertexIndex++)
+            {
+                Vec2 edgeNearestPosition;
+                float edgeDistance = computeDistanceToSegment(agent.position, vertexList[vertexIndex], vertexList[(vertexIndex + 1) % 4], edgeNearestPosition);
+                if (edgeDistance < distance)
+                {
+                    distance = edgeDistance;
+                    nearestPosition = edgeNearestPosition;
+                }
+            }
+
+            if (distance >= range || distance <= AVOIDANCE_EPSILON)
+            {
+                continue;
+            }
+
+            // 朝障碍格方向的速度不能超过窗口内走到格子边缘所需的速度，已经贴上时向外推开
+            auto normal = (agent.position - nearestPosition) / distance;
+            float minNormalSpeed = distance > agent.radius ? (agent.radius - distance) / AVOIDANCE_OBSTACLE_TIME_HORIZON :
+                std::min((agent.radius - distance) / deltaTime, agent.maxSpeed);
+
+            AvoidanceLine line;
+            line.point = normal * minNormalSpeed;
+            line.direction = Vec2(normal.y, -normal.x);
+            lineList.push_back(line);
+        }
+    }
+}
+
+Vec2 LocalAvoidanceHelper::convertToTilePosition(const Vec2& inMapPosition)
+{
+    auto offset = inMapPosition - g_originPosition;
+
+    return Vec2(offset.cross(g_rowAxis) / g_determinant, g_columnAxis.cross(offset) / g_determinant);
+}
+
+Vec2 LocalAvoidanceHelper::convertToInMapPosition(const Vec2& tilePosition)
+{
+    return g_originPosition + g_columnAxis * tilePosition.x + g_rowAxis * tilePosition.y;
+}
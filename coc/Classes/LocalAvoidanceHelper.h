@@ -0,0 +1,51 @@
+#pragma once
+
+struct AvoidanceLine;
+struct AvoidanceLayer;
+
+const float AVOIDANCE_TIME_HORIZON = 1.0f;             // 只避让这么多秒以内会撞上的npc
+const float AVOIDANCE_OBSTACLE_TIME_HORIZON = 0.5f;    // 只避开这么多秒以内会走进的障碍格
+const int MAX_AVOIDANCE_NEIGHBOR_COUNT = 10;
+const int MIN_PARALLEL_AVOIDANCE_AGENT_COUNT = 128;    // npc少于这个数量时只在主线程中求解
+const int MAX_AVOIDANCE_THREAD_COUNT = 4;              // 包括主线程
+const int AVOIDANCE_AGENT_COUNT_PER_TASK = 32;         // 工作线程每次领取的npc数量
+
+struct AvoidanceAgent
+{
+    Vec2 position;
+    Vec2 velocity;              // 上一帧求解出的速度
+    Vec2 preferredVelocity;     // 沿着路径走的速度
+    float radius = 0.0f;
+    float maxSpeed = 0.0f;
+    bool isAir = false;
+    bool isMoving = false;      // 不移动的npc只作为障碍，由移动的一方负责全部避让
+
+    Vec2 newVelocity;
+};
+
+// ORCA局部避让：每个移动的npc根据周围npc的速度得到一组半平面约束，用线性规划求出最接近期望速度的安全速度；
+// 双方各承担一半的避让，不会像推挤那样来回抖动。陆军和空军分开求解，陆军还要避开障碍格
+class LocalAvoidanceHelper
+{
+public:
+    static void initNavigationGrid(NavigationGrid& navigationGrid);
+    static void clear();   // 等待所有工作线程退出
+    // 求解结果写回每个agent的newVelocity，npc较多时与常驻的工作线程一起计算，返回之前所有任务都已经完成
+    static void computeNewVelocities(vector<AvoidanceAgent>& agentList, float deltaTime);
+
+private:
+    static void solveLayer(vector<AvoidanceAgent>& agentList, bool isAir, float deltaTime);
+    static void solveAgentRange(AvoidanceLayer* layer, int beginIndex, int endIndex);
+    static bool solveNextAgentRange();
+    static void startWorkerThreads();
+    static void runWorkerThread();
+    static Vec2 computeNewVelocity(const AvoidanceAgent& agent, const AvoidanceLayer& layer, const vector<int>& neighborIndexList,
+        vector<AvoidanceLine>& lineList);
+    static void addObstacleLines(const AvoidanceAgent& agent, float deltaTime, vector<AvoidanceLine>& lineList);
+
+    static Vec2 convertToTilePosition(const Vec2& inMapPosition);
+    static Vec2 convertToInMapPosition(const Vec2& tilePosition);
+
+    LocalAvoidanceHelper();
+    ~LocalAvoidanceHelper();
+};
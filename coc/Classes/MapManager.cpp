@@ -1,6 +1,18 @@
 #include "Base.h"
 #include "MapManager.h"
 #include "AutoFindPathHelper.h"
+#include "ComponentHelper.h"
+#include "HierarchicalPathHelper.h"
+#include "FlowFieldHelper.h"
+#include "PathCacheHelper.h"
+#include "PathRequestService.h"
+#include "IncrementalPathPlanner.h"
+#include "PathSmoothHelper.h"
+#include "CooperativePathHelper.h"
+#include "LandmarkHelper.h"
+#include "NavMeshHelper.h"
+#include "BuildingRouteHelper.h"
+#include "LocalAvoidanceHelper.h"
 
 const int COMMAND_TIPS_RUN_ACTION_TIMES = 5;
 
@@ -9,20 +21,14 @@ static std::map<TileMapLayerType, std::string> s_tileMapLayerTypeToString = {
     { TileMapLayerType::GameObjcetLayer, "gameObjectLayer" },
 };
 
-
 MapManager::~MapManager()
 {
     Director::getInstance()->setProjection(Director::Projection::DEFAULT);
     Director::getInstance()->setDepthTest(false);
 
-    for (int rowIndex = 0; rowIndex < (int)_tileNodeTable.size(); rowIndex ++)
-    {
-        for (int columnIndex = 0; columnIndex < (int)_tileNodeTable[rowIndex].size(); columnIndex ++)
-        {
-            CC_SAFE_DELETE(_tileNodeTable[rowIndex][columnIndex]);
-        }
-    }
-    _tileNodeTable.clear();
+    // 工作线程可能还在使用这些格子
+    PathRequestService::clear();
+    LocalAvoidanceHelper::clear();
 }
 
 bool MapManager::init(Node* parentNode, const std::string& titleMapFileName)
@@ -50,7 +56,19 @@ bool MapManager::init(Node* parentNode, const std::string& titleMapFileName)
     _cursorPoint.y = visibleSize.height - cursorInClientPoint.y;
 
     initTileNodeTable();
-    AutoFindPathHelper::initTileNodeTable(_tileNodeTable);
+    ComponentHelper::initNavigationGrid(_navigationGrid);
+    LandmarkHelper::initNavigationGrid(_navigationGrid);
+    AutoFindPathHelper::initNavigationGrid(_navigationGrid);
+    HierarchicalPathHelper::initNavigationGrid(_navigationGrid);
+    FlowFieldHelper::initNavigationGrid(_navigationGrid);
+    PathCacheHelper::initNavigationGrid(_navigationGrid);
+    PathRequestService::initNavigationGrid(_navigationGrid);
+    IncrementalPathPlanner::initNavigationGrid(_navigationGrid);
+    PathSmoothHelper::initNavigationGrid(_navigationGrid);
+    CooperativePathHelper::initNavigationGrid(_navigationGrid);
+    NavMeshHelper::initNavigationGrid(_navigationGrid);
+    BuildingRouteHelper::initNavigationGrid(_navigationGrid);
+    LocalAvoidanceHelper::initNavigationGrid(_navigationGrid);
 
     //resolveMapShakeWhenMove();
 
@@ -259,39 +277,80 @@ void MapManager::addChildInGameObjectLayer(Node* gameObject, int zOrder/* = 1*/)
 void MapManager::initTileNodeTable()
 {
     auto mapSize = _tileMap->getMapSize();
-    _tileNodeTable.resize((int)mapSize.width);
+    _navigationGrid.columnCount = (int)mapSize.width;
+    _navigationGrid.rowCount = (int)mapSize.height;
+    _navigationGrid.tileNodeList.assign(_navigationGrid.columnCount * _navigationGrid.rowCount, TileNode());
+    _navigationGrid.passableList.assign(_navigationGrid.columnCount * _navigationGrid.rowCount, true);
 
     auto tileSize = _tileMap->getTileSize();
 
     auto gameObjectLayer = _tileMap->getLayer(s_tileMapLayerTypeToString[TileMapLayerType::GameObjcetLayer]);
 
-    for (int columnIndex = 0; columnIndex < (int)mapSize.width; columnIndex ++)
+    for (int columnIndex = 0; columnIndex < _navigationGrid.columnCount; columnIndex ++)
     {
-        _tileNodeTable[columnIndex].resize((int)mapSize.height);
-        for (int rowIndex = 0; rowIndex < (int)mapSize.height; rowIndex ++)
+        for (int rowIndex = 0; rowIndex < _navigationGrid.rowCount; rowIndex ++)
         {
-            _tileNodeTable[columnIndex][rowIndex] = new TileNode;
+            int tileIndex = columnIndex * _navigationGrid.rowCount + rowIndex;
+            auto& tileNode = _navigationGrid.tileNodeList[tileIndex];
 
-            _tileNodeTable[columnIndex][rowIndex]->gid = gameObjectLayer->getTileGIDAt(Vec2(columnIndex, rowIndex));
+            tileNode.gid = gameObjectLayer->getTileGIDAt(Vec2(columnIndex, rowIndex));
+            _navigationGrid.passableList[tileIndex] = (tileNode.gid != OBSTACLE_ID);
 
             Vec2 positionInTileMap;
             positionInTileMap.x = (((float)columnIndex - (float)rowIndex) / 2.0f + mapSize.width / 2.0f) * tileSize.width;
             positionInTileMap.y = (mapSize.height - ((float)columnIndex + (float)rowIndex) / 2.0f) *  tileSize.height;
-            _tileNodeTable[columnIndex][rowIndex]->leftTopPosition = positionInTileMap;
+            tileNode.leftTopPosition = positionInTileMap;
 
-            _tileNodeTable[columnIndex][rowIndex]->rowIndex = rowIndex;
-            _tileNodeTable[columnIndex][rowIndex]->columnIndex = columnIndex;
+            tileNode.rowIndex = rowIndex;
+            tileNode.columnIndex = columnIndex;
+        }
+    }
+}
 
-            _tileNodeTable[columnIndex][rowIndex]->parent = nullptr;
+TileNode* MapManager::getTileNodeAt(int columnIndex, int rowIndex)
+{
+    return &_navigationGrid.tileNodeList[columnIndex * _navigationGrid.rowCount + rowIndex];
+}
 
-            _tileNodeTable[columnIndex][rowIndex]->isVisit = false;
+void MapManager::updateTileNodesGID(const vector<Vec2>& inMapPositionList, int gid)
+{
+    vector<TileNode*> changedTileNodeList;
+    for (auto& inMapPosition : inMapPositionList)
+    {
+        auto tileSubscript = getTileSubscript(inMapPosition);
+        auto tileNode = getTileNodeAt((int)tileSubscript.x, (int)tileSubscript.y);
+        if (tileNode->gid != gid)
+        {
+            tileNode->gid = gid;
+            _navigationGrid.passableList[tileNode->columnIndex * _navigationGrid.rowCount + tileNode->rowIndex] = (gid != OBSTACLE_ID);
+            changedTileNodeList.push_back(tileNode);
         }
     }
+
+    if (!changedTileNodeList.empty())
+    {
+        _navigationVersion++;
+
+        ComponentHelper::onTileNodesGIDChanged(changedTileNodeList);
+        // 路标要在寻路服务之前更新，寻路服务取到的是与新格子状态一致的距离表
+        LandmarkHelper::onTileNodesGIDChanged(changedTileNodeList);
+        HierarchicalPathHelper::onTileNodesGIDChanged(changedTileNodeList);
+        PathCacheHelper::onTileNodesGIDChanged(changedTileNodeList);
+        PathRequestService::onTileNodesGIDChanged(changedTileNodeList);
+        IncrementalPathPlanner::onTileNodesGIDChanged(changedTileNodeList);
+        NavMeshHelper::onTileNodesGIDChanged(changedTileNodeList);
+        BuildingRouteHelper::onTileNodesGIDChanged(changedTileNodeList);
+    }
 }
 
-TileNode* MapManager::getTileNodeAt(int columnIndex, int rowIndex)
+int MapManager::getNavigationVersion()
+{
+    return _navigationVersion;
+}
+
+bool MapManager::isTileNodeReachable(TileNode* startNode, TileNode* endNode, bool isEndTileNodePassable)
 {
-    return _tileNodeTable[columnIndex][rowIndex];
+    return ComponentHelper::isTileNodeReachable(startNode, endNode, isEndTileNodePassable);
 }
 
 void MapManager::initMopUpCommandTips()
@@ -26,16 +26,18 @@ struct TileNode
     int gid = 0;
     Vec2 leftTopPosition;
 
-    int gotoEndNodeWeight = 0;
-    int gotoStartNodeWeight = 0;
-    int sumWeight = 0;
-
     int rowIndex = 0;
     int columnIndex = 0;
+};
 
-    bool isVisit = false;
-
-    TileNode* parent = nullptr;
+// 所有格子连续存放，下标为columnIndex * rowCount + rowIndex，初始化以后不再改变大小，TileNode的地址一直有效
+// passableList与格子的gid同步，寻路时只读这一份紧凑的数据，不需要访问TileNode
+struct NavigationGrid
+{
+    int columnCount = 0;
+    int rowCount = 0;
+    vector<TileNode> tileNodeList;
+    vector<bool> passableList;
 };
 
 const float MAP_MOVE_SPEED = 20.0f;
@@ -45,7 +47,7 @@ const float MAP_MIN_SCALE = 0.3f;
 const float MAP_MAX_SCALE = 1.0f;
 const int LINEUP_MAX_NPC_COUNT_PER_LINE = 5;
 
-// TileNodeı
+// TileNode的标记
 const int OBSTACLE_ID = 2;
 const int PASSABLE_ID = 0;
 
@@ -78,6 +80,10 @@ public:
     void addChildInGameObjectLayer(Node* gameObject, int zOrder = 1);
 
     TileNode* getTileNodeAt(int columnIndex, int rowIndex);
+    void updateTileNodesGID(const vector<Vec2>& inMapPositionList, int gid);
+    int getNavigationVersion();
+    // 根据连通区域判断能否走到终点，不需要寻路；isEndTileNodePassable为true时终点可以是障碍格，只要旁边有格子与起点连通即可
+    bool isTileNodeReachable(TileNode* startNode, TileNode* endNode, bool isEndTileNodePassable);
 
     bool isInObstacleTile(const Vec2& inMapPosition);
 
@@ -90,16 +96,18 @@ private:
     void resolveMapShakeWhenMove();
 
     void initTileNodeTable();
+
     void initMopUpCommandTips();
     void initMoveCommandTips();
 
     cocos2d::experimental::TMXTiledMap* _tileMap = nullptr;
-    float _mapScale = 0.5f; // ϵ⣬ֵܸģһ޸ģ༭Ľλûλ
+    float _mapScale = 0.5f; // 由于设计上的问题，这个值不能改，一旦修改，编辑后的建筑物位置会错位
 
     RECT _clientRect;
     Vec2 _cursorPoint;
 
-    vector<vector<TileNode*>> _tileNodeTable;
+    NavigationGrid _navigationGrid;
+    int _navigationVersion = 0;    // 格子的通行状态每改变一次就加1
 
     Sprite* _mopUpCommandTips = nullptr;
     Sprite* _moveCommandTips = nullptr;
@@ -0,0 +1,589 @@
+#include "Base.h"
+#include "MapManager.h"
+#include "NavMeshHelper.h"
+#include <algorithm>
+
+const int POLYGON_INDEX_INVALID = -1;
+const float NAVMESH_POINT_EPSILON = 0.0001f;
+
+typedef pair<float, int> OpenListElement;   // <weight, polygonIndex>
+
+static NavigationGrid* g_navigationGrid = nullptr;
+static int g_maxColumnCount = 0;
+static int g_maxRowCount = 0;
+
+// 格子坐标系到地图坐标系的仿射变换，格子(columnIndex, rowIndex)的左上角对应格子坐标(columnIndex, rowIndex)
+static bool g_isAvailable = false;
+static Vec2 g_originPosition;
+static Vec2 g_columnAxis;
+static Vec2 g_rowAxis;
+static float g_determinant = 0.0f;
+
+static vector<NavMeshPolygon> g_polygonList;
+static vector<int> g_polygonIndexList;     // 每个格子所在的多边形，障碍格为POLYGON_INDEX_INVALID
+static bool g_isDirty = true;
+
+static vector<float> g_gotoStartWeightList;
+static vector<Vec2> g_entryPositionList;   // 从哪个点进入多边形，起点所在的多边形就是起点
+static vector<int> g_parentPolygonIndexList;
+static vector<int> g_parentPortalIndexList;
+static vector<int> g_visitedSearchIDList;
+static vector<int> g_closedSearchIDList;
+static vector<OpenListElement> g_openList;
+static int g_searchID = 0;
+static int g_lastSearchExpandedNodeCount = 0;
+
+static bool isSamePoint(const Vec2& left, const Vec2& right)
+{
+    return (left - right).lengthSquared() < NAVMESH_POINT_EPSILON;
+}
+
+// 与漏斗算法的方向约定一致：c在a->b的左侧时为负
+static float computeTriangleArea2(const Vec2& a, const Vec2& b, const Vec2& c)
+{
+    return (c.x - a.x) * (b.y - a.y) - (b.x - a.x) * (c.y - a.y);
+}
+
+void NavMeshHelper::initNavigationGrid(NavigationGrid& navigationGrid)
+{
+    g_navigationGrid = &navigationGrid;
+    g_maxColumnCount = navigationGrid.columnCount;
+    g_maxRowCount = navigationGrid.rowCount;
+
+    g_isAvailable = false;
+    if (g_maxColumnCount > 1 && g_maxRowCount > 1)
+    {
+        g_originPosition = navigationGrid.tileNodeList[0].leftTopPosition;
+        g_columnAxis = navigationGrid.tileNodeList[g_maxRowCount].leftTopPosition - g_originPosition;
+        g_rowAxis = navigationGrid.tileNodeList[1].leftTopPosition - g_originPosition;
+        g_determinant = g_columnAxis.cross(g_rowAxis);
+        g_isAvailable = (fabs(g_determinant) > NAVMESH_POINT_EPSILON);
+    }
+
+    g_polygonList.clear();
+    g_openList.clear();
+    g_searchID = 0;
+    g_lastSearchExpandedNodeCount = 0;
+    g_isDirty = true;
+}
+
+void NavMeshHelper::onTileNodesGIDChanged(const vector<TileNode*>& tileNodeList)
+{
+    g_isDirty = true;
+}
+
+bool NavMeshHelper::computePointPathList(const Vec2& inMapStartPosition, const Vec2& inMapEndPosition, bool isEndTileNodePassable, list<Vec2>& pointPathList)
+{
+    bool result = false;
+
+    if (!g_isAvailable)
+    {
+        return result;
+    }
+
+    if (g_isDirty)
+    {
+        bake();
+    }
+
+    auto startTilePosition = convertToTilePosition(inMapStartPosition);
+    auto endTilePosition = convertToTilePosition(inMapEndPosition);
+    int startPolygonIndex = getPolygonIndexAt(startTilePosition);
+    if (startPolygonIndex == POLYGON_INDEX_INVALID)
+    {
+        return result;
+    }
+
+    // 终点在建筑物内时，走到与它相邻的任意一个多边形就可以，最后一段直接走进去
+    vector<int> endPolygonIndexList;
+    int endPolygonIndex = getPolygonIndexAt(endTilePosition);
+    bool isEndInObstacle = (endPolygonIndex == POLYGON_INDEX_INVALID);
+    if (!isEndInObstacle)
+    {
+        endPolygonIndexList.push_back(endPolygonIndex);
+    }
+    else if (isEndTileNodePassable)
+    {
+        int endColumnIndex = std::min(std::max((int)floor(endTilePosition.x), 0), g_maxColumnCount - 1);
+        int endRowIndex = std::min(std::max((int)floor(endTilePosition.y), 0), g_maxRowCount - 1);
+        for (int besideColumnIndex = max(endColumnIndex - 1, 0); besideColumnIndex <= min(endColumnIndex + 1, g_maxColumnCount - 1); besideColumnIndex++)
+        {
+            for (int besideRowIndex = max(endRowIndex - 1, 0); besideRowIndex <= min(endRowIndex + 1, g_maxRowCount - 1); besideRowIndex++)
+            {
+                int besidePolygonIndex = g_polygonIndexList[besideColumnIndex * g_maxRowCount + besideRowIndex];
+                if (besidePolygonIndex != POLYGON_INDEX_INVALID &&
+                    std::find(endPolygonIndexList.begin(), endPolygonIndexList.end(), besidePolygonIndex) == endPolygonIndexList.end())
+                {
+                    endPolygonIndexList.push_back(besidePolygonIndex);
+                }
+            }
+        }
+    }
+
+    if (endPolygonIndexList.empty())
+    {
+        return result;
+    }
+
+    vector<int> portalPathList;
+    int arrivedPolygonIndex = POLYGON_INDEX_INVALID;
+    if (searchPolygonPath(startPolygonIndex, startTilePosition, endPolygonIndexList, endTilePosition, portalPathList, arrivedPolygonIndex))
+    {
+        auto targetTilePosition = isEndInObstacle ? clampIntoPolygon(endTilePosition, arrivedPolygonIndex) : endTilePosition;
+
+        vector<Vec2> tilePositionList;
+        pullString(startTilePosition, targetTilePosition, startPolygonIndex, portalPathList, tilePositionList);
+        if (isEndInObstacle)
+        {
+            tilePositionList.push_back(endTilePosition);
+        }
+
+        // 第一个点是起点，因此可以忽略；最后一个点用原始的终点，避免坐标变换的误差
+        pointPathList.clear();
+        for (int tilePositionIndex = 1; tilePositionIndex < (int)tilePositionList.size() - 1; tilePositionIndex++)
+        {
+            if (!isSamePoint(tilePositionList[tilePositionIndex], tilePositionList[tilePositionIndex - 1]))
+            {
+                pointPathList.push_back(convertToInMapPosition(tilePositionList[tilePositionIndex]));
+            }
+        }
+
+        if (!isSamePoint(startTilePosition, endTilePosition))
+        {
+            pointPathList.push_back(inMapEndPosition);
+        }
+
+        result = true;
+    }
+
+    return result;
+}
+
+int NavMeshHelper::getPolygonCount()
+{
+    if (g_isAvailable && g_isDirty)
+    {
+        bake();
+    }
+
+    return (int)g_polygonList.size();
+}
+
+int NavMeshHelper::getLastSearchExpandedNodeCount()
+{
+    return g_lastSearchExpandedNodeCount;
+}
+
+void NavMeshHelper::bake()
+{
+    g_polygonList.clear();
+    g_polygonIndexList.assign(g_navigationGrid->passableList.size(), POLYGON_INDEX_INVALID);
+
+    // 按照格子的存放顺序贪心合并，先沿着行号方向伸长，再整列整列地沿着列号方向加宽
+    for (int columnIndex = 0; columnIndex < g_maxColumnCount; columnIndex++)
+    {
+        for (int rowIndex = 0; rowIndex < g_maxRowCount; rowIndex++)
+        {
+            int tileIndex = columnIndex * g_maxRowCount + rowIndex;
+            if (g_navigationGrid->passableList[tileIndex] && g_polygonIndexList[tileIndex] == POLYGON_INDEX_INVALID)
+            {
+                mergePolygon(columnIndex, rowIndex);
+            }
+        }
+    }
+
+    for (int polygonIndex = 0; polygonIndex < (int)g_polygonList.size(); polygonIndex++)
+    {
+        connectPolygon(polygonIndex);
+    }
+
+    // 多边形数量变了以后搜索编号也要重新开始
+    g_gotoStartWeightList.assign(g_polygonList.size(), 0.0f);
+    g_entryPositionList.assign(g_polygonList.size(), Vec2::ZERO);
+    g_parentPolygonIndexList.assign(g_polygonList.size(), POLYGON_INDEX_INVALID);
+    g_parentPortalIndexList.assign(g_polygonList.size(), 0);
+    g_visitedSearchIDList.assign(g_polygonList.size(), 0);
+    g_closedSearchIDList.assign(g_polygonList.size(), 0);
+    g_searchID = 0;
+
+    g_isDirty = false;
+}
+
+void NavMeshHelper::mergePolygon(int columnIndex, int rowIndex)
+{
+    auto& passableList = g_navigationGrid->passableList;
+
+    NavMeshPolygon polygon;
+    polygon.minColumnIndex = columnIndex;
+    polygon.minRowIndex = rowIndex;
+    polygon.maxColumnIndex = columnIndex;
+    polygon.maxRowIndex = rowIndex;
+
+    while (polygon.maxRowIndex + 1 < g_maxRowCount)
+    {
+        int tileIndex = columnIndex * g_maxRowCount + polygon.maxRowIndex + 1;
+        if (!passableList[tileIndex] || g_polygonIndexList[tileIndex] != POLYGON_INDEX_INVALID)
+        {
+            break;
+        }
+
+        polygon.maxRowIndex++;
+    }
+
+    bool canExpand = true;
+    while (canExpand && polygon.maxColumnIndex + 1 < g_maxColumnCount)
+    {
+        for (int besideRowIndex = polygon.minRowIndex; besideRowIndex <= polygon.maxRowIndex; besideRowIndex++)
+        {
+            int tileIndex = (polygon.maxColumnIndex + 1) * g_maxRowCount + besideRowIndex;
+            if (!passableList[tileIndex] || g_polygonIndexList[tileIndex] != POLYGON_INDEX_INVALID)
+            {
+                canExpand = false;
+                break;
+            }
+        }
+
+        if (canExpand)
+        {
+            polygon.maxColumnIndex++;
+        }
+    }
+
+    int polygonIndex = (int)g_polygonList.size();
+    for (int polygonColumnIndex = polygon.minColumnIndex; polygonColumnIndex <= polygon.maxColumnIndex; polygonColumnIndex++)
+    {
+        for (int polygonRowIndex = polygon.minRowIndex; polygonRowIndex <= polygon.maxRowIndex; polygonRowIndex++)
+        {
+            g_polygonIndexList[polygonColumnIndex * g_maxRowCount + polygonRowIndex] = polygonIndex;
+        }
+    }
+
+    g_polygonList.push_back(polygon);
+}
+
+void NavMeshHelper::connectPolygon(int polygonIndex)
+{
+    // 只检查紧贴着矩形外圈的格子，包括四个角，与格子寻路一样允许斜着穿过两个障碍物之间的顶点
+    int minColumnIndex = max(g_polygonList[polygonIndex].minColumnIndex - 1, 0);
+    int minRowIndex = max(g_polygonList[polygonIndex].minRowIndex - 1, 0);
+    int maxColumnIndex = min(g_polygonList[polygonIndex].maxColumnIndex + 1, g_maxColumnCount - 1);
+    int maxRowIndex = min(g_polygonList[polygonIndex].maxRowIndex + 1, g_maxRowCount - 1);
+    for (int columnIndex = minColumnIndex; columnIndex <= maxColumnIndex; columnIndex++)
+    {
+        bool isBorderColumn = (columnIndex == minColumnIndex || columnIndex == maxColumnIndex);
+        for (int rowIndex = minRowIndex; rowIndex <= maxRowIndex; rowIndex += (isBorderColumn ? 1 : max(maxRowIndex - minRowIndex, 1)))
+        {
+            int besidePolygonIndex = g_polygonIndexList[columnIndex * g_maxRowCount + rowIndex];
+            if (besidePolygonIndex == POLYGON_INDEX_INVALID || besidePolygonIndex == polygonIndex)
+            {
+                continue;
+            }
+
+            bool isConnected = false;
+            for (auto& portal : g_polygonList[polygonIndex].portalList)
+            {
+                if (portal.polygonIndex == besidePolygonIndex)
+                {
+                    isConnected = true;
+                    break;
+                }
+            }
+
+            if (!isConnected)
+            {
+                addPortal(polygonIndex, besidePolygonIndex);
+            }
+        }
+    }
+}
+
+void NavMeshHelper::addPortal(int polygonIndex, int besidePolygonIndex)
+{
+    auto& polygon = g_polygonList[polygonIndex];
+    auto& besidePolygon = g_polygonList[besidePolygonIndex];
+
+    // 两个矩形内部不相交，闭区间的交集是一条公共边，或者只有顶点相接时两个方向都退化成一个点
+    int minColumnIndex = max(polygon.minColumnIndex, besidePolygon.minColumnIndex);
+    int minRowIndex = max(polygon.minRowIndex, besidePolygon.minRowIndex);
+    int maxColumnIndex = min(polygon.maxColumnIndex, besidePolygon.maxColumnIndex) + 1;
+    int maxRowIndex = min(polygon.maxRowIndex, besidePolygon.maxRowIndex) + 1;
+
+    Vec2 endPoint((float)minColumnIndex, (float)minRowIndex);
+    Vec2 otherEndPoint((float)maxColumnIndex, (float)maxRowIndex);
+
+    float portalLength = endPoint.distance(otherEndPoint);
+    float endPointMargin = isWallCorner(minColumnIndex, minRowIndex) ? NAVMESH_PORTAL_MARGIN : 0.0f;
+    float otherEndPointMargin = isWallCorner(maxColumnIndex, maxRowIndex) ? NAVMESH_PORTAL_MARGIN : 0.0f;
+    if (portalLength > NAVMESH_POINT_EPSILON && endPointMargin + otherEndPointMargin > 0.0f)
+    {
+        auto direction = (otherEndPoint - endPoint) / portalLength;
+        if (endPointMargin + otherEndPointMargin >= portalLength)
+        {
+            // 出口太窄，收缩成一个点，两端都贴着障碍物时就是中点
+            endPoint = otherEndPoint = endPoint + direction * (portalLength * endPointMargin / (endPointMargin + otherEndPointMargin));
+        }
+        else
+        {
+            endPoint = endPoint + direction * endPointMargin;
+            otherEndPoint = otherEndPoint - direction * otherEndPointMargin;
+        }
+    }
+
+    NavMeshPortal portal;
+    portal.polygonIndex = besidePolygonIndex;
+    portal.endPoint = endPoint;
+    portal.otherEndPoint = otherEndPoint;
+    polygon.portalList.push_back(portal);
+}
+
+bool NavMeshHelper::isWallCorner(int vertexColumnIndex, int vertexRowIndex)
+{
+    bool result = false;
+
+    for (int columnIndex = vertexColumnIndex - 1; columnIndex <= vertexColumnIndex && !result; columnIndex++)
+    {
+        for (int rowIndex = vertexRowIndex - 1; rowIndex <= vertexRowIndex && !result; rowIndex++)
+        {
+            if (columnIndex < 0 || columnIndex >= g_maxColumnCount || rowIndex < 0 || rowIndex >= g_maxRowCount ||
+                !g_navigationGrid->passableList[columnIndex * g_maxRowCount + rowIndex])
+            {
+                result = true;
+            }
+        }
+    }
+
+    return result;
+}
+
+int NavMeshHelper::getPolygonIndexAt(const Vec2& tilePosition)
+{
+    // 与MapManager::getTileSubscript一样把地图外的点算到边缘的格子上
+    int columnIndex = std::min(std::max((int)floor(tilePosition.x), 0), g_maxColumnCount - 1);
+    int rowIndex = std::min(std::max((int)floor(tilePosition.y), 0), g_maxRowCount - 1);
+
+    return g_polygonIndexList[columnIndex * g_maxRowCount + rowIndex];
+}
+
+bool NavMeshHelper::searchPolygonPath(int startPolygonIndex, const Vec2& startTilePosition, const vector<int>& endPolygonIndexList,
+    const Vec2& endTilePosition, vector<int>& portalPathList, int& arrivedPolygonIndex)
+{
+    bool result = false;
+
+    // 节点的位置取进入多边形时经过出口的那个点，代价是这些点之间的直线距离，之后由漏斗算法拉直
+    g_searchID++;
+    g_openList.clear();
+    g_lastSearchExpandedNodeCount = 0;
+
+    g_gotoStartWeightList[startPolygonIndex] = 0.0f;
+    g_entryPositionList[startPolygonIndex] = startTilePosition;
+    g_parentPolygonIndexList[startPolygonIndex] = POLYGON_INDEX_INVALID;
+    g_visitedSearchIDList[startPolygonIndex] = g_searchID;
+    g_openList.push_back(OpenListElement(startTilePosition.distance(endTilePosition), startPolygonIndex));
+
+    while (!g_openList.empty())
+    {
+        std::pop_heap(g_openList.begin(), g_openList.end(), std::greater<OpenListElement>());
+        int polygonIndex = g_openList.back().second;
+        g_openList.pop_back();
+
+        if (g_closedSearchIDList[polygonIndex] == g_searchID)
+        {
+            continue;
+        }
+
+        g_closedSearchIDList[polygonIndex] = g_searchID;
+        g_lastSearchExpandedNodeCount++;
+
+        if (std::find(endPolygonIndexList.begin(), endPolygonIndexList.end(), polygonIndex) != endPolygonIndexList.end())
+        {
+            arrivedPolygonIndex = polygonIndex;
+            portalPathList.clear();
+            while (g_parentPolygonIndexList[polygonIndex] != POLYGON_INDEX_INVALID)
+            {
+                portalPathList.push_back(g_parentPortalIndexList[polygonIndex]);
+                polygonIndex = g_parentPolygonIndexList[polygonIndex];
+            }
+            std::reverse(portalPathList.begin(), portalPathList.end());
+
+            result = true;
+            break;
+        }
+
+        auto& portalList = g_polygonList[polygonIndex].portalList;
+        for (int portalIndex = 0; portalIndex < (int)portalList.size(); portalIndex++)
+        {
+            int besidePolygonIndex = portalList[portalIndex].polygonIndex;
+            if (g_closedSearchIDList[besidePolygonIndex] == g_searchID)
+            {
+                continue;
+            }
+
+            auto entryPosition = computeEntryPosition(portalList[portalIndex], g_entryPositionList[polygonIndex], endTilePosition);
+            float gotoStartWeight = g_gotoStartWeightList[polygonIndex] + g_entryPositionList[polygonIndex].distance(entryPosition);
+            if (g_visitedSearchIDList[besidePolygonIndex] != g_searchID || gotoStartWeight < g_gotoStartWeightList[besidePolygonIndex])
+            {
+                g_visitedSearchIDList[besidePolygonIndex] = g_searchID;
+                g_gotoStartWeightList[besidePolygonIndex] = gotoStartWeight;
+                g_entryPositionList[besidePolygonIndex] = entryPosition;
+                g_parentPolygonIndexList[besidePolygonIndex] = polygonIndex;
+                g_parentPortalIndexList[besidePolygonIndex] = portalIndex;
+
+                g_openList.push_back(OpenListElement(gotoStartWeight + entryPosition.distance(endTilePosition), besidePolygonIndex));
+                std::push_heap(g_openList.begin(), g_openList.end(), std::greater<OpenListElement>());
+            }
+        }
+    }
+
+    return result;
+}
+
+void NavMeshHelper::pullString(const Vec2& startTilePosition, const Vec2& endTilePosition, int startPolygonIndex, const vector<int>& portalPathList,
+    vector<Vec2>& tilePositionList)
+{
+    // 出口按照前进方向分出左右两端，起点和终点看作两端重合的出口
+    vector<Vec2> leftPointList;
+    vector<Vec2> rightPointList;
+    leftPointList.push_back(startTilePosition);
+    rightPointList.push_back(startTilePosition);
+
+    int polygonIndex = startPolygonIndex;
+    for (auto portalIndex : portalPathList)
+    {
+        auto& portal = g_polygonList[polygonIndex].portalList[portalIndex];
+        auto center = getPolygonCenter(polygonIndex);
+        auto direction = getPolygonCenter(portal.polygonIndex) - center;
+        if (direction.cross(portal.endPoint - center) >= direction.cross(portal.otherEndPoint - center))
+        {
+            leftPointList.push_back(portal.endPoint);
+            rightPointList.push_back(portal.otherEndPoint);
+        }
+        else
+        {
+            leftPointList.push_back(portal.otherEndPoint);
+            rightPointList.push_back(portal.endPoint);
+        }
+
+        polygonIndex = portal.polygonIndex;
+    }
+
+    leftPointList.push_back(endTilePosition);
+    rightPointList.push_back(endTilePosition);
+
+    // 漏斗算法：左右两条边不断向内收紧，一侧越过另一侧时，另一侧的端点就是路径的拐点，从拐点重新开始
+    tilePositionList.clear();
+    tilePositionList.push_back(startTilePosition);
+
+    auto apexPoint = startTilePosition;
+    auto leftPoint = startTilePosition;
+    auto rightPoint = startTilePosition;
+    int apexIndex = 0;
+    int leftIndex = 0;
+    int rightIndex = 0;
+    for (int portalIndex = 1; portalIndex < (int)leftPointList.size(); portalIndex++)
+    {
+        auto& nextLeftPoint = leftPointList[portalIndex];
+        auto& nextRightPoint = rightPointList[portalIndex];
+
+        if (computeTriangleArea2(apexPoint, rightPoint, nextRightPoint) <= 0.0f)
+        {
+            if (isSamePoint(apexPoint, rightPoint) || computeTriangleArea2(apexPoint, leftPoint, nextRightPoint) > 0.0f)
+            {
+                rightPoint = nextRightPoint;
+                rightIndex = portalIndex;
+            }
+            else
+            {
+                apexPoint = leftPoint;
+                apexIndex = leftIndex;
+                tilePositionList.push_back(apexPoint);
+
+                rightPoint = leftPoint = apexPoint;
+                rightIndex = leftIndex = apexIndex;
+                portalIndex = apexIndex;
+                continue;
+            }
+        }
+
+        if (computeTriangleArea2(apexPoint, leftPoint, nextLeftPoint) >= 0.0f)
+        {
+            if (isSamePoint(apexPoint, leftPoint) || computeTriangleArea2(apexPoint, rightPoint, nextLeftPoint) < 0.0f)
+            {
+                leftPoint = nextLeftPoint;
+                leftIndex = portalIndex;
+            }
+            else
+            {
+                apexPoint = rightPoint;
+                apexIndex = rightIndex;
+                tilePositionList.push_back(apexPoint);
+
+                rightPoint = leftPoint = apexPoint;
+                rightIndex = leftIndex = apexIndex;
+                portalIndex = apexIndex;
+                continue;
+            }
+        }
+    }
+
+    if (!isSamePoint(tilePositionList.back(), endTilePosition))
+    {
+        tilePositionList.push_back(endTilePosition);
+    }
+}
+
+Vec2 NavMeshHelper::computeEntryPosition(const NavMeshPortal& portal, const Vec2& fromTilePosition, const Vec2& endTilePosition)
+{
+    // 在出口上找一点使得从fromTilePosition经过它到终点的折线最短，出口的中点在宽出口上会让路径代价偏差很大
+    float portalLength = portal.endPoint.distance(portal.otherEndPoint);
+    if (portalLength < NAVMESH_POINT_EPSILON)
+    {
+        return portal.endPoint;
+    }
+
+    auto direction = (portal.otherEndPoint - portal.endPoint) / portalLength;
+    float fromDistance = direction.dot(fromTilePosition - portal.endPoint);
+    float endDistance = direction.dot(endTilePosition - portal.endPoint);
+    float fromHeight = fabs(direction.cross(fromTilePosition - portal.endPoint));
+    float endHeight = fabs(direction.cross(endTilePosition - portal.endPoint));
+
+    // 终点翻到出口的另一侧，两点连线与出口的交点就是最短的位置，再限制在出口范围内
+    float entryDistance = endDistance;
+    if (fromHeight + endHeight > NAVMESH_POINT_EPSILON)
+    {
+        entryDistance = fromDistance + (endDistance - fromDistance) * fromHeight / (fromHeight + endHeight);
+    }
+    entryDistance = std::min(std::max(entryDistance, 0.0f), portalLength);
+
+    return portal.endPoint + direction * entryDistance;
+}
+
+Vec2 NavMeshHelper::clampIntoPolygon(const Vec2& tilePosition, int polygonIndex)
+{
+    // 取多边形中离终点最近的点，终点格子与多边形相邻，从这个点直线走到终点只会经过终点格子
+    auto& polygon = g_polygonList[polygonIndex];
+
+    Vec2 clampedTilePosition;
+    clampedTilePosition.x = std::min(std::max(tilePosition.x, (float)polygon.minColumnIndex), (float)(polygon.maxColumnIndex + 1));
+    clampedTilePosition.y = std::min(std::max(tilePosition.y, (float)polygon.minRowIndex), (float)(polygon.maxRowIndex + 1));
+
+    return clampedTilePosition;
+}
+
+Vec2 NavMeshHelper::getPolygonCenter(int polygonIndex)
+{
+    auto& polygon = g_polygonList[polygonIndex];
+
+    return Vec2((float)(polygon.minColumnIndex + polygon.maxColumnIndex + 1) * 0.5f, (float)(polygon.minRowIndex + polygon.maxRowIndex + 1) * 0.5f);
+}
+
+Vec2 NavMeshHelper::convertToTilePosition(const Vec2& inMapPosition)
+{
+    auto offset = inMapPosition - g_originPosition;
+
+    return Vec2(offset.cross(g_rowAxis) / g_determinant, g_columnAxis.cross(offset) / g_determinant);
+}
+
+Vec2 NavMeshHelper::convertToInMapPosition(const Vec2& tilePosition)
+{
+    return g_originPosition + g_columnAxis * tilePosition.x + g_rowAxis * tilePosition.y;
+}
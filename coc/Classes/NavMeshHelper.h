@@ -0,0 +1,59 @@
+#pragma once
+
+const float NAVMESH_PORTAL_MARGIN = 0.5f;      // 出入口贴着障碍物的一端向内收缩的距离，单位是格子，npc不会贴着建筑物的角走
+
+struct NavMeshPortal
+{
+    int polygonIndex = 0;       // 出口另一侧的多边形
+    Vec2 endPoint;              // 出口两端的点，在格子坐标系中，收缩以后可能重合成一个点
+    Vec2 otherEndPoint;
+};
+
+// 格子坐标系中的矩形，变换到地图上是菱形，都是凸多边形；包含从min到max的所有格子
+struct NavMeshPolygon
+{
+    int minColumnIndex = 0;
+    int minRowIndex = 0;
+    int maxColumnIndex = 0;
+    int maxRowIndex = 0;
+    vector<NavMeshPortal> portalList;
+};
+
+// 导航网格：把gameObjectLayer中连成一片的可通行格子合并成少量矩形，A*在多边形之间搜索，
+// 再用漏斗算法沿着经过的出口序列拉出最短的折线，开阔地形上只需要扩展几十个节点
+class NavMeshHelper
+{
+public:
+    static void initNavigationGrid(NavigationGrid& navigationGrid);
+    // 只标记过期，下次寻路之前重新合并，同一帧内放置多个建筑物只需要合并一次
+    static void onTileNodesGIDChanged(const vector<TileNode*>& tileNodeList);
+
+    // 路径格式与GameWorld::tryGetRequestedPathList取回的一致：不包含起点，最后一个点就是终点；
+    // 起点在障碍格内或者找不到路径时返回false，调用者改用格子寻路
+    static bool computePointPathList(const Vec2& inMapStartPosition, const Vec2& inMapEndPosition, bool isEndTileNodePassable, list<Vec2>& pointPathList);
+
+    static int getPolygonCount();
+    static int getLastSearchExpandedNodeCount();
+
+private:
+    static void bake();
+    static void mergePolygon(int columnIndex, int rowIndex);
+    static void connectPolygon(int polygonIndex);
+    static void addPortal(int polygonIndex, int besidePolygonIndex);
+    static bool isWallCorner(int vertexColumnIndex, int vertexRowIndex);
+    static int getPolygonIndexAt(const Vec2& tilePosition);
+
+    static bool searchPolygonPath(int startPolygonIndex, const Vec2& startTilePosition, const vector<int>& endPolygonIndexList,
+        const Vec2& endTilePosition, vector<int>& portalPathList, int& arrivedPolygonIndex);
+    static void pullString(const Vec2& startTilePosition, const Vec2& endTilePosition, int startPolygonIndex, const vector<int>& portalPathList,
+        vector<Vec2>& tilePositionList);
+    static Vec2 computeEntryPosition(const NavMeshPortal& portal, const Vec2& fromTilePosition, const Vec2& endTilePosition);
+    static Vec2 clampIntoPolygon(const Vec2& tilePosition, int polygonIndex);
+    static Vec2 getPolygonCenter(int polygonIndex);
+
+    static Vec2 convertToTilePosition(const Vec2& inMapPosition);
+    static Vec2 convertToInMapPosition(const Vec2& tilePosition);
+
+    NavMeshHelper();
+    ~NavMeshHelper();
+};
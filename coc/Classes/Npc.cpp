@@ -23,6 +23,8 @@ const string SHOW_NPC_STATUS_CHILD_NAME = "ShowNpcStatusChildName";
 
 const int MOVE_TO_ACTION_TAG = 1;
 
+static vector<GameObject*> g_nearbyGameObjectList;     // 空间查询的结果，每次查询前清空，避免每帧分配
+
 Npc::~Npc()
 {
     clear();
@@ -369,7 +371,8 @@ void Npc::update(float delta)
 
     if (_gameObjectType == GameObjectType::Npc)
     {
-        collisionTest();
+        updatePathRequest();
+        repairPathListIfBlocked();
         runFightWithEnemyAI(delta);
     }
     else if (_gameObjectType == GameObjectType::DefenceInBuildingNpc)
@@ -391,17 +394,131 @@ void Npc::tryUpdateStatus(NpcStatus newStatus)
     }
 }
 
-void Npc::collisionTest()
+bool Npc::isCollisionTestEnabled()
+{
+    return _oldStatus != NpcStatus::Die && _oldStatus != NpcStatus::Stand;
+}
+
+void Npc::addCollisionWith(GameObject* gameObject, float realDistance, float constraintDistance)
+{
+    if (!isCollisionTestEnabled())
+    {
+        return;
+    }
+
+    // 只被前方的npc挡住，被后面的npc追上时不需要让开
+    auto unitMoveVector = _position - gameObject->getPosition();
+    if (computeFaceDirectionVector().dot(unitMoveVector) < 0.0f)
+    {
+        unitMoveVector.normalize();
+
+        _collisionSumVector += unitMoveVector;
+        _collisionSumDifference += constraintDistance - realDistance;
+        _collisionCount++;
+        _collisionAttackTargetUniqueID = gameObject->getUniqueID();
+    }
+}
+
+void Npc::resolveCollision()
+{
+    int collisionCount = _collisionCount;
+    float sumDifference = _collisionSumDifference;
+    Vec2 sumVector = _collisionSumVector;
+    int attackTargetUniqueID = _collisionAttackTargetUniqueID;
+
+    _collisionCount = 0;
+    _collisionSumDifference = 0.0f;
+    _collisionSumVector = Vec2::ZERO;
+    _collisionAttackTargetUniqueID = GAME_OBJECT_UNIQUE_ID_INVALID;
+
+    if (!isCollisionTestEnabled())
+    {
+        return;
+    }
+
+    if (collisionCount > 0)
+    {
+        GameObjectManager::getInstance()->addNpcCollisionCount(collisionCount);
+
+        // 打开局部避让时移动中的npc已经互相让开，不再推挤，站着的npc仍然要被推开
+        if (!g_setting.allowLocalAvoidance || computePreferredVelocity() == Vec2::ZERO)
+        {
+            auto averageVector = sumVector / collisionCount;
+            auto averageDifference = sumDifference / collisionCount;
+            auto moveVector = averageVector * averageDifference;
+
+            auto newPosition = _position + moveVector;
+            auto mapManager = GameWorldCallBackFunctionsManager::getInstance()->_getMapManager();
+
+            auto readyToMoveInTileNodeSubscript = mapManager->getTileSubscript(newPosition);
+            auto readyToMoveInTileNode = mapManager->getTileNodeAt((int)readyToMoveInTileNodeSubscript.x, (int)readyToMoveInTileNodeSubscript.y);
+
+            if (readyToMoveInTileNode->gid != OBSTACLE_ID)
+            {
+                setPosition(newPosition);
+            }
+        }
+
+        // 应策划要求，处于后排，无法跑到前面的npc攻击距离增加，目的是为了多几排npc能够发动攻击。
+        setAttackRange(_maxAttackRangeWhenCollision);
+
+        if (attackTargetUniqueID != GAME_OBJECT_UNIQUE_ID_INVALID && _oldStatus != NpcStatus::Attack)
+        {
+            setEnemyUniqueID(attackTargetUniqueID);
+        }
+    }
+    else
+    {
+        setAttackRange(_maxAttackRangeWhenCollision - 50.0f);
+    }
+}
+
+Vec2 Npc::computePreferredVelocity()
+{
+    Vec2 result;
+
+    if (_oldStatus == NpcStatus::Move && getActionByTag(MOVE_TO_ACTION_TAG))
+    {
+        result = _moveVelocity;
+    }
+
+    return result;
+}
+
+const Vec2& Npc::getAvoidanceVelocity()
 {
-    if (_oldStatus == NpcStatus::Die || _oldStatus == NpcStatus::Stand)
+    return _avoidanceVelocity;
+}
+
+void Npc::applyAvoidanceVelocity(const Vec2& newVelocity, float deltaTime)
+{
+    auto preferredVelocity = computePreferredVelocity();
+    if (preferredVelocity == Vec2::ZERO)
     {
+        _avoidanceVelocity = Vec2::ZERO;
         return;
     }
 
-    int collisionCount = 0;
-    float sumDifference = 0.0f;
-    Vec2 sumVector;
+    // 动作这一帧已经按照期望速度移动过了，只补上两者的差值
+    auto newPosition = _position + (newVelocity - preferredVelocity) * deltaTime;
+    if (!_isAir)
+    {
+        auto mapManager = GameWorldCallBackFunctionsManager::getInstance()->_getMapManager();
+        auto readyToMoveInTileNodeSubscript = mapManager->getTileSubscript(newPosition);
+        auto readyToMoveInTileNode = mapManager->getTileNodeAt((int)readyToMoveInTileNodeSubscript.x, (int)readyToMoveInTileNodeSubscript.y);
+        if (readyToMoveInTileNode->gid == OBSTACLE_ID)
+        {
+            _avoidanceVelocity = preferredVelocity;
+            return;
+        }
+    }
+
+    setPosition(newPosition);
+    _avoidanceVelocity = newVelocity;
+}
 
+Vec2 Npc::computeFaceDirectionVector()
+{
     Vec2 selfFaceDirectionVector;
     switch (_faceDirection)
     {
@@ -444,83 +561,7 @@ void Npc::collisionTest()
     default:    break;
     }
 
-    bool hasCollision = false;
-    GameObject* attackTarget = nullptr;
-
-    auto& gameObjectMap = GameObjectManager::getInstance()->getGameObjectMap();
-    for (auto& gameObjectIter : gameObjectMap)
-    {
-        auto gameObject = gameObjectIter.second;
-        if (gameObject->isReadyToRemove() || 
-            gameObject->getGameObjectType() == GameObjectType::DefenceInBuildingNpc ||
-            gameObject->getGameObjectType() == GameObjectType::Building ||
-            gameObject->getUniqueID() == _uniqueID)
-        {
-            continue;
-        }
-
-        if (gameObject->getGameObjectType() == GameObjectType::Npc)
-        {
-            // վֻͿվײ½ֻ½ײ
-            auto npcObject = static_cast<Npc*>(gameObject);
-            if (npcObject->isAir() != _isAir)
-            {
-                continue;
-            }
-        }
-
-        auto& gameObjectPosition = gameObject->getPosition();
-        auto unitMoveVector = _position - gameObjectPosition;
-        float dot = selfFaceDirectionVector.dot(unitMoveVector);
-
-        float gameObjectCollisionRadius = gameObject->getCollisionRadius();
-
-        float realDistance = GameUtils::computeDistanceBetween(_position, gameObject->getPosition());
-        float constraintDistance = _collisionRadius + gameObjectCollisionRadius;
-        if (realDistance < constraintDistance && dot < 0.0f)
-        {
-            hasCollision = true;
-
-            unitMoveVector.normalize();
-
-            sumVector += unitMoveVector;
-            sumDifference += constraintDistance - realDistance;
-
-            collisionCount++;
-
-            attackTarget = gameObject;
-        }
-    }
-
-    if (hasCollision)
-    {
-        auto averageVector = sumVector / collisionCount;
-        auto averageDifference = sumDifference / collisionCount;
-        auto moveVector = averageVector * averageDifference;
-
-        auto newPosition = _position + moveVector;
-        auto mapManager = GameWorldCallBackFunctionsManager::getInstance()->_getMapManager();
-
-        auto readyToMoveInTileNodeSubscript = mapManager->getTileSubscript(newPosition);
-        auto readyToMoveInTileNode = mapManager->getTileNodeAt((int)readyToMoveInTileNodeSubscript.x, (int)readyToMoveInTileNodeSubscript.y);
-
-        if (readyToMoveInTileNode->gid != OBSTACLE_ID)
-        {
-            setPosition(newPosition);
-        }
-
-        // Ӧ߻Ҫ󣬴ںţ޷ܵǰnpcӣĿΪ˶༸npcܹ
-        setAttackRange(_maxAttackRangeWhenCollision);
-
-        if (attackTarget && _oldStatus != NpcStatus::Attack)
-        {
-            setEnemyUniqueID(attackTarget->getUniqueID());
-        }
-    }
-    else
-    {
-        setAttackRange(_maxAttackRangeWhenCollision - 50.0f);
-    }
+    return selfFaceDirectionVector;
 }
 
 void Npc::runFightWithEnemyAI(float delta)
@@ -583,14 +624,14 @@ void Npc::runFightWithEnemyAI(float delta)
                 }
                 else if (_mopUpCommand.isExecuting)
                 {
-                    moveTo(_mopUpCommand.finalPosition, true);
+                    moveToMopUpFinalPosition();
                 }
             }
             else
             {
                 if (_oldStatus == NpcStatus::Stand && _mopUpCommand.isExecuting)
                 {
-                    moveTo(_mopUpCommand.finalPosition, true);
+                    moveToMopUpFinalPosition();
                 }
             }
         }
@@ -650,35 +691,43 @@ bool Npc::canSearchEnemy()
 
 void Npc::searchNearbyEnemy()
 {
-    auto& gameObjectMap = GameObjectManager::getInstance()->getGameObjectMap();
-    for (auto& gameObjectIter : gameObjectMap)
+    GameObjectQueryFilter enemyFilter;
+    enemyFilter.forceType = _forceType == ForceType::Player ? ForceType::AI : ForceType::Player;
+    enemyFilter.isEnemyApproachableOnly = true;
+    if (!_canAirAttack)
     {
-        Building* buildingObject = nullptr;
-        Npc* npcObject = nullptr;
-        if (gameObjectIter.second->getGameObjectType() == GameObjectType::Building)
-        {
-            buildingObject = static_cast<Building*>(gameObjectIter.second);
-        }
-        else if (gameObjectIter.second->getGameObjectType() == GameObjectType::Npc)
-        {
-            npcObject = static_cast<Npc*>(gameObjectIter.second);
-        }
+        enemyFilter.layer = GameObjectLayer::Ground;
+    }
 
-        if (_forceType == gameObjectIter.second->getForceType() ||
-            gameObjectIter.second->isReadyToRemove() ||
-            !gameObjectIter.second->canEnemyApproach() ||
-            (buildingObject && buildingObject->getBuildingStatus() == BuildingStatus::PrepareToBuild) ||
-            (npcObject && npcObject->isAir() && !_canAirAttack))
+    // 攻击范围要加上敌人的攻击范围加成，按照所有对象中最大的加成查询；
+    // 从近到远检查，轰炸机只能攻击正下方的敌人，最近的几个不一定能攻击到；
+    // 候选都不行时加倍数量重新查询，只检查新增的更远的候选，直到searchRadius以内的对象都检查过
+    auto gameObjectManager = GameObjectManager::getInstance();
+    float searchRadius = std::max((float)_maxAlertRadius, _maxAttackRadius + gameObjectManager->getMaxExtraEnemyAttackRadius());
+    int candidateCount = SEARCH_ENEMY_CANDIDATE_COUNT;
+    int checkedCount = 0;
+    bool isFound = false;
+    while (!isFound)
+    {
+        gameObjectManager->queryNearestGameObjects(getPosition(), searchRadius, candidateCount, enemyFilter, g_nearbyGameObjectList);
+        for (int index = checkedCount; index < (int)g_nearbyGameObjectList.size(); index++)
         {
-            continue;
+            auto gameObject = g_nearbyGameObjectList[index];
+            if (isEnemyInAttackRange(gameObject) || isEnemyInAlertRange(gameObject))
+            {
+                setEnemyUniqueID(gameObject->getUniqueID());
+                isFound = true;
+
+                break;
+            }
         }
 
-        if (isEnemyInAttackRange(gameObjectIter.second) || isEnemyInAlertRange(gameObjectIter.second))
+        if ((int)g_nearbyGameObjectList.size() < candidateCount)
         {
-            setEnemyUniqueID(gameObjectIter.first);
-
             break;
         }
+        checkedCount = candidateCount;
+        candidateCount *= 2;
     }
 }
 
@@ -694,22 +743,22 @@ GameObject* Npc::searchNearestNeedReinforceGameObject()
 
     int needReinforceGameObjectID = GAME_OBJECT_UNIQUE_ID_INVALID;
 
+    GameObjectQueryFilter reinforceFilter;
+    reinforceFilter.forceType = ForceType::AI;
+    reinforceFilter.isIncludeReadyToRemove = true;
+
     float minDistance = FLT_MAX;
-    auto& gameObjectMap = GameObjectManager::getInstance()->getGameObjectMap();
-    for (auto& gameObjectIter : gameObjectMap)
+    GameObjectManager::getInstance()->queryGameObjectsInRadius(getPosition(), _reinforceRadius, reinforceFilter, g_nearbyGameObjectList);
+    for (auto gameObject : g_nearbyGameObjectList)
     {
-        auto gameObject = gameObjectIter.second;
-        if (gameObject->getForceType() == ForceType::AI)
+        int enemyID = gameObject->getEnemyUniqueID();
+        if (enemyID != GAME_OBJECT_UNIQUE_ID_INVALID)
         {
-            int enemyID = gameObject->getEnemyUniqueID();
-            if (enemyID != GAME_OBJECT_UNIQUE_ID_INVALID)
+            float distance = GameUtils::computeDistanceBetween(getPosition(), gameObject->getPosition());
+            if (distance < _reinforceRadius && distance < minDistance)
             {
-                float distance = GameUtils::computeDistanceBetween(getPosition(), gameObject->getPosition());
-                if (distance < _reinforceRadius && distance < minDistance)
-                {
-                    minDistance = distance;
-                    needReinforceGameObjectID = gameObject->getUniqueID();
-                }
+                minDistance = distance;
+                needReinforceGameObjectID = gameObject->getUniqueID();
             }
         }
     }
@@ -782,10 +831,8 @@ void Npc::updateStatusWhenEnemyInAlertRange(GameObject* enemy)
     {
     case NpcStatus::Move:
     {
-        auto enemyPosition = computeArrivePositionBy(enemy);
-
         if (_gotoTargetPositionPathList.empty() ||
-            !_gotoTargetPositionPathList.empty() && _gotoTargetPositionPathList.back() != enemyPosition)
+            !_gotoTargetPositionPathList.empty() && !isArrivePositionOf(enemy, _gotoTargetPositionPathList.back()))
         {
             tryChase(enemy);
         }
@@ -804,7 +851,7 @@ void Npc::updateStatusWhenEnemyInAlertRange(GameObject* enemy)
 
 void Npc::updateStatusWhenEnemyLeaveAlertRange()
 {
-    //aiƵnpcսվҿƵnpcսԺȻƶ
+    //ai控制的npc脱战，则立即站立，玩家控制的npc脱战以后，仍然可以移动。
     if (_forceType == ForceType::Player)
     {
         return;
@@ -828,20 +875,18 @@ void Npc::updateStatusWhenEnemyLeaveAlertRange()
 
 void Npc::reinforceOwnSide(GameObject* gameObject)
 {
-    Vec2 arrivePosition;
-
     if (gameObject->getGameObjectType() == GameObjectType::Building)
     {
         auto needReinforceBuilding = static_cast<Building*>(gameObject);
-        auto& bottomGridPositionList = needReinforceBuilding->getBottomGridInMapPositionList();
-        arrivePosition = bottomGridPositionList.at(0);
+        if (!moveAlongBuildingRouteTo(needReinforceBuilding->getUniqueID()))
+        {
+            moveToNearest(needReinforceBuilding->getBottomGridInMapPositionList(), true);
+        }
     }
     else
     {
-        arrivePosition = gameObject->getPosition();
+        moveTo(gameObject->getPosition(), true);
     }
-
-    moveTo(arrivePosition, true);
 }
 
 void Npc::tryChase(GameObject* enemy)
@@ -856,36 +901,106 @@ void Npc::tryChase(GameObject* enemy)
         return;
     }
 
-    auto npcPosition = getPosition();
     auto enemyPosition = computeArrivePositionBy(enemy);
 
-    _gotoTargetPositionPathList.clear();
+    // 重新提交的请求会排到队尾，每次警戒都重新提交的话，节点扩展预算紧张时可能永远拿不到路径
+    if (!_isAir && isChasePathRequestPending(enemy, enemyPosition))
+    {
+        return;
+    }
+
+    cancelPathRequest();
     if (_isAir)
     {
         auto npcTemplate = TemplateManager::getInstance()->getNpcTemplateBy(_templateName);
         float yDelta = _contentSize.height / 2.0f - npcTemplate->shadowYPosition;
         enemyPosition.y += yDelta;
 
+        _gotoTargetPositionPathList.clear();
         _gotoTargetPositionPathList.push_back(enemyPosition);
+
+        tryUpdateStatus(NpcStatus::Move);
+    }
+    else if (enemy->getGameObjectType() == GameObjectType::Building)
+    {
+        // 所有占地格子一起作为终点搜索，不需要先猜一个离得最近的格子
+        auto building = static_cast<Building*>(enemy);
+        requestPathListToNearest(building->getBottomGridInMapPositionList(), true, enemy->getUniqueID());
     }
     else
     {
-        if (enemy->getGameObjectType() == GameObjectType::Npc)
+        requestPathListTo(enemyPosition, false, enemy->getUniqueID());
+    }
+}
+
+bool Npc::isChasePathRequestPending(GameObject* enemy, const Vec2& arrivePosition)
+{
+    bool result = false;
+
+    if (_isWaitingForPathList && _pathRequestEnemyUniqueID == enemy->getUniqueID())
+    {
+        if (enemy->getGameObjectType() == GameObjectType::Building)
         {
-            _gotoTargetPositionPathList = _gameWorld->_computePathList(npcPosition, enemyPosition, false);
+            // 终点是建筑物的所有占地格子，建筑物不会移动
+            result = true;
         }
-        else
+        else if (!_pathRequestTargetPositionList.empty())
         {
-            _gotoTargetPositionPathList = _gameWorld->_computePathList(npcPosition, enemyPosition, true);
+            result = GameUtils::computeDistanceBetween(arrivePosition, _pathRequestTargetPositionList.front()) <= CHASE_TARGET_MOVE_TOLERANCE;
         }
     }
 
+    return result;
+}
+
+void Npc::requestPathListTo(const Vec2& targetPosition, bool isAllowEndTileNodeToMoveIn, int chasingEnemyUniqueID /* = ENEMY_UNIQUE_ID_INVALID */)
+{
+    requestPathListToNearest(vector<Vec2>(1, targetPosition), isAllowEndTileNodeToMoveIn, chasingEnemyUniqueID);
+}
+
+void Npc::requestPathListToNearest(const vector<Vec2>& targetPositionList, bool isAllowEndTileNodeToMoveIn,
+    int chasingEnemyUniqueID /* = ENEMY_UNIQUE_ID_INVALID */)
+{
+    cancelPathRequest();
+
+    _pathRequestStartPosition = getPosition();
+    _pathRequestID = _gameWorld->_requestPathListToNearest(_pathRequestStartPosition, targetPositionList, isAllowEndTileNodeToMoveIn);
+    _isWaitingForPathList = true;
+    _pathRequestEnemyUniqueID = chasingEnemyUniqueID;
+    _pathRequestTargetPositionList = targetPositionList;
+    _isPathRequestAllowEndTileNodeToMoveIn = isAllowEndTileNodeToMoveIn;
+}
+
+void Npc::updatePathRequest()
+{
+    list<Vec2> pathList;
+    if (!_isWaitingForPathList || !_gameWorld->_tryGetRequestedPathList(_pathRequestID, pathList))
+    {
+        return;
+    }
+
+    _isWaitingForPathList = false;
+    _gotoTargetPositionPathList = pathList;
+    joinRequestedPathList();
+    onPathListAssigned(_isPathRequestAllowEndTileNodeToMoveIn);
+
     if (_gotoTargetPositionPathList.empty())
     {
         tryUpdateStatus(NpcStatus::Stand);
 
-        setEnemyUniqueID(ENEMY_UNIQUE_ID_INVALID);
-        enemy->launchForbidEnemyApproachTimer();
+        // 等待期间npc可能已经换了敌人，只有仍然在追击同一个敌人时才放弃它
+        if (_pathRequestEnemyUniqueID != ENEMY_UNIQUE_ID_INVALID)
+        {
+            auto enemy = GameObjectManager::getInstance()->getGameObjectBy(_pathRequestEnemyUniqueID);
+            if (_enemyUniqueID == _pathRequestEnemyUniqueID)
+            {
+                setEnemyUniqueID(ENEMY_UNIQUE_ID_INVALID);
+            }
+            if (enemy)
+            {
+                enemy->launchForbidEnemyApproachTimer();
+            }
+        }
     }
     else
     {
@@ -893,6 +1008,86 @@ void Npc::tryChase(GameObject* enemy)
     }
 }
 
+void Npc::joinRequestedPathList()
+{
+    if (_gotoTargetPositionPathList.empty())
+    {
+        return;
+    }
+
+    // 路径从提交请求时的位置出发，等待期间npc可能已经沿着原来的路径走远了：
+    // 已经走过的拐点直接跳过，跳过以后当前位置到下一个拐点之间有障碍时，先走回提交请求时的位置
+    auto currentPosition = getPosition();
+    while (_gotoTargetPositionPathList.size() >= 2)
+    {
+        auto& firstPosition = _gotoTargetPositionPathList.front();
+        auto& secondPosition = *std::next(_gotoTargetPositionPathList.begin());
+        bool isSecondPositionEnd = (_gotoTargetPositionPathList.size() == 2);
+        if ((currentPosition - firstPosition).dot(secondPosition - firstPosition) <= 0.0f ||
+            _gameWorld->_isPathListBlocked(currentPosition, list<Vec2>(1, secondPosition), isSecondPositionEnd && _isPathRequestAllowEndTileNodeToMoveIn))
+        {
+            break;
+        }
+
+        _gotoTargetPositionPathList.pop_front();
+    }
+
+    bool isFirstPositionEnd = (_gotoTargetPositionPathList.size() == 1);
+    if (_gameWorld->_isPathListBlocked(currentPosition, list<Vec2>(1, _gotoTargetPositionPathList.front()), isFirstPositionEnd && _isPathRequestAllowEndTileNodeToMoveIn))
+    {
+        _gotoTargetPositionPathList.push_front(_pathRequestStartPosition);
+    }
+}
+
+void Npc::cancelPathRequest()
+{
+    if (_isWaitingForPathList)
+    {
+        _gameWorld->_cancelPathRequest(_pathRequestID);
+        _isWaitingForPathList = false;
+    }
+}
+
+void Npc::repairPathListIfBlocked()
+{
+    if (_isAir || _isWaitingForPathList || _oldStatus != NpcStatus::Move || _gotoTargetPositionPathList.empty())
+    {
+        return;
+    }
+
+    int navigationVersion = _gameWorld->_getMapManager()->getNavigationVersion();
+    if (navigationVersion == _pathNavigationVersion)
+    {
+        return;
+    }
+
+    if (!_gameWorld->_isPathListBlocked(getPosition(), _gotoTargetPositionPathList, _isPathAllowEndTileNodeToMoveIn))
+    {
+        _pathNavigationVersion = navigationVersion;
+    }
+    else if (_gameWorld->_repairPathList(_uniqueID, getPosition(), _isPathAllowEndTileNodeToMoveIn, _gotoTargetPositionPathList))
+    {
+        _pathNavigationVersion = navigationVersion;
+
+        if (_gotoTargetPositionPathList.empty())
+        {
+            tryUpdateStatus(NpcStatus::Stand);
+        }
+        else
+        {
+            tryUpdateStatus(NpcStatus::Move);
+        }
+    }
+}
+
+void Npc::onPathListAssigned(bool isAllowEndTileNodeToMoveIn)
+{
+    // 新路径的终点可能不同，原来的增量寻路器不再有用
+    _gameWorld->_removePathPlanner(_uniqueID);
+    _pathNavigationVersion = _gameWorld->_getMapManager()->getNavigationVersion();
+    _isPathAllowEndTileNodeToMoveIn = isAllowEndTileNodeToMoveIn;
+}
+
 bool Npc::isReadyToRemove()
 {
     return _oldStatus == NpcStatus::Die;
@@ -907,23 +1102,65 @@ cocos2d::Vec2 Npc::computeArrivePositionBy(GameObject* enemy)
     }
     else if (enemy->getGameObjectType() == GameObjectType::Building)
     {
-        auto selfPosition = getPosition();
+        auto building = static_cast<Building*>(enemy);
+        arrivePosition = building->computeNearestBottomGridInMapPosition(getPosition());
+    }
+
+    return arrivePosition;
+}
 
+bool Npc::isArrivePositionOf(GameObject* enemy, const Vec2& position)
+{
+    bool result = false;
+
+    if (enemy->getGameObjectType() == GameObjectType::Building)
+    {
+        // 走到建筑物的任意一个占地格子都可以攻击到它
         auto building = static_cast<Building*>(enemy);
         auto& bottomGridInMapPositionList = building->getBottomGridInMapPositionList();
-        float minDistance = FLT_MAX;
-        for (auto& bottomGridInMapPosition : bottomGridInMapPositionList)
+        result = std::find(bottomGridInMapPositionList.begin(), bottomGridInMapPositionList.end(), position) != bottomGridInMapPositionList.end();
+    }
+    else
+    {
+        result = (computeArrivePositionBy(enemy) == position);
+    }
+
+    return result;
+}
+
+void Npc::moveToMopUpFinalPosition()
+{
+    if (_mopUpCommand.finalPositionList.empty())
+    {
+        moveTo(_mopUpCommand.finalPosition, true);
+    }
+    else
+    {
+        moveToNearest(_mopUpCommand.finalPositionList, true);
+    }
+}
+
+bool Npc::isMopUpFinalPosition(const Vec2& position)
+{
+    bool result = false;
+
+    if (_mopUpCommand.finalPositionList.empty())
+    {
+        result = GameUtils::isVec2Equal(_mopUpCommand.finalPosition, position);
+    }
+    else
+    {
+        for (auto& finalPosition : _mopUpCommand.finalPositionList)
         {
-            float distance = GameUtils::computeDistanceBetween(selfPosition, bottomGridInMapPosition);
-            if (distance < minDistance)
+            if (GameUtils::isVec2Equal(finalPosition, position))
             {
-                minDistance = distance;
-                arrivePosition = bottomGridInMapPosition;
+                result = true;
+                break;
             }
         }
     }
 
-    return arrivePosition;
+    return result;
 }
 
 float Npc::getDistanceFrom(GameObject* enemy)
@@ -1233,6 +1470,7 @@ void Npc::switchDieToAttack()
 void Npc::moveTo(const Vec2& targetPosition, bool isAllowEndTileNodeToMoveIn /* = false */)
 {
     _isReadyToMove = false;
+    cancelPathRequest();
 
     if (_isAir)
     {
@@ -1249,19 +1487,114 @@ void Npc::moveTo(const Vec2& targetPosition, bool isAllowEndTileNodeToMoveIn /*
     }
     else
     {
-        auto startPosition = getPosition();
-        _gotoTargetPositionPathList.clear();
-        _gotoTargetPositionPathList = _gameWorld->_computePathList(startPosition, targetPosition, isAllowEndTileNodeToMoveIn);
+        requestPathListTo(targetPosition, isAllowEndTileNodeToMoveIn);
+    }
+}
 
-        if (_gotoTargetPositionPathList.empty())
-        {
-            tryUpdateStatus(NpcStatus::Stand);
-        }
-        else
+void Npc::moveAlongFlowFieldTo(const Vec2& flowFieldTargetPosition, const Vec2& targetPosition, bool isAllowEndTileNodeToMoveIn /* = false */)
+{
+    if (_isAir)
+    {
+        moveTo(targetPosition, isAllowEndTileNodeToMoveIn);
+        return;
+    }
+
+    _isReadyToMove = false;
+    cancelPathRequest();
+
+    _gotoTargetPositionPathList.clear();
+    _gotoTargetPositionPathList = _gameWorld->_computePathListByFlowField(_uniqueID, flowFieldTargetPosition, targetPosition, isAllowEndTileNodeToMoveIn);
+    onPathListAssigned(isAllowEndTileNodeToMoveIn);
+
+    if (_gotoTargetPositionPathList.empty())
+    {
+        tryUpdateStatus(NpcStatus::Stand);
+    }
+    else
+    {
+        tryUpdateStatus(NpcStatus::Move);
+    }
+}
+
+void Npc::moveToNearest(const vector<Vec2>& targetPositionList, bool isAllowEndTileNodeToMoveIn /* = false */)
+{
+    if (targetPositionList.empty())
+    {
+        return;
+    }
+
+    if (_isAir)
+    {
+        // 空中单位直线飞行，直接选择直线距离最近的位置
+        auto selfPosition = getPosition();
+        auto nearestPosition = targetPositionList.front();
+        float minDistance = FLT_MAX;
+        for (auto& targetPosition : targetPositionList)
         {
-            tryUpdateStatus(NpcStatus::Move);
+            float distance = GameUtils::computeDistanceBetween(selfPosition, targetPosition);
+            if (distance < minDistance)
+            {
+                minDistance = distance;
+                nearestPosition = targetPosition;
+            }
         }
+
+        moveTo(nearestPosition, isAllowEndTileNodeToMoveIn);
+        return;
     }
+
+    _isReadyToMove = false;
+    requestPathListToNearest(targetPositionList, isAllowEndTileNodeToMoveIn);
+}
+
+void Npc::moveAlongFlowFieldToNearest(const vector<Vec2>& targetPositionList, bool isAllowEndTileNodeToMoveIn /* = false */)
+{
+    if (_isAir)
+    {
+        moveToNearest(targetPositionList, isAllowEndTileNodeToMoveIn);
+        return;
+    }
+
+    _isReadyToMove = false;
+    cancelPathRequest();
+
+    _gotoTargetPositionPathList.clear();
+    _gotoTargetPositionPathList = _gameWorld->_computePathListByFlowFieldToNearest(_uniqueID, targetPositionList, isAllowEndTileNodeToMoveIn);
+    onPathListAssigned(isAllowEndTileNodeToMoveIn);
+
+    if (_gotoTargetPositionPathList.empty())
+    {
+        tryUpdateStatus(NpcStatus::Stand);
+    }
+    else
+    {
+        tryUpdateStatus(NpcStatus::Move);
+    }
+}
+
+bool Npc::moveAlongBuildingRouteTo(int buildingUniqueID)
+{
+    bool result = false;
+
+    if (_isAir)
+    {
+        return result;
+    }
+
+    auto pointPathList = _gameWorld->_computePathListByBuildingRoute(_uniqueID, buildingUniqueID);
+    if (!pointPathList.empty())
+    {
+        _isReadyToMove = false;
+        cancelPathRequest();
+
+        _gotoTargetPositionPathList = pointPathList;
+        onPathListAssigned(true);
+        tryUpdateStatus(NpcStatus::Move);
+
+        result = true;
+    }
+
+    return result;
 }
 
 void Npc::setReadyToMoveStatus(bool isReadyToMove)
@@ -1269,6 +1602,16 @@ void Npc::setReadyToMoveStatus(bool isReadyToMove)
     _isReadyToMove = isReadyToMove;
 }
 
+bool Npc::isReadyToMove()
+{
+    return _isReadyToMove;
+}
+
+float Npc::getPerSecondMoveSpeedByPixel()
+{
+    return _perSecondMoveSpeedByPixel;
+}
+
 NpcStatus Npc::getNpcStatus()
 {
     return _oldStatus;
@@ -1330,7 +1673,7 @@ void Npc::onMoveTo()
     auto currentFaceDirection = getFaceToDirection(moveToPosition);
     float moveToDuration = getMoveToDuration(moveToPosition);
 
-    if (_mopUpCommand.isExecuting && GameUtils::isVec2Equal(_mopUpCommand.finalPosition, moveToPosition))
+    if (_mopUpCommand.isExecuting && isMopUpFinalPosition(moveToPosition))
     {
         _mopUpCommand.isExecuting = false;
     }
@@ -1351,6 +1694,7 @@ void Npc::onMoveTo()
 
         auto positionDelta = moveToPosition - getPosition();
         auto moveBy = CustomMoveBy::create(moveToDuration, positionDelta);
+        _moveVelocity = moveToDuration > 0.0f ? positionDelta / moveToDuration : Vec2::ZERO;
 
         CallFunc* onMoveEndEvent = nullptr;
         if (_gotoTargetPositionPathList.empty())
@@ -1383,6 +1727,7 @@ void Npc::onStand()
 
 void Npc::onAttack()
 {
+    cancelPathRequest();
     _gotoTargetPositionPathList.clear();
 
     stopAllActions();
@@ -1400,7 +1745,10 @@ void Npc::onDie()
 
     _selectedTips->setVisible(false);
 
+    cancelPathRequest();
     _gotoTargetPositionPathList.clear();
+    _gameWorld->_removePathPlanner(_uniqueID);
+    _gameWorld->_releasePathReservations(_uniqueID);
 
     auto shadowPosition = _shadowSprite->getPosition();
     shadowPosition.x = _dieAnimationFrameSize.width / 2.0f;
@@ -1442,14 +1790,6 @@ void Npc::onPrepareToRemove()
     tryUpdateStatus(NpcStatus::Die);
 }
 
-list<Vec2> Npc::getPathListTo(const Vec2& inMapEndPosition)
-{
-    auto inMapStartPosition = getPosition();
-    list<Vec2> pathList = _gameWorld->_computePathList(inMapStartPosition, inMapEndPosition, false);
-
-    return pathList;
-}
-
 const Vec2& Npc::getPosition() const
 {
     if (_gameObjectType == GameObjectType::DefenceInBuildingNpc)
@@ -1474,6 +1814,8 @@ void Npc::initDefenceInBuildingNpcInMapPosition()
 
     auto mapManger = GameWorldCallBackFunctionsManager::getInstance()->_getMapManager();
     _inMapPosition = mapManger->convertToTileMapSpace(worldPosition);
+
+    GameObjectManager::getInstance()->updateSpatialIndexOf(this);
 }
 
 void Npc::setAlertRange(float alertRange)
@@ -30,10 +30,13 @@ struct MopUpCommand
 {
     bool isExecuting = false;
     Vec2 finalPosition;
+    vector<Vec2> finalPositionList;    // 目标是建筑物时为所有占地格子的位置，到达任意一个即可，不为空时代替finalPosition
 };
 
 const float HANDLE_ENEMY_IN_ALERT_RANGE_SITUATION_TIME_INTERVAL = 1.0f;
 const float SEARCH_ENEMY_COOL_DOWN_TIME_INTERVAL = 1.0f;
+const int SEARCH_ENEMY_CANDIDATE_COUNT = 4;         // 第一次查询的候选数量，都不能攻击时加倍重新查询
+const float CHASE_TARGET_MOVE_TOLERANCE = 64.0f;   // 追击的npc离提交寻路请求时的位置不超过这个距离时，继续等待原来的请求
 
 class GameWorldCallBackFunctionsManager;
 class Building;
@@ -45,8 +48,14 @@ public:
 
     static Npc* create(ForceType forceType, GameObjectType npcType, const string& templateName, const Vec2& position, int uniqueID, int level);
 
-    void moveTo(const Vec2& targetPosition, bool isAllowEndTileNodeToMoveIn = false); // һtrueһڵϰҲǿȥѰ··
+    void moveTo(const Vec2& targetPosition, bool isAllowEndTileNodeToMoveIn = false); // 如果最后一个参数是true，即便是最后一个节点是障碍物，也是可以去计算寻路路径的
+    void moveAlongFlowFieldTo(const Vec2& flowFieldTargetPosition, const Vec2& targetPosition, bool isAllowEndTileNodeToMoveIn = false); // 多个npc前往同一地点时共用一个流场
+    void moveToNearest(const vector<Vec2>& targetPositionList, bool isAllowEndTileNodeToMoveIn = false); // 走到targetPositionList中代价最小的一个位置，比如建筑物的占地格子
+    void moveAlongFlowFieldToNearest(const vector<Vec2>& targetPositionList, bool isAllowEndTileNodeToMoveIn = false);
+    bool moveAlongBuildingRouteTo(int buildingUniqueID); // 从另一个建筑物附近出发时查建筑物之间的路线表，没有可用的路线时返回false
     void setReadyToMoveStatus(bool isReadyToMove);
+    bool isReadyToMove();
+    float getPerSecondMoveSpeedByPixel();
 
     NpcStatus getNpcStatus();
 
@@ -67,6 +76,17 @@ public:
     bool canAirAttack();
 
     void setEnemyUniqueID(int uniqueID) override;
+
+    // 碰撞由GameObjectManager::npcCollisionTest每帧统一检测，每一对重叠的npc分别交给双方按自己的朝向判断，
+    // 全部检测完以后再一起移动
+    bool isCollisionTestEnabled();
+    void addCollisionWith(GameObject* gameObject, float realDistance, float constraintDistance);
+    void resolveCollision();
+
+    // 局部避让由GameObjectManager::updateLocalAvoidance每帧统一求解，动作仍然沿着路径移动，这里只叠加速度的差值
+    Vec2 computePreferredVelocity();
+    const Vec2& getAvoidanceVelocity();
+    void applyAvoidanceVelocity(const Vec2& newVelocity, float deltaTime);
 private:
     bool init(ForceType forceType, GameObjectType npcType, const string& templateName, const Vec2& position, int uniqueID, int level);
     void clear();
@@ -87,7 +107,7 @@ private:
     void debugDraw() override;
     void onPrepareToRemove() override;
 
-    void collisionTest();
+    Vec2 computeFaceDirectionVector();
     void runFightWithEnemyAI(float delta);
     void runDefenceInBuildingAI(float delta);
 
@@ -102,8 +122,22 @@ private:
     void updateStatusWhenEnemyLeaveAlertRange();
     void reinforceOwnSide(GameObject* gameObject);
     void tryChase(GameObject* enemy);
+    bool isChasePathRequestPending(GameObject* enemy, const Vec2& arrivePosition);
+
+    // 追击敌人时chasingEnemyUniqueID是追击的目标，找不到路径时禁止接近的是它
+    void requestPathListTo(const Vec2& targetPosition, bool isAllowEndTileNodeToMoveIn, int chasingEnemyUniqueID = ENEMY_UNIQUE_ID_INVALID);
+    void requestPathListToNearest(const vector<Vec2>& targetPositionList, bool isAllowEndTileNodeToMoveIn, int chasingEnemyUniqueID = ENEMY_UNIQUE_ID_INVALID);
+    void updatePathRequest();
+    void joinRequestedPathList();
+    void cancelPathRequest();
+    void repairPathListIfBlocked();
+    void onPathListAssigned(bool isAllowEndTileNodeToMoveIn);
+
+    void moveToMopUpFinalPosition();
+    bool isMopUpFinalPosition(const Vec2& position);
 
     Vec2 computeArrivePositionBy(GameObject* enemy);
+    bool isArrivePositionOf(GameObject* enemy, const Vec2& position);
     float getDistanceFrom(GameObject* enemy);
     float _handleEnemyInAlertRangeSituationCoolDownTime = HANDLE_ENEMY_IN_ALERT_RANGE_SITUATION_TIME_INTERVAL;
     float _searchEnemyCoolDownTime = SEARCH_ENEMY_COOL_DOWN_TIME_INTERVAL;
@@ -169,9 +203,20 @@ private:
     float getMoveToDuration(const Vec2& moveToPosition);
     float _perSecondMoveSpeedByPixel = 100.0f;
 
-    list<Vec2> getPathListTo(const Vec2& inMapEndPosition);
     list<Vec2> _gotoTargetPositionPathList;
 
+    // 寻路在工作线程中进行，结果返回之前npc保持原来的行为
+    int _pathRequestID = 0;
+    bool _isWaitingForPathList = false;
+    int _pathRequestEnemyUniqueID = ENEMY_UNIQUE_ID_INVALID;
+    bool _isPathRequestAllowEndTileNodeToMoveIn = false;
+    Vec2 _pathRequestStartPosition;     // 结果从这个位置出发，npc在等待期间可能已经离开了
+    vector<Vec2> _pathRequestTargetPositionList;
+
+    // 地图变化后只检查当前路径是否被挡住，被挡住时才增量修复
+    int _pathNavigationVersion = 0;
+    bool _isPathAllowEndTileNodeToMoveIn = false;
+
     void updateLevelRepresentTexture(const string& spriteFrameName) override;
     Sprite* _levelRepresentTexture = nullptr;
 
@@ -194,7 +239,15 @@ private:
 
     float _maxAttackRangeWhenCollision = 0.0f;
 
-    MopUpCommand _mopUpCommand; // ɨָAȥĹ
+    int _collisionCount = 0;
+    float _collisionSumDifference = 0.0f;
+    Vec2 _collisionSumVector;
+    int _collisionAttackTargetUniqueID = GAME_OBJECT_UNIQUE_ID_INVALID;
+
+    Vec2 _moveVelocity;         // 当前这一段路径的速度
+    Vec2 _avoidanceVelocity;    // 上一帧避让以后的实际速度
+
+    MopUpCommand _mopUpCommand; // 扫荡指令，即A过去的功能
 
     bool _isAir = false;
     bool _canAirAttack = false;
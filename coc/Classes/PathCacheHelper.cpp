@@ -0,0 +1,148 @@
+#include "Base.h"
+#include "MapManager.h"
+#include "PathCacheHelper.h"
+
+struct CachedPath
+{
+    long long key = 0;
+    list<TileNode*> pathList;
+};
+
+typedef list<CachedPath> CachedPathList;   // 越靠前的路径越近被使用过
+
+static int g_maxRowCount = 0;
+static int g_tileNodeCount = 0;
+
+static CachedPathList g_cachedPathList;
+static unordered_map<long long, CachedPathList::iterator> g_cachedPathMap;
+static vector<bool> g_isTileNodeChangedList;
+
+static int g_hitCount = 0;
+static int g_missCount = 0;
+static int g_evictedCount = 0;
+
+void PathCacheHelper::initNavigationGrid(NavigationGrid& navigationGrid)
+{
+    g_maxRowCount = navigationGrid.rowCount;
+    g_tileNodeCount = navigationGrid.columnCount * g_maxRowCount;
+
+    g_cachedPathList.clear();
+    g_cachedPathMap.clear();
+    g_isTileNodeChangedList.assign(g_tileNodeCount, false);
+
+    g_hitCount = 0;
+    g_missCount = 0;
+    g_evictedCount = 0;
+}
+
+bool PathCacheHelper::findPathList(TileNode* startNode, TileNode* endNode, bool isEndTileNodePassableOverride, list<TileNode*>& pathList)
+{
+    bool result = false;
+
+    auto cachedPathIter = g_cachedPathMap.find(computeKey(startNode, endNode, isEndTileNodePassableOverride));
+    if (cachedPathIter != g_cachedPathMap.end())
+    {
+        g_cachedPathList.splice(g_cachedPathList.begin(), g_cachedPathList, cachedPathIter->second);
+        pathList = cachedPathIter->second->pathList;
+
+        g_hitCount++;
+        result = true;
+    }
+    else
+    {
+        g_missCount++;
+    }
+
+    return result;
+}
+
+void PathCacheHelper::addPathList(TileNode* startNode, TileNode* endNode, bool isEndTileNodePassableOverride, const list<TileNode*>& pathList)
+{
+    auto key = computeKey(startNode, endNode, isEndTileNodePassableOverride);
+    if (g_cachedPathMap.find(key) != g_cachedPathMap.end())
+    {
+        return;
+    }
+
+    if ((int)g_cachedPathList.size() >= MAX_PATH_CACHE_COUNT)
+    {
+        removeLeastRecentlyUsedPath();
+    }
+
+    CachedPath cachedPath;
+    cachedPath.key = key;
+    cachedPath.pathList = pathList;
+    g_cachedPathList.push_front(cachedPath);
+    g_cachedPathMap[key] = g_cachedPathList.begin();
+}
+
+void PathCacheHelper::onTileNodesGIDChanged(const vector<TileNode*>& tileNodeList)
+{
+    // 格子变成可通行时，原来不可达的起点终点可能变得可达，因此空路径也要淘汰；
+    // 没有经过这些格子的路径仍然可以走通，继续保留
+    bool hasTileNodeBecomePassable = false;
+    for (auto tileNode : tileNodeList)
+    {
+        g_isTileNodeChangedList[tileNode->columnIndex * g_maxRowCount + tileNode->rowIndex] = true;
+        if (tileNode->gid != OBSTACLE_ID)
+        {
+            hasTileNodeBecomePassable = true;
+        }
+    }
+
+    auto cachedPathIter = g_cachedPathList.begin();
+    while (cachedPathIter != g_cachedPathList.end())
+    {
+        auto& pathList = cachedPathIter->pathList;
+        bool shouldEvict = pathList.empty() && hasTileNodeBecomePassable;
+        for (auto tileNodeIter = pathList.begin(); !shouldEvict && tileNodeIter != pathList.end(); ++tileNodeIter)
+        {
+            shouldEvict = g_isTileNodeChangedList[(*tileNodeIter)->columnIndex * g_maxRowCount + (*tileNodeIter)->rowIndex];
+        }
+
+        if (shouldEvict)
+        {
+            g_cachedPathMap.erase(cachedPathIter->key);
+            cachedPathIter = g_cachedPathList.erase(cachedPathIter);
+            g_evictedCount++;
+        }
+        else
+        {
+            ++cachedPathIter;
+        }
+    }
+
+    for (auto tileNode : tileNodeList)
+    {
+        g_isTileNodeChangedList[tileNode->columnIndex * g_maxRowCount + tileNode->rowIndex] = false;
+    }
+}
+
+int PathCacheHelper::getHitCount()
+{
+    return g_hitCount;
+}
+
+int PathCacheHelper::getMissCount()
+{
+    return g_missCount;
+}
+
+int PathCacheHelper::getEvictedCount()
+{
+    return g_evictedCount;
+}
+
+long long PathCacheHelper::computeKey(TileNode* startNode, TileNode* endNode, bool isEndTileNodePassableOverride)
+{
+    long long startTileIndex = startNode->columnIndex * g_maxRowCount + startNode->rowIndex;
+    long long endTileIndex = endNode->columnIndex * g_maxRowCount + endNode->rowIndex;
+
+    return (startTileIndex * g_tileNodeCount + endTileIndex) * 2 + (isEndTileNodePassableOverride ? 1 : 0);
+}
+
+void PathCacheHelper::removeLeastRecentlyUsedPath()
+{
+    g_cachedPathMap.erase(g_cachedPathList.back().key);
+    g_cachedPathList.pop_back();
+}
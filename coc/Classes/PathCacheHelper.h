@@ -0,0 +1,26 @@
+#pragma once
+
+const int MAX_PATH_CACHE_COUNT = 256;
+
+// 缓存格子路径，格子的通行状态改变时只淘汰经过这些格子的路径
+class PathCacheHelper
+{
+public:
+    static void initNavigationGrid(NavigationGrid& navigationGrid);
+
+    static bool findPathList(TileNode* startNode, TileNode* endNode, bool isEndTileNodePassableOverride, list<TileNode*>& pathList);
+    static void addPathList(TileNode* startNode, TileNode* endNode, bool isEndTileNodePassableOverride, const list<TileNode*>& pathList);
+
+    static void onTileNodesGIDChanged(const vector<TileNode*>& tileNodeList);
+
+    static int getHitCount();
+    static int getMissCount();
+    static int getEvictedCount();
+
+private:
+    static long long computeKey(TileNode* startNode, TileNode* endNode, bool isEndTileNodePassableOverride);
+    static void removeLeastRecentlyUsedPath();
+
+    PathCacheHelper();
+    ~PathCacheHelper();
+};
@@ -0,0 +1,524 @@
+#include "Base.h"
+#include "MapManager.h"
+#include "AutoFindPathHelper.h"
+#include "LandmarkHelper.h"
+#include "PathRequestService.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <deque>
+#include <unordered_map>
+
+typedef std::shared_ptr<const vector<bool>> PassableList;
+typedef std::shared_ptr<const LandmarkTableSet> LandmarkTableSetPtr;
+
+struct PathRequest
+{
+    TileNode* startNode = nullptr;
+    vector<TileNode*> endNodeList;     // 多个终点时找到达代价最小的那个
+    bool isEndTileNodePassable = false;
+    vector<TileNode*> waypointList;    // 不为空时逐段搜索，每一段的终点是下一个过渡点，最后一段的终点是endNodeList
+    int waypointIndex = 0;             // 正在搜索的那一段的终点在waypointList中的下标
+    bool isLegFinished = false;        // 上一段已经搜索完，下一次分段要开始新的一段
+    list<TileNode*> refinedPathList;   // 已经搜索完的路段，格式与pathList一致
+    PathSearchMode pathSearchMode = PathSearchMode::JumpPointSearch;
+    PassableList passableList;  // 提交请求时的通行数据快照，工作线程只读快照，不读格子的gid
+    LandmarkTableSetPtr landmarkTableSet;  // 与passableList同时取得，两者对应同一份格子状态
+
+    // 开始搜索以后才分配上下文，搜索结束或者请求取消时归还
+    PathSearchContext* searchContext = nullptr;
+    bool isInWorkerThread = false;
+
+    bool isFinished = false;
+    list<TileNode*> pathList;
+};
+
+static int g_maxRowCount = 0;
+static NavigationGrid* g_navigationGrid = nullptr;
+static PassableList g_passableList;
+static LandmarkTableSetPtr g_landmarkTableSet;
+
+static unordered_map<int, PathRequest> g_requestMap;
+static deque<int> g_waitingRequestIDList;      // 还没有开始搜索的请求
+static deque<int> g_searchingRequestIDList;    // 搜索到一半、等待下一次分段的请求
+static vector<PathSearchContext*> g_freeSearchContextList;
+static int g_nextRequestID = 1;
+
+static unsigned int g_frameIndex = 0;
+static int g_remainingExpandedNodeCountInFrame = 0;
+static int g_expandedNodeCountInFrame = 0;
+static int g_lastFrameExpandedNodeCount = 0;
+
+// 搜索基于的快照过时以后，结果只要在最新的通行数据下仍然成立就可以直接使用，
+// 不必因为无关的地图变化重新搜索，否则地图频繁变化时耗时长的请求可能永远完成不了
+static bool isPathListStillValid(const PathRequest& request, const vector<bool>& passableList)
+{
+    bool result = true;
+
+    if (request.pathList.empty())
+    {
+        // 找不到路径的结论只有在没有格子变成可通行时才成立
+        auto& oldPassableList = *request.passableList;
+        for (int tileIndex = 0; result && tileIndex < (int)passableList.size(); tileIndex++)
+        {
+            result = oldPassableList[tileIndex] || !passableList[tileIndex];
+        }
+    }
+    else
+    {
+        for (auto tileNodeIter = request.pathList.begin(); result && tileNodeIter != request.pathList.end(); ++tileNodeIter)
+        {
+            // 路径的第一个格子就是到达的终点
+            if (tileNodeIter == request.pathList.begin() && request.isEndTileNodePassable)
+            {
+                continue;
+            }
+
+            result = passableList[(*tileNodeIter)->columnIndex * g_maxRowCount + (*tileNodeIter)->rowIndex];
+        }
+    }
+
+    return result;
+}
+
+static vector<std::thread> g_workerThreadList;
+static std::mutex g_requestMutex;
+static std::condition_variable g_requestCondition;
+static bool g_isStopping = false;
+
+void PathRequestService::initNavigationGrid(NavigationGrid& navigationGrid)
+{
+    clear();
+
+    g_navigationGrid = &navigationGrid;
+    g_maxRowCount = navigationGrid.rowCount;
+    g_passableList = std::make_shared<vector<bool>>(navigationGrid.passableList);
+    g_landmarkTableSet = LandmarkHelper::getLandmarkTableSet();
+
+    for (int contextIndex = 0; contextIndex < MAX_SEARCHING_REQUEST_COUNT; contextIndex++)
+    {
+        g_freeSearchContextList.push_back(AutoFindPathHelper::createSearchContext());
+    }
+
+    g_remainingExpandedNodeCountInFrame = MAX_EXPANDED_NODE_COUNT_PER_FRAME;
+    g_expandedNodeCountInFrame = 0;
+    g_lastFrameExpandedNodeCount = 0;
+
+    startWorkerThreads();
+}
+
+void PathRequestService::clear()
+{
+    std::unique_lock<std::mutex> lock(g_requestMutex);
+    g_isStopping = true;
+    lock.unlock();
+    g_requestCondition.notify_all();
+
+    for (auto& workerThread : g_workerThreadList)
+    {
+        workerThread.join();
+    }
+    g_workerThreadList.clear();
+
+    g_isStopping = false;
+
+    for (auto& requestIter : g_requestMap)
+    {
+        if (requestIter.second.searchContext)
+        {
+            g_freeSearchContextList.push_back(requestIter.second.searchContext);
+        }
+    }
+    for (auto searchContext : g_freeSearchContextList)
+    {
+        AutoFindPathHelper::destroySearchContext(searchContext);
+    }
+    g_freeSearchContextList.clear();
+
+    g_requestMap.clear();
+    g_waitingRequestIDList.clear();
+    g_searchingRequestIDList.clear();
+    g_passableList.reset();
+    g_landmarkTableSet.reset();
+}
+
+void PathRequestService::update()
+{
+    // 格子变化以后路标距离表是逐帧重新计算的，计算好的部分从下一个开始搜索的请求起生效
+    auto landmarkTableSet = LandmarkHelper::getLandmarkTableSet();
+
+    std::unique_lock<std::mutex> lock(g_requestMutex);
+    g_landmarkTableSet = landmarkTableSet;
+    g_frameIndex++;
+    g_lastFrameExpandedNodeCount = g_expandedNodeCountInFrame;
+    g_expandedNodeCountInFrame = 0;
+    g_remainingExpandedNodeCountInFrame = MAX_EXPANDED_NODE_COUNT_PER_FRAME;
+    lock.unlock();
+
+    g_requestCondition.notify_all();
+}
+
+int PathRequestService::requestTileNodePathList(TileNode* startNode, TileNode* endNode, bool isEndTileNodePassable)
+{
+    return requestTileNodePathListToNearest(startNode, vector<TileNode*>(1, endNode), isEndTileNodePassable);
+}
+
+int PathRequestService::requestTileNodePathListToNearest(TileNode* startNode, const vector<TileNode*>& endNodeList, bool isEndTileNodePassable)
+{
+    return requestTileNodePathListThrough(startNode, vector<TileNode*>(), endNodeList, isEndTileNodePassable);
+}
+
+int PathRequestService::requestTileNodePathListThrough(TileNode* startNode, const vector<TileNode*>& waypointList, const vector<TileNode*>& endNodeList,
+    bool isEndTileNodePassable)
+{
+    int requestID = g_nextRequestID++;
+
+    PathRequest request;
+    request.startNode = startNode;
+    request.waypointList = waypointList;
+    request.isEndTileNodePassable = isEndTileNodePassable;
+    request.pathSearchMode = AutoFindPathHelper::getPathSearchMode();
+    request.passableList = g_passableList;
+
+    // 不允许进入的障碍格不可能到达，不作为终点
+    for (auto endNode : endNodeList)
+    {
+        if (endNode->gid != OBSTACLE_ID || isEndTileNodePassable)
+        {
+            request.endNodeList.push_back(endNode);
+        }
+    }
+
+    // 不需要搜索就能得出结果的请求直接完成
+    if (std::find(request.endNodeList.begin(), request.endNodeList.end(), startNode) != request.endNodeList.end())
+    {
+        request.pathList.push_back(startNode);
+        request.isFinished = true;
+    }
+    else if (request.endNodeList.empty())
+    {
+        request.isFinished = true;
+    }
+
+    std::lock_guard<std::mutex> lock(g_requestMutex);
+    g_requestMap[requestID] = request;
+    if (!request.isFinished)
+    {
+        g_waitingRequestIDList.push_back(requestID);
+        g_requestCondition.notify_one();
+    }
+
+    return requestID;
+}
+
+int PathRequestService::addFinishedRequest(TileNode* startNode, const vector<TileNode*>& endNodeList, bool isEndTileNodePassable, const list<TileNode*>& pathList)
+{
+    int requestID = g_nextRequestID++;
+
+    PathRequest request;
+    request.startNode = startNode;
+    request.endNodeList = endNodeList;
+    request.isEndTileNodePassable = isEndTileNodePassable;
+    request.pathSearchMode = AutoFindPathHelper::getPathSearchMode();
+    request.passableList = g_passableList;
+    request.pathList = pathList;
+    request.isFinished = true;
+
+    std::lock_guard<std::mutex> lock(g_requestMutex);
+    g_requestMap[requestID] = request;
+
+    return requestID;
+}
+
+bool PathRequestService::tryGetTileNodePathList(int requestID, list<TileNode*>& pathList)
+{
+    bool result = false;
+
+    std::lock_guard<std::mutex> lock(g_requestMutex);
+    auto requestIter = g_requestMap.find(requestID);
+    if (requestIter == g_requestMap.end())
+    {
+        // 请求已经被取消或者地图已经切换，当作找不到路径
+        pathList.clear();
+        result = true;
+    }
+    else if (requestIter->second.isFinished)
+    {
+        auto& request = requestIter->second;
+        // 没有起点或者终点的请求不能搜索，不放回等待队列，否则工作线程会从空的起点开始搜索
+        bool isSearchable = request.startNode && !request.endNodeList.empty();
+        if (!isSearchable || request.passableList == g_passableList || isPathListStillValid(request, *g_passableList))
+        {
+            pathList.swap(request.pathList);
+            g_requestMap.erase(requestIter);
+            result = true;
+        }
+        else
+        {
+            // 寻路期间地图发生的变化让结果失效了，按照最新的通行数据重新寻路，过渡点是按照旧的地图找的，不再使用
+            request.passableList = g_passableList;
+            request.pathList.clear();
+            request.waypointList.clear();
+            request.waypointIndex = 0;
+            request.isFinished = false;
+            g_waitingRequestIDList.push_back(requestID);
+            g_requestCondition.notify_one();
+        }
+    }
+
+    return result;
+}
+
+void PathRequestService::cancelRequest(int requestID)
+{
+    // 正在工作线程中执行的分段会继续算完，由工作线程归还上下文并丢弃结果
+    std::lock_guard<std::mutex> lock(g_requestMutex);
+    auto requestIter = g_requestMap.find(requestID);
+    if (requestIter != g_requestMap.end())
+    {
+        auto& request = requestIter->second;
+        if (request.searchContext && !request.isInWorkerThread)
+        {
+            releaseSearchContext(request.searchContext);
+        }
+        g_requestMap.erase(requestIter);
+    }
+}
+
+void PathRequestService::onTileNodesGIDChanged(const vector<TileNode*>& tileNodeList)
+{
+    // 正在使用的快照可能还在被工作线程读取，因此复制一份新的快照，旧快照在不再被引用时自动释放
+    auto passableList = std::make_shared<vector<bool>>(g_navigationGrid->passableList);
+    auto landmarkTableSet = LandmarkHelper::getLandmarkTableSet();
+
+    std::lock_guard<std::mutex> lock(g_requestMutex);
+    g_passableList = passableList;
+    g_landmarkTableSet = landmarkTableSet;
+}
+
+int PathRequestService::getPendingRequestCount()
+{
+    std::lock_guard<std::mutex> lock(g_requestMutex);
+    return (int)g_requestMap.size();
+}
+
+int PathRequestService::getWaitingRequestCount()
+{
+    int waitingRequestCount = 0;
+
+    std::lock_guard<std::mutex> lock(g_requestMutex);
+    for (auto& requestIter : g_requestMap)
+    {
+        if (!requestIter.second.isFinished && !requestIter.second.searchContext)
+        {
+            waitingRequestCount++;
+        }
+    }
+
+    return waitingRequestCount;
+}
+
+int PathRequestService::getSearchingRequestCount()
+{
+    int searchingRequestCount = 0;
+
+    std::lock_guard<std::mutex> lock(g_requestMutex);
+    for (auto& requestIter : g_requestMap)
+    {
+        if (requestIter.second.searchContext)
+        {
+            searchingRequestCount++;
+        }
+    }
+
+    return searchingRequestCount;
+}
+
+int PathRequestService::getLastFrameExpandedNodeCount()
+{
+    std::lock_guard<std::mutex> lock(g_requestMutex);
+    return g_lastFrameExpandedNodeCount;
+}
+
+void PathRequestService::startWorkerThreads()
+{
+    int workerThreadCount = (int)std::thread::hardware_concurrency() - 1;
+    workerThreadCount = std::max(1, std::min(workerThreadCount, MAX_PATH_WORKER_THREAD_COUNT));
+
+    for (int threadIndex = 0; threadIndex < workerThreadCount; threadIndex++)
+    {
+        g_workerThreadList.push_back(std::thread(&PathRequestService::runWorkerThread));
+    }
+}
+
+void PathRequestService::runWorkerThread()
+{
+    std::unique_lock<std::mutex> lock(g_requestMutex);
+    while (true)
+    {
+        int requestID = 0;
+        while (!g_isStopping && (requestID = takeNextRequestID()) == 0)
+        {
+            g_requestCondition.wait(lock);
+        }
+
+        if (g_isStopping)
+        {
+            break;
+        }
+
+        auto requestIter = g_requestMap.find(requestID);
+        if (requestIter == g_requestMap.end() || requestIter->second.isFinished)
+        {
+            continue;
+        }
+
+        auto& request = requestIter->second;
+        // 分配到上下文时才开始搜索，之后的分段一直使用开始时的快照，结果在取回时再检查
+        bool shouldBeginSearch = request.isLegFinished;
+        if (!request.searchContext)
+        {
+            request.searchContext = g_freeSearchContextList.back();
+            g_freeSearchContextList.pop_back();
+            request.passableList = g_passableList;
+            request.landmarkTableSet = g_landmarkTableSet;
+            shouldBeginSearch = true;
+        }
+        request.isInWorkerThread = true;
+        request.isLegFinished = false;
+
+        // 先按分段的上限记入本帧，分段结束后再退还没用完的部分
+        unsigned int sliceFrameIndex = g_frameIndex;
+        int sliceExpandedNodeCount = std::min(MAX_EXPANDED_NODE_COUNT_PER_SLICE, g_remainingExpandedNodeCountInFrame);
+        g_remainingExpandedNodeCountInFrame -= sliceExpandedNodeCount;
+        g_expandedNodeCountInFrame += sliceExpandedNodeCount;
+
+        auto searchContext = request.searchContext;
+        auto passableList = request.passableList;
+        auto landmarkTableSet = request.landmarkTableSet;
+        auto startNode = request.startNode;
+        bool isEndTileNodePassable = request.isEndTileNodePassable;
+        auto pathSearchMode = request.pathSearchMode;
+        bool isLastLeg = request.waypointIndex == (int)request.waypointList.size();
+
+        // 终点只在开始搜索时用到，之后不再复制；中间的路段从上一个过渡点走到下一个过渡点
+        vector<TileNode*> endNodeList;
+        if (shouldBeginSearch)
+        {
+            if (request.waypointIndex > 0)
+            {
+                startNode = request.waypointList[request.waypointIndex - 1];
+            }
+
+            if (isLastLeg)
+            {
+                endNodeList = request.endNodeList;
+            }
+            else
+            {
+                endNodeList.push_back(request.waypointList[request.waypointIndex]);
+                isEndTileNodePassable = false;
+            }
+        }
+        lock.unlock();
+
+        if (shouldBeginSearch)
+        {
+            AutoFindPathHelper::beginTileNodePathSearch(searchContext, startNode, endNodeList, isEndTileNodePassable, *passableList,
+                landmarkTableSet.get(), pathSearchMode);
+        }
+
+        list<TileNode*> pathList;
+        int oldExpandedNodeCount = AutoFindPathHelper::getExpandedNodeCount(searchContext);
+        auto searchStatus = AutoFindPathHelper::continueTileNodePathSearch(searchContext, sliceExpandedNodeCount, pathList);
+        int expandedNodeCount = AutoFindPathHelper::getExpandedNodeCount(searchContext) - oldExpandedNodeCount;
+
+        lock.lock();
+
+        if (sliceFrameIndex == g_frameIndex)
+        {
+            g_remainingExpandedNodeCountInFrame += sliceExpandedNodeCount - expandedNodeCount;
+            g_expandedNodeCountInFrame -= sliceExpandedNodeCount - expandedNodeCount;
+        }
+
+        requestIter = g_requestMap.find(requestID);
+        if (requestIter == g_requestMap.end())
+        {
+            // 分段执行期间请求被取消了
+            releaseSearchContext(searchContext);
+        }
+        else if (searchStatus == PathSearchStatus::Searching)
+        {
+            requestIter->second.isInWorkerThread = false;
+            g_searchingRequestIDList.push_back(requestID);
+        }
+        else if (!isLastLeg)
+        {
+            auto& legRequest = requestIter->second;
+            if (searchStatus == PathSearchStatus::Found)
+            {
+                // 这一段的起点已经在前面的路段中了
+                if (!legRequest.refinedPathList.empty())
+                {
+                    pathList.pop_back();
+                }
+                legRequest.refinedPathList.splice(legRequest.refinedPathList.begin(), pathList);
+                legRequest.waypointIndex++;
+            }
+            else
+            {
+                // 过渡点与快照不一致，放弃过渡点，从起点直接搜索
+                legRequest.waypointList.clear();
+                legRequest.waypointIndex = 0;
+                legRequest.refinedPathList.clear();
+            }
+            legRequest.isLegFinished = true;
+            legRequest.isInWorkerThread = false;
+            g_searchingRequestIDList.push_back(requestID);
+        }
+        else
+        {
+            auto& finishedRequest = requestIter->second;
+            if (!pathList.empty() && !finishedRequest.refinedPathList.empty())
+            {
+                pathList.pop_back();
+                pathList.splice(pathList.end(), finishedRequest.refinedPathList);
+            }
+            finishedRequest.refinedPathList.clear();
+            finishedRequest.pathList.swap(pathList);
+            finishedRequest.isFinished = true;
+            finishedRequest.isInWorkerThread = false;
+            finishedRequest.searchContext = nullptr;
+            releaseSearchContext(searchContext);
+        }
+    }
+}
+
+int PathRequestService::takeNextRequestID()
+{
+    int requestID = 0;
+
+    // 本帧预算用完以后等到下一帧再继续；有空闲上下文时优先开始新请求，短路径通常一个分段就能找到
+    if (g_remainingExpandedNodeCountInFrame > 0)
+    {
+        if (!g_waitingRequestIDList.empty() && !g_freeSearchContextList.empty())
+        {
+            requestID = g_waitingRequestIDList.front();
+            g_waitingRequestIDList.pop_front();
+        }
+        else if (!g_searchingRequestIDList.empty())
+        {
+            requestID = g_searchingRequestIDList.front();
+            g_searchingRequestIDList.pop_front();
+        }
+    }
+
+    return requestID;
+}
+
+void PathRequestService::releaseSearchContext(PathSearchContext* searchContext)
+{
+    g_freeSearchContextList.push_back(searchContext);
+    g_requestCondition.notify_one();
+}
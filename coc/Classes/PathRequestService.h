@@ -0,0 +1,49 @@
+#pragma once
+
+struct PathSearchContext;
+
+const int MAX_PATH_WORKER_THREAD_COUNT = 2;
+const int MAX_EXPANDED_NODE_COUNT_PER_FRAME = 4000;    // 所有寻路请求每帧共用的节点扩展预算
+const int MAX_EXPANDED_NODE_COUNT_PER_SLICE = 500;     // 一个请求连续扩展的节点数，用完就轮到下一个请求
+const int MAX_SEARCHING_REQUEST_COUNT = 8;             // 同时处于搜索中的请求数，每个请求占用一份寻路上下文
+
+// 在工作线程中分段寻路，请求方在之后的帧里取回结果，寻路耗时再长也不会卡住渲染线程
+// 每个请求每次只扩展一小段节点就让给其他请求，找不到路径的请求不会拖住其他请求
+// 除了工作线程内部，所有接口都只能在主线程中调用
+class PathRequestService
+{
+public:
+    static void initNavigationGrid(NavigationGrid& navigationGrid);
+    static void clear();   // 等待所有工作线程退出，格子被释放之前必须调用
+    static void update();  // 每帧调用一次，重新发放节点扩展预算
+
+    // isEndTileNodePassable为true时，即便终点是障碍物也可以走进去
+    static int requestTileNodePathList(TileNode* startNode, TileNode* endNode, bool isEndTileNodePassable);
+    // 到达endNodeList中任意一个格子即可，结果是到达代价最小的那个终点的路径
+    static int requestTileNodePathListToNearest(TileNode* startNode, const vector<TileNode*>& endNodeList, bool isEndTileNodePassable);
+    // waypointList是抽象图上依次经过的过渡点，工作线程逐段细化后连成一条路径；某一段细化失败时退回到从起点直接搜索
+    static int requestTileNodePathListThrough(TileNode* startNode, const vector<TileNode*>& waypointList, const vector<TileNode*>& endNodeList,
+        bool isEndTileNodePassable);
+    // 请求方已经知道结果时使用，不经过工作线程，取回方式与普通请求一致；
+    // 取回之前通行数据变化让结果失效时按照startNode和endNodeList重新搜索，startNode为nullptr或者没有终点时结果原样取回，由请求方自己检查
+    static int addFinishedRequest(TileNode* startNode, const vector<TileNode*>& endNodeList, bool isEndTileNodePassable, const list<TileNode*>& pathList);
+    // 寻路完成时返回true并取走结果，返回的路径格式与AutoFindPathHelper一致，之后这个请求就失效了
+    static bool tryGetTileNodePathList(int requestID, list<TileNode*>& pathList);
+    static void cancelRequest(int requestID);
+
+    static void onTileNodesGIDChanged(const vector<TileNode*>& tileNodeList);
+
+    static int getPendingRequestCount();
+    static int getWaitingRequestCount();
+    static int getSearchingRequestCount();
+    static int getLastFrameExpandedNodeCount();
+
+private:
+    static void startWorkerThreads();
+    static void runWorkerThread();
+    static int takeNextRequestID();
+    static void releaseSearchContext(PathSearchContext* searchContext);
+
+    PathRequestService();
+    ~PathRequestService();
+};
@@ -0,0 +1,107 @@
+#include "Base.h"
+#include "MapManager.h"
+#include "PathSmoothHelper.h"
+
+static NavigationGrid* g_navigationGrid = nullptr;
+
+static int getDirection(int delta)
+{
+    return (delta > 0) - (delta < 0);
+}
+
+void PathSmoothHelper::initNavigationGrid(NavigationGrid& navigationGrid)
+{
+    g_navigationGrid = &navigationGrid;
+}
+
+list<TileNode*> PathSmoothHelper::smoothTileNodePathList(const list<TileNode*>& pathList, bool isEndTileNodePassable)
+{
+    if (pathList.size() <= 2)
+    {
+        return pathList;
+    }
+
+    // 路径从终点排到起点，因此从终点往回拉直，终点格子作为视线的起点
+    list<TileNode*> smoothPathList;
+    smoothPathList.push_back(pathList.front());
+
+    auto anchorNode = pathList.front();
+    auto previousNode = pathList.front();
+    bool isAnchorEndNode = true;
+    for (auto tileNodeIter = ++pathList.begin(); tileNodeIter != pathList.end(); ++tileNodeIter)
+    {
+        if (!hasLineOfSight(*tileNodeIter, anchorNode, isAnchorEndNode && isEndTileNodePassable))
+        {
+            smoothPathList.push_back(previousNode);
+            anchorNode = previousNode;
+            isAnchorEndNode = false;
+        }
+
+        previousNode = *tileNodeIter;
+    }
+    smoothPathList.push_back(pathList.back());
+
+    return smoothPathList;
+}
+
+bool PathSmoothHelper::hasLineOfSight(TileNode* startNode, TileNode* endNode, bool isEndTileNodePassable)
+{
+    bool result = true;
+
+    // 在格子坐标系中从起点格子中心到终点格子中心画线，依次检查经过的格子
+    int columnDistance = std::abs(endNode->columnIndex - startNode->columnIndex);
+    int rowDistance = std::abs(endNode->rowIndex - startNode->rowIndex);
+    int columnDirection = getDirection(endNode->columnIndex - startNode->columnIndex);
+    int rowDirection = getDirection(endNode->rowIndex - startNode->rowIndex);
+
+    int columnIndex = startNode->columnIndex;
+    int rowIndex = startNode->rowIndex;
+    int error = columnDistance - rowDistance;
+    int remainStepCount = columnDistance + rowDistance;
+
+    // 相邻的格子按照寻路的规则处理，斜着走一步时只要求目标格子可以通行
+    if (columnDistance <= 1 && rowDistance <= 1)
+    {
+        remainStepCount = 0;
+        result = isPassable(endNode->columnIndex, endNode->rowIndex, startNode, endNode, isEndTileNodePassable);
+    }
+
+    while (result && remainStepCount > 0)
+    {
+        if (error > 0)
+        {
+            columnIndex += columnDirection;
+            error -= rowDistance * 2;
+            remainStepCount--;
+        }
+        else if (error < 0)
+        {
+            rowIndex += rowDirection;
+            error += columnDistance * 2;
+            remainStepCount--;
+        }
+        else
+        {
+            // 直线恰好经过格子的顶点，两侧的格子都要检查
+            result = isPassable(columnIndex + columnDirection, rowIndex, startNode, endNode, isEndTileNodePassable) &&
+                isPassable(columnIndex, rowIndex + rowDirection, startNode, endNode, isEndTileNodePassable);
+
+            columnIndex += columnDirection;
+            rowIndex += rowDirection;
+            error += (columnDistance - rowDistance) * 2;
+            remainStepCount -= 2;
+        }
+
+        result = result && isPassable(columnIndex, rowIndex, startNode, endNode, isEndTileNodePassable);
+    }
+
+    return result;
+}
+
+bool PathSmoothHelper::isPassable(int columnIndex, int rowIndex, TileNode* startNode, TileNode* endNode, bool isEndTileNodePassable)
+{
+    int tileIndex = columnIndex * g_navigationGrid->rowCount + rowIndex;
+    auto tileNode = &g_navigationGrid->tileNodeList[tileIndex];
+
+    return tileNode == startNode || (tileNode == endNode && isEndTileNodePassable) || g_navigationGrid->passableList[tileIndex];
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+// 把逐格的路径拉直，只保留拐点，npc沿着直线走过中间可以直接看到的格子
+// 视线检查会把直线经过的所有格子都算进去，斜线恰好经过格子顶点时两侧的格子都要可以通行，不会贴着障碍物的角穿过去
+class PathSmoothHelper
+{
+public:
+    static void initNavigationGrid(NavigationGrid& navigationGrid);
+
+    // 输入和输出的路径格式都与AutoFindPathHelper一致，起点和终点保持不变
+    static list<TileNode*> smoothTileNodePathList(const list<TileNode*>& pathList, bool isEndTileNodePassable);
+    // 起点所在的格子不检查，isEndTileNodePassable为true时也不检查终点所在的格子
+    static bool hasLineOfSight(TileNode* startNode, TileNode* endNode, bool isEndTileNodePassable);
+
+private:
+    static bool isPassable(int columnIndex, int rowIndex, TileNode* startNode, TileNode* endNode, bool isEndTileNodePassable);
+
+    PathSmoothHelper();
+    ~PathSmoothHelper();
+};
@@ -74,7 +74,7 @@ private:
     typedef string TypeName;
     unordered_map<TypeName, string> _uiSoundEffectNameMap;
 
-    float _effectVolume = 1.0f; // С0.0f~1.0f
+    float _effectVolume = 1.0f; // 音量大小，0.0f~1.0f
     float _musicVolume = 1.0f;
     int _musicAudioID = experimental::AudioEngine::INVALID_AUDIO_ID;
 
@@ -215,3 +215,19 @@ bool GameUtils::convertEncoding(const string& toCode, const string& fromCode, co
 
     return result;
 }
+
+double GameUtils::getMicroseconds()
+{
+    static double s_microsecondsPerTick = 0.0;
+    if (s_microsecondsPerTick == 0.0)
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        s_microsecondsPerTick = 1000000.0 / (double)frequency.QuadPart;
+    }
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart * s_microsecondsPerTick;
+}
@@ -9,4 +9,5 @@ namespace GameUtils
     Animation* createAnimationWithPList(const string& plistFileName);
     void pauseTargetAndChildren(Node* target);
     bool convertEncoding(const string& toCode, const string& fromCode, const string& fromCodeText, string& toCodeText);
+    double getMicroseconds();   // 高精度计时，只用于比较两个时间点之间的间隔
 }
\ No newline at end of file